@@ -1,4 +1,7 @@
-#include "crypt.h"
+#include "aes.h"
+
+#include "cbc_padding.h"
+#include "seeded_rng.h"
 
 #include <cryptopp/cryptlib.h>
 #include <cryptopp/secblock.h>
@@ -9,6 +12,8 @@
 #include <cryptopp/hex.h>
 
 #include <iostream>
+#include <optional>
+#include <span>
 #include <string>
 
 using namespace CryptoPP;
@@ -16,54 +21,87 @@ using namespace CryptoPP;
 // Global in-memory key and IV
 static SecByteBlock g_aesKey(24);              // 24 bytes = 192 bits
 static SecByteBlock g_aesIV(AES::BLOCKSIZE);   // 16 bytes
+static bool g_aesInited = false;
+static std::optional<uint64_t> g_aesKeySeed;   // see aes_set_key_seed
+
+bool aes_set_key_seed(uint64_t seed)
+{
+    if (g_aesInited) return false;
+    g_aesKeySeed = seed;
+    return true;
+}
 
 // Initialize key/IV once
 void init_aes_key()
 {
-    static bool inited = false;
-    if (inited) return;
-    AutoSeededRandomPool rng;
+    if (g_aesInited) return;
+
+    auto generate = [](RandomNumberGenerator& rng) {
+        // Generate a 192-bit key
+        rng.GenerateBlock(g_aesKey, g_aesKey.size());
+        // Generate an IV
+        rng.GenerateBlock(g_aesIV,   g_aesIV.size());
+    };
+    if (g_aesKeySeed) {
+        SeededRng rng;
+        seed_rng(rng, *g_aesKeySeed, 1);
+        generate(rng);
+    } else {
+        AutoSeededRandomPool rng;
+        generate(rng);
+    }
+
+    g_aesInited = true;
+}
 
-    // Generate a random 192-bit key
-    rng.GenerateBlock(g_aesKey, g_aesKey.size());
-    // Generate a random IV
-    rng.GenerateBlock(g_aesIV,   g_aesIV.size());
+std::size_t aes_encrypted_size(std::size_t plain_bytes)
+{
+    return cbc_padded_size(plain_bytes);
+}
 
-    inited = true;
+std::size_t aes_decrypted_size(std::size_t cipher_bytes)
+{
+    return cipher_bytes;
 }
 
 // AES-192 CBC encryption
-std::string aes_encrypt(const std::string& plaintext)
+std::optional<std::size_t> aes_encrypt_into(std::span<const std::byte> plaintext,
+                                            std::span<std::byte> out)
 {
     init_aes_key();
 
-    std::string ciphertext;
     CBC_Mode< AES >::Encryption enc;
     // Pass in the 192-bit key (24 bytes)
     enc.SetKeyWithIV(g_aesKey, g_aesKey.size(), g_aesIV);
-
-    StringSource ss(plaintext, true,
-        new StreamTransformationFilter(enc,
-            new StringSink(ciphertext)
-        ) // StreamTransformationFilter
-    ); // StringSource
-
-    return ciphertext;
+    return cbc_encrypt_padded(enc, plaintext, out);
 }
 
 // AES-192 CBC decryption
-std::string aes_decrypt(const std::string& ciphertext)
+std::optional<std::size_t> aes_decrypt_into(std::span<const std::byte> ciphertext,
+                                            std::span<std::byte> out)
 {
     init_aes_key();
 
-    std::string recovered;
     CBC_Mode< AES >::Decryption dec;
     dec.SetKeyWithIV(g_aesKey, g_aesKey.size(), g_aesIV);
+    return cbc_decrypt_padded(dec, ciphertext, out);
+}
 
-    StringSource ss(ciphertext, true,
-        new StreamTransformationFilter(dec,
-            new StringSink(recovered)
-        )
-    );
+std::string aes_encrypt(const std::string& plaintext)
+{
+    std::string ciphertext(aes_encrypted_size(plaintext.size()), '\0');
+    aes_encrypt_into(std::as_bytes(std::span(plaintext)),
+                     std::as_writable_bytes(std::span(ciphertext)));
+    return ciphertext;
+}
+
+std::string aes_decrypt(const std::string& ciphertext)
+{
+    std::string recovered(aes_decrypted_size(ciphertext.size()), '\0');
+    auto length = aes_decrypt_into(std::as_bytes(std::span(ciphertext)),
+                                   std::as_writable_bytes(std::span(recovered)));
+    // same failure the StreamTransformationFilter used to report
+    if (!length) throw InvalidCiphertext("aes_decrypt: invalid ciphertext or padding");
+    recovered.resize(*length);
     return recovered;
 }
@@ -1,11 +1,37 @@
-
 #ifndef CRYPT_H
 #define CRYPT_H
 
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
 #include <string>
 
+// Derives the key and IV from seed instead of drawing them at random, so
+// ciphertext stored by one process decrypts in another. Returns false if
+// the key was already generated, i.e. after the first encryption or
+// decryption.
+bool aes_set_key_seed(uint64_t seed);
+
 std::string aes_encrypt(const std::string& plaintext);
 
 std::string aes_decrypt(const std::string& ciphertext);
 
-#endif
\ No newline at end of file
+// Span API: reads the input in place and writes into a caller buffer, which
+// must hold at least aes_encrypted_size / aes_decrypted_size bytes.
+// Both return the bytes written, or std::nullopt when the buffer is too
+// small or (decryption) the ciphertext is malformed.
+
+// Exact ciphertext size of plain_bytes of plaintext.
+std::size_t aes_encrypted_size(std::size_t plain_bytes);
+
+// Upper bound of the plaintext size of cipher_bytes of ciphertext.
+std::size_t aes_decrypted_size(std::size_t cipher_bytes);
+
+std::optional<std::size_t> aes_encrypt_into(std::span<const std::byte> plaintext,
+                                            std::span<std::byte> out);
+
+std::optional<std::size_t> aes_decrypt_into(std::span<const std::byte> ciphertext,
+                                            std::span<std::byte> out);
+
+#endif
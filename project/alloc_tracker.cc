@@ -0,0 +1,126 @@
+#include "alloc_tracker.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+#ifdef __linux__
+#include <sys/resource.h>
+#endif
+
+namespace {
+
+    std::atomic<bool> tracking{false};
+    std::atomic<uint64_t> total_bytes{0};
+    std::atomic<uint64_t> total_count{0};
+
+#ifdef ALLOC_TRACKER_COUNT_NEW
+    void count(std::size_t size) noexcept {
+        if (tracking.load(std::memory_order_relaxed)) {
+            total_bytes.fetch_add(size, std::memory_order_relaxed);
+            total_count.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    void* counted_alloc(std::size_t size) noexcept {
+        count(size);
+        return std::malloc(size ? size : 1);
+    }
+
+    void* counted_alloc_or_throw(std::size_t size) {
+        void* p = counted_alloc(size);
+        if (!p) throw std::bad_alloc();
+        return p;
+    }
+
+    // aligned_alloc wants a size that is a multiple of the alignment.
+    void* counted_aligned_alloc(std::size_t size, std::align_val_t al) noexcept {
+        count(size);
+        std::size_t alignment = static_cast<std::size_t>(al);
+        std::size_t rounded = (std::max<std::size_t>(size, 1) + alignment - 1) & ~(alignment - 1);
+        return std::aligned_alloc(alignment, rounded);
+    }
+
+    void* counted_aligned_alloc_or_throw(std::size_t size, std::align_val_t al) {
+        void* p = counted_aligned_alloc(size, al);
+        if (!p) throw std::bad_alloc();
+        return p;
+    }
+#endif
+
+} // namespace
+
+#ifdef ALLOC_TRACKER_COUNT_NEW
+// Global replacements, aligned forms included: the libstdc++ defaults of
+// the aligned ones do not go through operator new(std::size_t).
+void* operator new(std::size_t size) { return counted_alloc_or_throw(size); }
+void* operator new[](std::size_t size) { return counted_alloc_or_throw(size); }
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept { return counted_alloc(size); }
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept {
+    return counted_alloc(size);
+}
+void* operator new(std::size_t size, std::align_val_t al) {
+    return counted_aligned_alloc_or_throw(size, al);
+}
+void* operator new[](std::size_t size, std::align_val_t al) {
+    return counted_aligned_alloc_or_throw(size, al);
+}
+void* operator new(std::size_t size, std::align_val_t al, const std::nothrow_t&) noexcept {
+    return counted_aligned_alloc(size, al);
+}
+void* operator new[](std::size_t size, std::align_val_t al, const std::nothrow_t&) noexcept {
+    return counted_aligned_alloc(size, al);
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::size_t) noexcept { std::free(p); }
+void operator delete(void* p, const std::nothrow_t&) noexcept { std::free(p); }
+void operator delete[](void* p, const std::nothrow_t&) noexcept { std::free(p); }
+void operator delete(void* p, std::align_val_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::align_val_t) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t, std::align_val_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::size_t, std::align_val_t) noexcept { std::free(p); }
+void operator delete(void* p, std::align_val_t, const std::nothrow_t&) noexcept { std::free(p); }
+void operator delete[](void* p, std::align_val_t, const std::nothrow_t&) noexcept {
+    std::free(p);
+}
+#endif
+
+bool alloc_tracking_available() {
+#ifdef ALLOC_TRACKER_COUNT_NEW
+    return true;
+#else
+    return false;
+#endif
+}
+
+void alloc_tracking_enable(bool enabled) {
+    tracking.store(enabled, std::memory_order_relaxed);
+}
+
+AllocSnapshot alloc_snapshot() {
+    AllocSnapshot s;
+    s.bytes = total_bytes.load(std::memory_order_relaxed);
+    s.count = total_count.load(std::memory_order_relaxed);
+    return s;
+}
+
+AllocSnapshot alloc_delta(const AllocSnapshot& before, const AllocSnapshot& after) {
+    AllocSnapshot d;
+    d.bytes = after.bytes - before.bytes;
+    d.count = after.count - before.count;
+    return d;
+}
+
+uint64_t peak_rss_bytes() {
+#ifdef __linux__
+    rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) == 0) {
+        return static_cast<uint64_t>(usage.ru_maxrss) * 1024; // ru_maxrss is in KiB
+    }
+#endif
+    return 0;
+}
@@ -0,0 +1,32 @@
+#ifndef ALLOC_TRACKER_H
+#define ALLOC_TRACKER_H
+
+#include <cstdint>
+
+// Process-wide heap allocation counters, fed by the global operator new
+// replacements in alloc_tracker.cc. The replacements are only compiled in
+// with ALLOC_TRACKER_COUNT_NEW defined, so linking the tracker into a
+// program leaves its allocator alone unless counting was asked for at build
+// time; without it alloc_tracking_available() is false and the counters
+// stay at 0. Counting is then off until enabled, which costs one relaxed
+// load per allocation.
+struct AllocSnapshot {
+    uint64_t bytes = 0; // bytes requested from operator new
+    uint64_t count = 0; // number of operator new calls
+};
+
+// True if the build counts operator new (ALLOC_TRACKER_COUNT_NEW).
+bool alloc_tracking_available();
+
+void alloc_tracking_enable(bool enabled);
+
+// Totals counted since the program start (while enabled).
+AllocSnapshot alloc_snapshot();
+
+// Allocations between two snapshots.
+AllocSnapshot alloc_delta(const AllocSnapshot& before, const AllocSnapshot& after);
+
+// Peak resident set size of the process in bytes, 0 where unsupported.
+uint64_t peak_rss_bytes();
+
+#endif // ALLOC_TRACKER_H
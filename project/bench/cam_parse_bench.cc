@@ -0,0 +1,113 @@
+/*
+    CAM parse microbenchmark.
+
+    Parses a bundle of n deterministic CAMs (see generate_cam_corpus) a
+    number of times and prints one JSON document with the throughput of:
+    - text: CamParser over the text lines
+    - binary: CamParser over binary CAMs
+    - text_validate: validate_messages, which only checks the structure
+
+    Usage:
+        cam_parse_bench [--cams 100000] [--passes 10]
+*/
+#include "../cam_generation.h"
+#include "../cam_parser.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+namespace {
+
+    using Clock = std::chrono::steady_clock;
+
+    struct Throughput {
+        double mb_per_sec = 0.0;
+        double cams_per_sec = 0.0;
+        double ns_per_cam = 0.0;
+    };
+
+    // Runs parse over bytes passes times; parse returns the number of CAMs
+    // it read, which is also what keeps the work from being optimized out.
+    template <typename Parse>
+    Throughput measure(const std::string& bytes, int passes, Parse parse) {
+        std::size_t cams = 0;
+        auto start = Clock::now();
+        for (int p = 0; p < passes; ++p) cams += parse(bytes);
+        std::chrono::duration<double> wall = Clock::now() - start;
+
+        Throughput t;
+        if (cams == 0 || wall.count() <= 0.0) return t;
+        t.mb_per_sec = static_cast<double>(bytes.size()) * passes / wall.count() / 1e6;
+        t.cams_per_sec = cams / wall.count();
+        t.ns_per_cam = wall.count() * 1e9 / cams;
+        return t;
+    }
+
+    bool parse_positive(const char* text, int& out) {
+        char* end = nullptr;
+        long v = std::strtol(text, &end, 10);
+        if (!end || *end != '\0' || v <= 0) return false;
+        out = static_cast<int>(v);
+        return true;
+    }
+
+    void print(const char* name, const Throughput& t, bool last) {
+        std::printf("    \"%s\": {\"mb_per_sec\": %.1f, \"cams_per_sec\": %.0f, "
+                    "\"ns_per_cam\": %.1f}%s\n",
+                    name, t.mb_per_sec, t.cams_per_sec, t.ns_per_cam, last ? "" : ",");
+    }
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    int cams = 100000;
+    int passes = 10;
+
+    for (int i = 1; i < argc; ++i) {
+        const bool has_value = i + 1 < argc;
+        bool ok = true;
+        if (std::strcmp(argv[i], "--help") == 0) {
+            std::printf("Usage: %s [--cams 100000] [--passes 10]\n", argv[0]);
+            return 0;
+        } else if (std::strcmp(argv[i], "--cams") == 0 && has_value) {
+            ok = parse_positive(argv[++i], cams);
+        } else if (std::strcmp(argv[i], "--passes") == 0 && has_value) {
+            ok = parse_positive(argv[++i], passes);
+        } else {
+            ok = false;
+        }
+        if (!ok) {
+            std::fprintf(stderr, "Error: invalid argument %s (see --help)\n", argv[i]);
+            return 1;
+        }
+    }
+
+    CamCorpusSpec spec;
+    spec.stations = static_cast<uint32_t>(cams);
+    const std::string text = generate_cam_corpus_text(spec);
+    const std::string binary = generate_cam_corpus_binary(spec);
+
+    auto parsed = [](bool binaryCams) {
+        return [binaryCams](const std::string& bytes) {
+            return count_cams(bytes, binaryCams).value_or(0);
+        };
+    };
+    Throughput textParse = measure(text, passes, parsed(false));
+    Throughput binaryParse = measure(binary, passes, parsed(true));
+    Throughput textValidate = measure(text, passes, [cams](const std::string& bytes) {
+        return validate_messages(bytes) ? static_cast<std::size_t>(cams) : 0;
+    });
+
+    std::printf("{\n");
+    std::printf("  \"cams\": %d, \"passes\": %d,\n", cams, passes);
+    std::printf("  \"text_bytes\": %zu, \"binary_bytes\": %zu,\n", text.size(), binary.size());
+    std::printf("  \"results\": {\n");
+    print("text", textParse, false);
+    print("binary", binaryParse, false);
+    print("text_validate", textValidate, true);
+    std::printf("  }\n}\n");
+    return 0;
+}
@@ -0,0 +1,522 @@
+/*
+    Crypto microbenchmark.
+
+    Runs engine_encrypt/engine_decrypt of every engine over bundles of
+    n generated CAMs and over a range of thread counts, and prints
+    one JSON document with, per (engine, CAM count, threads) point:
+    - ops/s of encryption and decryption across all threads
+    - p50/p99 latency of a single call
+    - plaintext, wire and expansion bytes of the bundle
+
+    With --pool the calls go through the span API into buffers drawn from
+    the crypto buffer pool instead of returning new strings, and the pool
+    hit rate is reported. With --binary the bundles are binary CAMs
+    (cam_codec) instead of text lines.
+
+    With --corpus the payloads are replayed from a CAM corpus file (see
+    tools/make_cam_corpus.cc) instead of generated: each call takes the next
+    record straight from the mapping, and --cams is ignored. Stored wire
+    bytes are used for decryption when the corpus was encrypted with the
+    engine under test, under the keys of its key seed; the run stops if they
+    do not decrypt back. Byte counts are then per record, on average, and
+    "cams" holds the record count.
+
+    With --delta each point replays DELTA_STEPS consecutive bundles of a
+    stream in which every one of the n stations moves smoothly, delta coded
+    per station (cam_delta) with a keyframe every 10 bundles, so byte counts
+    are the steady-state average of the compressed plaintext.
+
+    With --compress every payload goes through the zstd compression stage
+    (payload_compressor, CAM dictionary) before it is encrypted; byte
+    counts are then those of the compressed payload. Compression itself is
+    not timed here, see the compressionOverhead table of eris.
+
+    Usage:
+        crypto_bench [--engines aes,rsa,ecc,he] [--cams 1,10,100,1000]
+                     [--threads 1,2,4] [--ops 20] [--pool] [--binary]
+                     [--delta] [--compress] [--corpus FILE]
+*/
+#include "../buffer_pool.h"
+#include "../cam_corpus_file.h"
+#include "../cam_delta.h"
+#include "../cam_generation.h"
+#include "../crypto_engine.h"
+#include "../crypto_timing.h"
+#include "../payload_compressor.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <memory>
+#include <span>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace {
+
+    constexpr int DELTA_STEPS = 20;
+
+    struct OpStats {
+        double ops_per_sec = 0.0;
+        double p50_us = 0.0;
+        double p99_us = 0.0;
+    };
+
+    struct Point {
+        CryptoEngine engine;
+        int cams;
+        int threads;
+        size_t plain_bytes = 0;
+        size_t wire_bytes = 0;
+        OpStats encrypt;
+        OpStats decrypt;
+        std::string error;
+    };
+
+    using Clock = std::chrono::steady_clock;
+
+    OpStats summarize(std::vector<double> latencies_us, double wall_sec) {
+        OpStats s;
+        std::sort(latencies_us.begin(), latencies_us.end());
+        s.ops_per_sec = wall_sec > 0.0 ? latencies_us.size() / wall_sec : 0.0;
+        s.p50_us = percentile(latencies_us, 50.0);
+        s.p99_us = percentile(latencies_us, 99.0);
+        return s;
+    }
+
+    // Runs op ops_per_thread times on each of threads threads, and returns the
+    // per-call latencies of all threads plus the wall time of the whole run.
+    template <typename Op>
+    OpStats run_threads(int threads, int ops_per_thread, Op op) {
+        std::vector<std::vector<double>> per_thread(threads);
+        std::vector<std::thread> pool;
+
+        auto wall_start = Clock::now();
+        for (int t = 0; t < threads; ++t) {
+            pool.emplace_back([&, t] {
+                per_thread[t].reserve(ops_per_thread);
+                for (int i = 0; i < ops_per_thread; ++i) {
+                    auto start = Clock::now();
+                    op();
+                    std::chrono::duration<double, std::micro> d = Clock::now() - start;
+                    per_thread[t].push_back(d.count());
+                }
+            });
+        }
+        for (auto& th : pool) th.join();
+        std::chrono::duration<double> wall = Clock::now() - wall_start;
+
+        std::vector<double> all;
+        for (auto& v : per_thread) all.insert(all.end(), v.begin(), v.end());
+        return summarize(std::move(all), wall.count());
+    }
+
+    // Bundles of up to 1000 CAMs come from generate_messages, like in the
+    // simulation; larger ones from a CamGenerator with one station per CAM.
+    std::string make_bundle(int cams, bool binary) {
+        if (cams <= 1000) return binary ? generate_binary_messages(cams) : generate_messages(cams);
+
+        CamGenerator generator(static_cast<uint32_t>(cams));
+        std::string bundle;
+        if (binary) {
+            std::vector<Cam> all;
+            all.reserve(cams);
+            generator.generate(cams, [&](const Cam& cam) { all.push_back(cam); });
+            bundle = encode_cams(all);
+        } else {
+            generator.append_text(cams, bundle);
+        }
+        return bundle;
+    }
+
+    Point run_point(CryptoEngine engine, int cams, int threads, int ops, bool pool, bool binary,
+                    const PayloadCompressor* compressor) {
+        Point p;
+        p.engine = engine;
+        p.cams = cams;
+        p.threads = threads;
+
+        // The generators keep RNG state, so the bundle is built before any
+        // worker thread starts.
+        const std::string msg = compressor ? compressor->compress(make_bundle(cams, binary))
+                                           : make_bundle(cams, binary);
+        p.plain_bytes = msg.size();
+
+        try {
+            const std::string wire = engine_encrypt(engine, msg);
+            p.wire_bytes = wire.size();
+            if (engine_decrypt(engine, wire) != msg) {
+                p.error = "round trip mismatch";
+                return p;
+            }
+
+            if (pool) {
+                auto in = std::as_bytes(std::span(msg));
+                auto wireIn = std::as_bytes(std::span(wire));
+                p.encrypt = run_threads(threads, ops, [&] {
+                    PooledBuffer out = buffer_pool_acquire(engine_encrypted_size(engine, in.size()));
+                    engine_encrypt_into(engine, in, out.span());
+                });
+                std::atomic<bool> failed{false};
+                p.decrypt = run_threads(threads, ops, [&] {
+                    PooledBuffer out =
+                        buffer_pool_acquire(engine_decrypted_size(engine, wireIn.size()));
+                    if (!engine_decrypt_into(engine, wireIn, out.span())) failed = true;
+                });
+                if (failed) p.error = "decryption failed";
+            } else {
+                p.encrypt = run_threads(threads, ops, [&] { engine_encrypt(engine, msg); });
+                p.decrypt = run_threads(threads, ops, [&] { engine_decrypt(engine, wire); });
+            }
+        } catch (const std::exception& e) {
+            // e.g. HE bundles larger than the slot count
+            p.error = e.what();
+        }
+        return p;
+    }
+
+    // Calls op(span) on a buffer of size bytes, pooled or freshly allocated
+    // like the string API would.
+    template <typename Op>
+    void with_buffer(bool pool, std::size_t size, Op op) {
+        if (pool) {
+            PooledBuffer out = buffer_pool_acquire(size);
+            op(out.span());
+        } else {
+            std::vector<std::byte> out(size);
+            op(std::span(out));
+        }
+    }
+
+    // Payloads replayed in turn by the encrypt and decrypt calls of a point,
+    // with their wire bytes if these are already known.
+    struct Replay {
+        std::vector<std::string_view> plain;
+        std::vector<std::string_view> wire; // empty, or one per plain
+        std::vector<std::string> owned;     // backing of plain when not mapped
+
+        // Puts the payloads through the compression stage; stored wire
+        // bytes are of the uncompressed payloads, so they are dropped.
+        void compress(const PayloadCompressor& compressor) {
+            std::vector<std::string> compressed;
+            compressed.reserve(plain.size());
+            for (std::string_view p : plain) compressed.push_back(compressor.compress(p));
+            owned = std::move(compressed);
+            plain.assign(owned.begin(), owned.end());
+            wire.clear();
+        }
+    };
+
+    // True if every stored wire payload decrypts back to its plaintext, i.e.
+    // the engine keys are those the corpus was written with.
+    bool replay_decrypts(CryptoEngine engine, const Replay& replay) {
+        for (std::size_t i = 0; i < replay.wire.size(); ++i) {
+            if (engine_decrypt(engine, std::string(replay.wire[i])) != replay.plain[i]) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    Replay corpus_replay(const CamCorpusFile& corpus, CryptoEngine engine) {
+        Replay r;
+        for (std::size_t i = 0; i < corpus.size(); ++i) {
+            r.plain.push_back(corpus[i].plain);
+            if (corpus.encrypted() && corpus.info().engine == engine) {
+                r.wire.push_back(corpus[i].wire);
+            }
+        }
+        return r;
+    }
+
+    // Bundles of a stream of steps CAMs per station, cams stations moving
+    // smoothly, delta coded (cam_delta) with a keyframe every 10 steps.
+    std::vector<std::string> make_delta_bundles(int cams, int steps) {
+        std::vector<Cam> bundle;
+        for (int s = 0; s < cams; ++s) bundle.push_back(deterministic_cam(5489u, s, 0));
+
+        CamDeltaEncoder encoder(10);
+        std::vector<std::string> bundles;
+        for (int t = 0; t < steps; ++t) {
+            bundles.push_back(encoder.encode(bundle));
+            for (Cam& cam : bundle) cam = next_cam(cam);
+        }
+        return bundles;
+    }
+
+    Point run_replay_point(CryptoEngine engine, int cams, const Replay& replay, int threads,
+                           int ops, bool pool) {
+        Point p;
+        p.engine = engine;
+        p.cams = cams;
+        p.threads = threads;
+
+        const std::size_t n = replay.plain.size();
+        auto plain = [&](std::size_t i) { return std::as_bytes(std::span(replay.plain[i])); };
+        try {
+            // Wire bytes of every payload: the stored ones if any, otherwise
+            // encrypted (and checked) here.
+            std::vector<std::string> encrypted;
+            const bool stored = !replay.wire.empty();
+            if (!stored) {
+                encrypted.reserve(n);
+                for (std::size_t i = 0; i < n; ++i) {
+                    const std::string msg(replay.plain[i]);
+                    encrypted.push_back(engine_encrypt(engine, msg));
+                    if (engine_decrypt(engine, encrypted.back()) != msg) {
+                        p.error = "round trip mismatch";
+                        return p;
+                    }
+                }
+            }
+            auto wire = [&](std::size_t i) {
+                return std::as_bytes(stored ? std::span(replay.wire[i]) : std::span(encrypted[i]));
+            };
+
+            for (std::size_t i = 0; i < n; ++i) {
+                p.plain_bytes += plain(i).size();
+                p.wire_bytes += wire(i).size();
+            }
+            p.plain_bytes /= n;
+            p.wire_bytes /= n;
+
+            std::atomic<std::size_t> next{0};
+            p.encrypt = run_threads(threads, ops, [&] {
+                const std::size_t i = next++ % n;
+                with_buffer(pool, engine_encrypted_size(engine, plain(i).size()),
+                            [&](std::span<std::byte> out) {
+                                engine_encrypt_into(engine, plain(i), out);
+                            });
+            });
+            next = 0;
+            std::atomic<bool> failed{false};
+            p.decrypt = run_threads(threads, ops, [&] {
+                const std::size_t i = next++ % n;
+                with_buffer(pool, engine_decrypted_size(engine, wire(i).size()),
+                            [&](std::span<std::byte> out) {
+                                if (!engine_decrypt_into(engine, wire(i), out)) failed = true;
+                            });
+            });
+            if (failed) p.error = "decryption failed";
+        } catch (const std::exception& e) {
+            p.error = e.what();
+        }
+        return p;
+    }
+
+    std::vector<std::string> split(const char* list) {
+        std::vector<std::string> out;
+        std::stringstream ss(list);
+        std::string token;
+        while (std::getline(ss, token, ',')) {
+            if (!token.empty()) out.push_back(token);
+        }
+        return out;
+    }
+
+    bool parse_ints(const char* list, std::vector<int>& out) {
+        out.clear();
+        for (const auto& token : split(list)) {
+            char* end = nullptr;
+            long v = std::strtol(token.c_str(), &end, 10);
+            if (!end || *end != '\0' || v <= 0) return false;
+            out.push_back(static_cast<int>(v));
+        }
+        return !out.empty();
+    }
+
+    bool parse_engines(const char* list, std::vector<CryptoEngine>& out) {
+        out.clear();
+        for (const auto& token : split(list)) {
+            bool found = false;
+            for (auto e : {CryptoEngine::Aes, CryptoEngine::Rsa, CryptoEngine::Ecc,
+                           CryptoEngine::He}) {
+                if (token == engine_name(e)) {
+                    out.push_back(e);
+                    found = true;
+                }
+            }
+            if (!found) return false;
+        }
+        return !out.empty();
+    }
+
+    std::string json_escape(const std::string& in) {
+        std::string out;
+        for (char c : in) {
+            if (c == '"' || c == '\\') out.push_back('\\');
+            if (static_cast<unsigned char>(c) >= 0x20) out.push_back(c);
+        }
+        return out;
+    }
+
+    void print_op(const char* name, const OpStats& s, bool last) {
+        std::printf("      \"%s\": {\"ops_per_sec\": %.3f, \"p50_us\": %.3f, \"p99_us\": %.3f}%s\n",
+                    name, s.ops_per_sec, s.p50_us, s.p99_us, last ? "" : ",");
+    }
+
+    void print_point(const Point& p, bool last) {
+        std::printf("    {\n");
+        std::printf("      \"engine\": \"%s\", \"cams\": %d, \"threads\": %d,\n",
+                    engine_name(p.engine), p.cams, p.threads);
+        if (!p.error.empty()) {
+            std::printf("      \"error\": \"%s\"\n", json_escape(p.error).c_str());
+        } else {
+            std::printf("      \"plain_bytes\": %zu, \"wire_bytes\": %zu, "
+                        "\"expansion_bytes\": %lld,\n",
+                        p.plain_bytes, p.wire_bytes,
+                        static_cast<long long>(p.wire_bytes) -
+                            static_cast<long long>(p.plain_bytes));
+            print_op("encrypt", p.encrypt, false);
+            print_op("decrypt", p.decrypt, true);
+        }
+        std::printf("    }%s\n", last ? "" : ",");
+    }
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    std::vector<CryptoEngine> engines = {CryptoEngine::Aes, CryptoEngine::Rsa, CryptoEngine::Ecc,
+                                         CryptoEngine::He};
+    std::vector<int> cams = {1, 10, 100, 1000};
+    std::vector<int> threads = {1, 2, 4};
+    int ops = 20;
+    bool pool = false;
+    bool binary = false;
+    bool delta = false;
+    bool compress = false;
+    const char* corpusPath = nullptr;
+
+    for (int i = 1; i < argc; ++i) {
+        const bool has_value = i + 1 < argc;
+        bool ok = true;
+        if (std::strcmp(argv[i], "--help") == 0) {
+            std::printf("Usage: %s [--engines aes,rsa,ecc,he] [--cams 1,10,100,1000] "
+                        "[--threads 1,2,4] [--ops 20] [--pool] [--binary] [--delta] "
+                        "[--compress] [--corpus FILE]\n",
+                        argv[0]);
+            return 0;
+        } else if (std::strcmp(argv[i], "--engines") == 0 && has_value) {
+            ok = parse_engines(argv[++i], engines);
+        } else if (std::strcmp(argv[i], "--cams") == 0 && has_value) {
+            ok = parse_ints(argv[++i], cams);
+        } else if (std::strcmp(argv[i], "--threads") == 0 && has_value) {
+            ok = parse_ints(argv[++i], threads);
+        } else if (std::strcmp(argv[i], "--pool") == 0) {
+            pool = true;
+        } else if (std::strcmp(argv[i], "--binary") == 0) {
+            binary = true;
+        } else if (std::strcmp(argv[i], "--delta") == 0) {
+            delta = true;
+        } else if (std::strcmp(argv[i], "--compress") == 0) {
+            compress = true;
+        } else if (std::strcmp(argv[i], "--corpus") == 0 && has_value) {
+            corpusPath = argv[++i];
+        } else if (std::strcmp(argv[i], "--ops") == 0 && has_value) {
+            std::vector<int> v;
+            ok = parse_ints(argv[++i], v) && v.size() == 1;
+            if (ok) ops = v[0];
+        } else {
+            ok = false;
+        }
+        if (!ok) {
+            std::fprintf(stderr, "Error: invalid argument %s (see --help)\n", argv[i]);
+            return 1;
+        }
+    }
+
+    CamCorpusFile corpus;
+    if (corpusPath) {
+        if (!corpus.open(corpusPath)) {
+            std::fprintf(stderr, "Error: %s\n", corpus.error().c_str());
+            return 1;
+        }
+        if (corpus.size() == 0) {
+            std::fprintf(stderr, "Error: %s holds no records\n", corpusPath);
+            return 1;
+        }
+        binary = corpus.info().binary_cams;
+        // The stored wire bytes only decrypt with the keys they were
+        // written with, so these have to be derived before any engine call.
+        if (corpus.encrypted() && !engine_set_key_seed(corpus.info().key_seed)) {
+            std::fprintf(stderr,
+                         "Error: the engine keys were generated before the key seed was set\n");
+            return 1;
+        }
+    }
+
+    std::unique_ptr<PayloadCompressor> compressor;
+    if (compress) {
+        if (!PayloadCompressor::available()) {
+            std::fprintf(stderr, "Error: --compress needs a build with zstd\n");
+            return 1;
+        }
+        compressor = std::make_unique<PayloadCompressor>(train_cam_dictionary(binary || delta));
+    }
+
+    std::vector<Point> points;
+    for (auto engine : engines) {
+        // Key generation and context setup happen on first use and are not
+        // thread-safe for every engine, so they run here, single threaded.
+        engine_decrypt(engine, engine_encrypt(engine, "WARMUP"));
+
+        if (corpusPath) {
+            Replay replay = corpus_replay(corpus, engine);
+            if (!replay_decrypts(engine, replay)) {
+                std::fprintf(stderr, "Error: the wire bytes of %s do not decrypt back\n",
+                             corpusPath);
+                return 1;
+            }
+            if (compressor) replay.compress(*compressor);
+            for (int t : threads) {
+                points.push_back(run_replay_point(engine, static_cast<int>(corpus.size()), replay,
+                                                  t, ops, pool));
+            }
+            continue;
+        }
+        for (int n : cams) {
+            if (delta) {
+                Replay replay;
+                replay.owned = make_delta_bundles(n, DELTA_STEPS);
+                replay.plain.assign(replay.owned.begin(), replay.owned.end());
+                if (compressor) replay.compress(*compressor);
+                for (int t : threads) {
+                    points.push_back(run_replay_point(engine, n, replay, t, ops, pool));
+                }
+                continue;
+            }
+            for (int t : threads) {
+                points.push_back(run_point(engine, n, t, ops, pool, binary, compressor.get()));
+            }
+        }
+    }
+
+    std::printf("{\n");
+    std::printf("  \"hardware_threads\": %u,\n", std::thread::hardware_concurrency());
+    std::printf("  \"ops_per_thread\": %d,\n", ops);
+    std::printf("  \"cam_format\": \"%s\",\n", delta ? "delta" : (binary ? "binary" : "text"));
+    std::printf("  \"compressed\": %s,\n", compressor ? "true" : "false");
+    if (corpusPath) std::printf("  \"corpus\": \"%s\",\n", json_escape(corpusPath).c_str());
+    if (pool) {
+        BufferPoolStats s = buffer_pool_stats();
+        std::printf("  \"buffer_pool\": {\"hit_rate\": %.4f, \"local_hits\": %llu, "
+                    "\"global_hits\": %llu, \"misses\": %llu},\n",
+                    s.hit_rate(), static_cast<unsigned long long>(s.local_hits),
+                    static_cast<unsigned long long>(s.global_hits),
+                    static_cast<unsigned long long>(s.misses));
+    }
+    std::printf("  \"results\": [\n");
+    for (size_t i = 0; i < points.size(); ++i) {
+        print_point(points[i], i + 1 == points.size());
+    }
+    std::printf("  ]\n}\n");
+    return 0;
+}
@@ -0,0 +1,151 @@
+#include "buffer_pool.h"
+
+#include <array>
+#include <atomic>
+#include <mutex>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace {
+
+    constexpr int kMinShift = 6;  // 64 B
+    constexpr int kMaxShift = 20; // 1 MiB
+    constexpr int kClasses = kMaxShift - kMinShift + 1;
+    constexpr std::size_t kLocalLimit = 8;   // buffers kept per class and thread
+    constexpr std::size_t kGlobalLimit = 64; // buffers kept per class in the shared list
+
+    using Block = std::unique_ptr<std::byte[]>;
+    using FreeLists = std::array<std::vector<Block>, kClasses>;
+
+    std::atomic<uint64_t> local_hits{0};
+    std::atomic<uint64_t> global_hits{0};
+    std::atomic<uint64_t> misses{0};
+
+    int size_class(std::size_t size) {
+        int shift = kMinShift;
+        while (shift <= kMaxShift && (std::size_t{1} << shift) < size) ++shift;
+        return shift <= kMaxShift ? shift - kMinShift : -1;
+    }
+
+    std::size_t class_capacity(int cls) {
+        return std::size_t{1} << (cls + kMinShift);
+    }
+
+    struct GlobalPool {
+        std::mutex mutex;
+        FreeLists lists;
+    };
+
+    GlobalPool& global_pool() {
+        static GlobalPool pool;
+        return pool;
+    }
+
+    // Moves a block to the shared list, or frees it if that one is full.
+    void release_global(int cls, Block block) {
+        GlobalPool& pool = global_pool();
+        std::lock_guard<std::mutex> lock(pool.mutex);
+        if (pool.lists[cls].size() < kGlobalLimit) pool.lists[cls].push_back(std::move(block));
+    }
+
+    struct LocalPool {
+        FreeLists lists;
+
+        // Buffers cached by an exiting thread are handed to the others.
+        ~LocalPool() {
+            for (int cls = 0; cls < kClasses; ++cls) {
+                for (auto& block : lists[cls]) release_global(cls, std::move(block));
+            }
+        }
+    };
+
+    LocalPool& local_pool() {
+        thread_local LocalPool pool;
+        return pool;
+    }
+
+    Block take(int cls) {
+        auto& local = local_pool().lists[cls];
+        if (!local.empty()) {
+            Block block = std::move(local.back());
+            local.pop_back();
+            local_hits.fetch_add(1, std::memory_order_relaxed);
+            return block;
+        }
+
+        GlobalPool& pool = global_pool();
+        {
+            std::lock_guard<std::mutex> lock(pool.mutex);
+            auto& shared = pool.lists[cls];
+            if (!shared.empty()) {
+                Block block = std::move(shared.back());
+                shared.pop_back();
+                global_hits.fetch_add(1, std::memory_order_relaxed);
+                return block;
+            }
+        }
+
+        misses.fetch_add(1, std::memory_order_relaxed);
+        return Block(new std::byte[class_capacity(cls)]);
+    }
+
+    void give_back(int cls, Block block) {
+        auto& local = local_pool().lists[cls];
+        if (local.size() < kLocalLimit) {
+            local.push_back(std::move(block));
+        } else {
+            release_global(cls, std::move(block));
+        }
+    }
+
+} // namespace
+
+PooledBuffer::~PooledBuffer() {
+    if (data_ && size_class_ >= 0) give_back(size_class_, std::move(data_));
+}
+
+PooledBuffer::PooledBuffer(PooledBuffer&& other) noexcept
+    : data_(std::move(other.data_)),
+      size_(std::exchange(other.size_, 0)),
+      capacity_(std::exchange(other.capacity_, 0)),
+      size_class_(std::exchange(other.size_class_, -1)) {}
+
+PooledBuffer& PooledBuffer::operator=(PooledBuffer&& other) noexcept {
+    if (this != &other) {
+        PooledBuffer old(std::move(*this));
+        data_ = std::move(other.data_);
+        size_ = std::exchange(other.size_, 0);
+        capacity_ = std::exchange(other.capacity_, 0);
+        size_class_ = std::exchange(other.size_class_, -1);
+    }
+    return *this;
+}
+
+void PooledBuffer::resize(std::size_t size) {
+    if (size > capacity_) throw std::length_error("PooledBuffer::resize beyond capacity");
+    size_ = size;
+}
+
+PooledBuffer buffer_pool_acquire(std::size_t size) {
+    PooledBuffer buffer;
+    buffer.size_ = size;
+    buffer.size_class_ = size_class(size);
+    if (buffer.size_class_ >= 0) {
+        buffer.capacity_ = class_capacity(buffer.size_class_);
+        buffer.data_ = take(buffer.size_class_);
+    } else {
+        misses.fetch_add(1, std::memory_order_relaxed);
+        buffer.capacity_ = size;
+        buffer.data_.reset(new std::byte[size]);
+    }
+    return buffer;
+}
+
+BufferPoolStats buffer_pool_stats() {
+    BufferPoolStats s;
+    s.local_hits = local_hits.load(std::memory_order_relaxed);
+    s.global_hits = global_hits.load(std::memory_order_relaxed);
+    s.misses = misses.load(std::memory_order_relaxed);
+    return s;
+}
@@ -0,0 +1,64 @@
+#ifndef BUFFER_POOL_H
+#define BUFFER_POOL_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <span>
+
+// Byte buffers recycled across messages and packets, in power of two size
+// classes from 64 B to 1 MiB. Each thread keeps a small free list per class
+// and falls back to a shared, mutex protected list before allocating, so
+// steady-state encryption on several threads does not touch the allocator.
+// Larger requests are allocated and freed directly.
+
+class PooledBuffer {
+  public:
+    PooledBuffer() = default;
+    ~PooledBuffer();
+
+    PooledBuffer(PooledBuffer&& other) noexcept;
+    PooledBuffer& operator=(PooledBuffer&& other) noexcept;
+    PooledBuffer(const PooledBuffer&) = delete;
+    PooledBuffer& operator=(const PooledBuffer&) = delete;
+
+    std::byte* data() { return data_.get(); }
+    const std::byte* data() const { return data_.get(); }
+
+    // Bytes in use; starts at the requested size and can be shrunk (e.g. to
+    // the bytes an *_into call wrote) or grown up to capacity().
+    std::size_t size() const { return size_; }
+    void resize(std::size_t size);
+    std::size_t capacity() const { return capacity_; }
+
+    std::span<std::byte> span() { return {data(), size_}; }
+    std::span<const std::byte> span() const { return {data(), size_}; }
+
+  private:
+    friend PooledBuffer buffer_pool_acquire(std::size_t size);
+
+    std::unique_ptr<std::byte[]> data_;
+    std::size_t size_ = 0;
+    std::size_t capacity_ = 0;
+    int size_class_ = -1; // -1: not pooled
+};
+
+// Returns a buffer of at least size bytes (contents unspecified); it goes
+// back to the calling thread's free list when destroyed.
+PooledBuffer buffer_pool_acquire(std::size_t size);
+
+struct BufferPoolStats {
+    uint64_t local_hits = 0;  // served from the thread's free list
+    uint64_t global_hits = 0; // served from the shared list
+    uint64_t misses = 0;      // newly allocated (including oversized requests)
+
+    double hit_rate() const {
+        uint64_t total = local_hits + global_hits + misses;
+        return total ? static_cast<double>(local_hits + global_hits) / total : 0.0;
+    }
+};
+
+// Counters of all threads since the program start.
+BufferPoolStats buffer_pool_stats();
+
+#endif // BUFFER_POOL_H
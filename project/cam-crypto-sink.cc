@@ -0,0 +1,287 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+
+// SPDX-License-Identifier: GPL-2.0-only
+
+#include "cam-crypto-sink.h"
+
+#include "buffer_pool.h"
+#include "cam_parser.h"
+
+#include <ns3/inet-socket-address.h>
+#include <ns3/inet6-socket-address.h>
+#include <ns3/ipv4-address.h>
+#include <ns3/ipv6-address.h>
+#include <ns3/boolean.h>
+#include <ns3/log.h>
+#include <ns3/packet.h>
+#include <ns3/simulator.h>
+#include <ns3/uinteger.h>
+#include <ns3/udp-socket-factory.h>
+
+#include <algorithm>
+#include <chrono>
+#include <optional>
+#include <sstream>
+#include <string_view>
+
+namespace ns3
+{
+
+NS_LOG_COMPONENT_DEFINE("CamCryptoSink");
+
+NS_OBJECT_ENSURE_REGISTERED(CamCryptoSink);
+
+TypeId
+CamCryptoSink::GetTypeId()
+{
+    static TypeId tid =
+        TypeId("ns3::CamCryptoSink")
+            .SetParent<Application>()
+            .SetGroupName("Applications")
+            .AddConstructor<CamCryptoSink>()
+            .AddAttribute("Port",
+                          "Port on which we listen for incoming packets.",
+                          UintegerValue(9),
+                          MakeUintegerAccessor(&CamCryptoSink::m_port),
+                          MakeUintegerChecker<uint16_t>())
+            .AddAttribute("EncryptType",
+                          "Engine used to decrypt the payload: 0 - No encryption, 1 - AES, "
+                          "2 - RSA, 3 - ECC, 4 - Homomorphic",
+                          UintegerValue(0),
+                          MakeUintegerAccessor(&CamCryptoSink::m_encryptType),
+                          MakeUintegerChecker<uint16_t>(0, 4))
+            .AddAttribute("BinaryCam",
+                          "If true, the plaintext is validated as binary CAMs (cam_codec), "
+                          "otherwise as text CAMs",
+                          BooleanValue(false),
+                          MakeBooleanAccessor(&CamCryptoSink::m_binaryCam),
+                          MakeBooleanChecker())
+            .AddAttribute("FillTerminator",
+                          "If true, the last payload byte is dropped before decrypting: "
+                          "UdpEchoClient::SetFill(std::string) sends the string terminator",
+                          BooleanValue(true),
+                          MakeBooleanAccessor(&CamCryptoSink::m_fillTerminator),
+                          MakeBooleanChecker())
+            .AddTraceSource("RxWithAddresses",
+                            "A packet has been received",
+                            MakeTraceSourceAccessor(&CamCryptoSink::m_rxTraceWithAddresses),
+                            "ns3::Packet::TwoAddressTracedCallback");
+    return tid;
+}
+
+CamCryptoSink::CamCryptoSink()
+{
+    NS_LOG_FUNCTION(this);
+}
+
+CamCryptoSink::~CamCryptoSink()
+{
+    NS_LOG_FUNCTION(this);
+    m_socket = nullptr;
+    m_socket6 = nullptr;
+}
+
+const std::vector<CamCryptoSink::RxCryptoEntry>&
+CamCryptoSink::GetEntries() const
+{
+    return m_entries;
+}
+
+void
+CamCryptoSink::SetCostModel(std::shared_ptr<const CryptoCostModel> model)
+{
+    m_costModel = model;
+}
+
+void
+CamCryptoSink::SetCompressor(std::shared_ptr<const PayloadCompressor> compressor)
+{
+    m_compressor = compressor;
+}
+
+void
+CamCryptoSink::StartApplication()
+{
+    NS_LOG_FUNCTION(this);
+
+    if (!m_socket)
+    {
+        TypeId tid = TypeId::LookupByName("ns3::UdpSocketFactory");
+        m_socket = Socket::CreateSocket(GetNode(), tid);
+        InetSocketAddress local = InetSocketAddress(Ipv4Address::GetAny(), m_port);
+        NS_ABORT_MSG_IF(m_socket->Bind(local) == -1, "Failed to bind socket");
+    }
+
+    if (!m_socket6)
+    {
+        TypeId tid = TypeId::LookupByName("ns3::UdpSocketFactory");
+        m_socket6 = Socket::CreateSocket(GetNode(), tid);
+        Inet6SocketAddress local6 = Inet6SocketAddress(Ipv6Address::GetAny(), m_port);
+        NS_ABORT_MSG_IF(m_socket6->Bind(local6) == -1, "Failed to bind socket");
+    }
+
+    m_socket->SetRecvCallback(MakeCallback(&CamCryptoSink::HandleRead, this));
+    m_socket6->SetRecvCallback(MakeCallback(&CamCryptoSink::HandleRead, this));
+}
+
+void
+CamCryptoSink::StopApplication()
+{
+    NS_LOG_FUNCTION(this);
+
+    if (m_socket)
+    {
+        m_socket->Close();
+        m_socket->SetRecvCallback(MakeNullCallback<void, Ptr<Socket>>());
+    }
+    if (m_socket6)
+    {
+        m_socket6->Close();
+        m_socket6->SetRecvCallback(MakeNullCallback<void, Ptr<Socket>>());
+    }
+}
+
+void
+CamCryptoSink::HandleRead(Ptr<Socket> socket)
+{
+    NS_LOG_FUNCTION(this << socket);
+
+    Ptr<Packet> packet;
+    Address from;
+    Address localAddress;
+    while ((packet = socket->RecvFrom(from)))
+    {
+        socket->GetSockName(localAddress);
+
+        RxCryptoEntry entry;
+        entry.rxTime = Simulator::Now().GetSeconds();
+        entry.pktSize = packet->GetSize();
+
+        std::ostringstream srcIp;
+        if (InetSocketAddress::IsMatchingType(from))
+        {
+            srcIp << InetSocketAddress::ConvertFrom(from).GetIpv4();
+        }
+        else if (Inet6SocketAddress::IsMatchingType(from))
+        {
+            srcIp << Inet6SocketAddress::ConvertFrom(from).GetIpv6();
+        }
+        entry.srcIp = srcIp.str();
+
+        CryptoEngine engine = static_cast<CryptoEngine>(m_encryptType);
+        if (m_costModel)
+        {
+            // One crypto processor per node: a packet waits for the
+            // decryptions of the packets received before it.
+            Time now = Simulator::Now();
+            Time start = std::max(now, m_cryptoBusyUntil);
+            entry.decryptTime = m_costModel->decrypt_delay(engine, entry.pktSize);
+            entry.queueTime = (start - now).GetSeconds();
+            entry.modelled = true;
+            m_cryptoBusyUntil = start + Seconds(entry.decryptTime);
+            Simulator::Schedule(m_cryptoBusyUntil - now,
+                                &CamCryptoSink::Deliver,
+                                this,
+                                packet,
+                                from,
+                                localAddress);
+            m_entries.push_back(std::move(entry));
+            continue;
+        }
+
+        m_rxTraceWithAddresses(packet, from, localAddress);
+
+        // Payload and plaintext buffers are recycled from packet to packet.
+        PooledBuffer wire = buffer_pool_acquire(entry.pktSize);
+        packet->CopyData(reinterpret_cast<uint8_t*>(wire.data()), entry.pktSize);
+        if (m_fillTerminator && wire.size() > 0)
+        {
+            wire.resize(wire.size() - 1);
+        }
+        PooledBuffer decmsg = buffer_pool_acquire(engine_decrypted_size(engine, wire.size()));
+
+        // Only the engine call is timed; the payload copy above is the same
+        // for every engine.
+        auto start = std::chrono::high_resolution_clock::now();
+        auto declength = engine_decrypt_into(engine, wire.span(), decmsg.span());
+        auto end = std::chrono::high_resolution_clock::now();
+        std::chrono::duration<double> elapsed = end - start;
+
+        entry.decryptTime = elapsed.count();
+        entry.declength = declength.value_or(0);
+        std::string_view plain(reinterpret_cast<const char*>(decmsg.data()), entry.declength);
+        std::optional<std::string> decompressed;
+        if (m_compressor && declength)
+        {
+            decompressed = m_compressor->decompress(plain);
+            plain = decompressed ? std::string_view(*decompressed) : std::string_view();
+        }
+
+        // The CAMs are parsed in place, field by field, to account for what
+        // a receiver does with them before they are of any use.
+        start = std::chrono::high_resolution_clock::now();
+        CamParser parser(plain, m_binaryCam);
+        Cam cam;
+        while (parser.next(cam))
+        {
+            entry.cams++;
+        }
+        end = std::chrono::high_resolution_clock::now();
+        entry.parseTime = std::chrono::duration<double>(end - start).count();
+        entry.valid = parser.ok();
+
+        NS_LOG_INFO("Rx " << entry.pktSize << " bytes from " << entry.srcIp << ", decrypted in "
+                          << entry.decryptTime << " s, " << entry.cams << " CAMs parsed in "
+                          << entry.parseTime << " s, valid " << entry.valid);
+        m_entries.push_back(std::move(entry));
+    }
+}
+
+void
+CamCryptoSink::Deliver(Ptr<const Packet> packet, Address from, Address localAddress)
+{
+    NS_LOG_FUNCTION(this << packet);
+    m_rxTraceWithAddresses(packet, from, localAddress);
+}
+
+CamCryptoSinkHelper::CamCryptoSinkHelper(uint16_t port, CryptoEngine engine)
+{
+    m_factory.SetTypeId(CamCryptoSink::GetTypeId());
+    m_factory.Set("Port", UintegerValue(port));
+    m_factory.Set("EncryptType", UintegerValue(static_cast<uint16_t>(engine)));
+}
+
+ApplicationContainer
+CamCryptoSinkHelper::Install(NodeContainer c) const
+{
+    ApplicationContainer apps;
+    for (auto i = c.Begin(); i != c.End(); ++i)
+    {
+        Ptr<CamCryptoSink> app = m_factory.Create<CamCryptoSink>();
+        app->SetCostModel(m_costModel);
+        app->SetCompressor(m_compressor);
+        (*i)->AddApplication(app);
+        apps.Add(app);
+    }
+    return apps;
+}
+
+void
+CamCryptoSinkHelper::SetCostModel(std::shared_ptr<const CryptoCostModel> model)
+{
+    m_costModel = model;
+}
+
+void
+CamCryptoSinkHelper::SetCompressor(std::shared_ptr<const PayloadCompressor> compressor)
+{
+    m_compressor = compressor;
+}
+
+void
+CamCryptoSinkHelper::SetAttribute(std::string name, const AttributeValue& value)
+{
+    m_factory.Set(name, value);
+}
+
+} // namespace ns3
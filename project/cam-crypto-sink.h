@@ -0,0 +1,182 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+
+// SPDX-License-Identifier: GPL-2.0-only
+
+#ifndef CAM_CRYPTO_SINK_H
+#define CAM_CRYPTO_SINK_H
+
+#include "crypto_cost_model.h"
+#include "crypto_engine.h"
+#include "payload_compressor.h"
+
+#include <ns3/application.h>
+#include <ns3/application-container.h>
+#include <ns3/node-container.h>
+#include <ns3/nstime.h>
+#include <ns3/object-factory.h>
+#include <ns3/ptr.h>
+#include <ns3/socket.h>
+#include <ns3/traced-callback.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace ns3
+{
+
+/**
+ * \brief Receiver application that decrypts every CAM packet it receives.
+ *
+ * It listens on a UDP port like UdpEchoServer, but instead of echoing the
+ * payload back it decrypts it with the configured engine, validates the
+ * recovered CAMs by parsing them back into fields (CamParser) and records
+ * the wall-clock decrypt and parse latencies of each packet.
+ * The RxWithAddresses trace has the same signature as the one of
+ * UdpEchoServer, so it can be hooked to the same packet trace sinks.
+ *
+ * With a cost model set, the payload is not decrypted. The node's crypto
+ * processor is instead kept busy for the modelled decrypt delay, packets
+ * queue behind each other, and RxWithAddresses fires only when the
+ * decryption of the packet completes in simulated time.
+ */
+class CamCryptoSink : public Application
+{
+  public:
+    /**
+     * \brief Get the type ID.
+     * \return the object TypeId
+     */
+    static TypeId GetTypeId();
+
+    /**
+     * \brief CamCryptoSink constructor
+     */
+    CamCryptoSink();
+
+    /**
+     * \brief CamCryptoSink destructor
+     */
+    ~CamCryptoSink() override;
+
+    /**
+     * \brief Decryption result of one received packet
+     */
+    struct RxCryptoEntry
+    {
+        double rxTime{0.0};       //!< simulation time of the reception in seconds
+        std::string srcIp;        //!< IP address of the transmitter
+        uint32_t pktSize{0};      //!< size of the received payload
+        double decryptTime{0.0};  //!< wall-clock decrypt latency in seconds
+        std::size_t declength{0}; //!< length of the recovered plaintext
+        bool valid{false};        //!< true if the plaintext holds well formed CAMs
+        double queueTime{0.0};    //!< time waited for the crypto processor in seconds
+        bool modelled{false};     //!< true if decryptTime comes from the cost model
+        uint32_t cams{0};         //!< number of CAMs parsed from the plaintext
+        double parseTime{0.0};    //!< wall-clock CAM parse latency in seconds
+    };
+
+    /**
+     * \brief Use a cost model instead of decrypting the payload
+     * \param model The calibrated model, or nullptr to decrypt for real
+     */
+    void SetCostModel(std::shared_ptr<const CryptoCostModel> model);
+
+    /**
+     * \brief Decompress the decrypted payload before parsing it
+     * \param compressor The compressor of the senders, or nullptr if they
+     *        do not compress
+     */
+    void SetCompressor(std::shared_ptr<const PayloadCompressor> compressor);
+
+    /**
+     * \brief Get the decryption results of all the packets received so far
+     * \return The per packet entries, in reception order
+     */
+    const std::vector<RxCryptoEntry>& GetEntries() const;
+
+  private:
+    void StartApplication() override;
+    void StopApplication() override;
+
+    /**
+     * \brief Handle a packet reception.
+     * \param socket the socket the packet was received to.
+     */
+    void HandleRead(Ptr<Socket> socket);
+
+    /**
+     * \brief Hand a packet to the application once its decryption completed
+     * \param packet the received packet
+     * \param from the address of the sender
+     * \param localAddress the address the packet was received on
+     */
+    void Deliver(Ptr<const Packet> packet, Address from, Address localAddress);
+
+    uint16_t m_port{0};                                    //!< Port on which we listen for packets
+    uint16_t m_encryptType{0};                             //!< CryptoEngine used to decrypt
+    bool m_binaryCam{false};                               //!< Plaintext holds binary CAMs
+    bool m_fillTerminator{true};                           //!< Drop the SetFill string terminator
+    Ptr<Socket> m_socket;                                  //!< IPv4 Socket
+    Ptr<Socket> m_socket6;                                 //!< IPv6 Socket
+    std::vector<RxCryptoEntry> m_entries;                  //!< Per packet decryption results
+    std::shared_ptr<const CryptoCostModel> m_costModel;    //!< Modelled crypto costs, if any
+    std::shared_ptr<const PayloadCompressor> m_compressor; //!< Compression stage, if any
+    Time m_cryptoBusyUntil;                                //!< End of the last modelled decryption
+
+    /// Callbacks for tracing the packet Rx events, includes source and destination addresses
+    TracedCallback<Ptr<const Packet>, const Address&, const Address&> m_rxTraceWithAddresses;
+};
+
+/**
+ * \brief Create CamCryptoSink applications and install them on nodes.
+ */
+class CamCryptoSinkHelper
+{
+  public:
+    /**
+     * \brief Create a CamCryptoSinkHelper
+     * \param port The port the sinks will listen on
+     * \param engine The engine used to decrypt the received payload
+     */
+    CamCryptoSinkHelper(uint16_t port, CryptoEngine engine);
+
+    /**
+     * \brief Install a CamCryptoSink on each node of the input container
+     * \param c The nodes on which to install the application
+     * \return The applications created, one per input node
+     */
+    ApplicationContainer Install(NodeContainer c) const;
+
+    /**
+     * \brief Set the cost model handed to every installed application
+     * \param model The calibrated model, or nullptr to decrypt for real
+     *
+     * \see CamCryptoSink::SetCostModel
+     */
+    void SetCostModel(std::shared_ptr<const CryptoCostModel> model);
+
+    /**
+     * \brief Set the compressor handed to every installed application
+     * \param compressor The compressor of the senders, or nullptr
+     *
+     * \see CamCryptoSink::SetCompressor
+     */
+    void SetCompressor(std::shared_ptr<const PayloadCompressor> compressor);
+
+    /**
+     * \brief Record an attribute to be set in each application after it is created
+     * \param name the name of the attribute to set
+     * \param value the value of the attribute to set
+     */
+    void SetAttribute(std::string name, const AttributeValue& value);
+
+  private:
+    ObjectFactory m_factory;                               //!< Object factory.
+    std::shared_ptr<const CryptoCostModel> m_costModel;    //!< Model given to the sinks
+    std::shared_ptr<const PayloadCompressor> m_compressor; //!< Compressor given to the sinks
+};
+
+} // namespace ns3
+
+#endif // CAM_CRYPTO_SINK_H
@@ -0,0 +1,105 @@
+#include "cam_codec.h"
+
+#include <array>
+#include <charconv>
+#include <cstring>
+#include <utility>
+
+namespace {
+
+    template <typename... Fields>
+    void encode_fields(const Cam& cam, std::byte* out, std::tuple<Fields...>*) {
+        ((Fields::encode(cam, out), out += Fields::size), ...);
+    }
+
+    template <typename... Fields>
+    void decode_fields(const std::byte* in, Cam& cam, std::tuple<Fields...>*) {
+        ((Fields::decode(in, cam), in += Fields::size), ...);
+    }
+
+    constexpr cam_codec::Schema* schema = nullptr;
+
+    // Appends a label, then a value through std::to_chars. The buffer is
+    // sized for the worst case, so the conversions cannot run out of room.
+    struct TextWriter {
+        char* pos;
+        char* end;
+
+        void label(std::string_view text) {
+            std::memcpy(pos, text.data(), text.size());
+            pos += text.size();
+        }
+        template <typename Int>
+        void integer(Int value) {
+            pos = std::to_chars(pos, end, value).ptr;
+        }
+        void fixed(double value, int precision) {
+            pos = std::to_chars(pos, end, value, std::chars_format::fixed, precision).ptr;
+        }
+    };
+
+} // namespace
+
+void encode_cam(const Cam& cam, std::span<std::byte, CAM_BINARY_SIZE> out) {
+    out[0] = CAM_BINARY_VERSION;
+    encode_fields(cam, out.data() + 1, schema);
+}
+
+std::optional<Cam> decode_cam(std::span<const std::byte, CAM_BINARY_SIZE> in) {
+    if (in[0] != CAM_BINARY_VERSION) return std::nullopt;
+    Cam cam;
+    decode_fields(in.data() + 1, cam, schema);
+    return cam;
+}
+
+std::string encode_cams(const std::vector<Cam>& cams) {
+    std::string out(cams.size() * CAM_BINARY_SIZE, '\0');
+    auto bytes = std::as_writable_bytes(std::span(out));
+    for (std::size_t i = 0; i < cams.size(); ++i) {
+        encode_cam(cams[i], bytes.subspan(i * CAM_BINARY_SIZE).first<CAM_BINARY_SIZE>());
+    }
+    return out;
+}
+
+std::optional<std::vector<Cam>> decode_cams(std::string_view bytes) {
+    if (bytes.empty() || bytes.size() % CAM_BINARY_SIZE != 0) return std::nullopt;
+
+    auto in = std::as_bytes(std::span(bytes));
+    std::vector<Cam> cams;
+    cams.reserve(bytes.size() / CAM_BINARY_SIZE);
+    for (std::size_t offset = 0; offset < in.size(); offset += CAM_BINARY_SIZE) {
+        auto cam = decode_cam(in.subspan(offset).first<CAM_BINARY_SIZE>());
+        if (!cam) return std::nullopt;
+        cams.push_back(*cam);
+    }
+    return cams;
+}
+
+std::size_t format_cam_to(const Cam& cam, std::span<char, CAM_TEXT_MAX> out) {
+    // Same digits as the iostream format it replaces: fixed, 6 decimals for
+    // the position and 1 for everything from the altitude on.
+    TextWriter w{out.data(), out.data() + out.size()};
+    w.label("CAM,StationID=");
+    w.integer(cam.station_id);
+    w.label(",Time=");
+    w.integer(cam.time);
+    w.label(",Lat=");
+    w.fixed(cam.lat, 6);
+    w.label(",Lon=");
+    w.fixed(cam.lon, 6);
+    w.label(",Alt=");
+    w.fixed(cam.alt, 1);
+    w.label(",Speed=");
+    w.fixed(cam.speed, 1);
+    w.label(",Heading=");
+    w.fixed(cam.heading, 1);
+    w.label(",Acc=");
+    w.fixed(cam.acc, 1);
+    w.label("\n");
+    return static_cast<std::size_t>(w.pos - out.data());
+}
+
+std::string format_cam(const Cam& cam) {
+    std::array<char, CAM_TEXT_MAX> buffer;
+    return std::string(buffer.data(), format_cam_to(cam, buffer));
+}
@@ -0,0 +1,137 @@
+#ifndef CAM_CODEC_H
+#define CAM_CODEC_H
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <vector>
+
+// One CAM, with the fields of the text format in physical units.
+struct Cam {
+    uint32_t station_id = 0;
+    int32_t time = 0;
+    double lat = 0.0;     // degrees
+    double lon = 0.0;     // degrees
+    double alt = 0.0;     // metres
+    double speed = 0.0;   // m/s
+    double heading = 0.0; // degrees, [0, 360)
+    double acc = 0.0;     // longitudinal acceleration, m/s^2
+};
+
+namespace cam_codec {
+
+    // Big-endian (network order) integer stores, independent of the host.
+    template <typename Raw>
+    void store(Raw value, std::byte* out) {
+        using U = std::make_unsigned_t<Raw>;
+        U u = static_cast<U>(value);
+        for (std::size_t i = 0; i < sizeof(Raw); ++i) {
+            out[i] = static_cast<std::byte>(u >> (8 * (sizeof(Raw) - 1 - i)));
+        }
+    }
+
+    template <typename Raw>
+    Raw load(const std::byte* in) {
+        using U = std::make_unsigned_t<Raw>;
+        U u = 0;
+        for (std::size_t i = 0; i < sizeof(Raw); ++i) {
+            u = static_cast<U>((u << 8) | static_cast<U>(in[i]));
+        }
+        return static_cast<Raw>(u);
+    }
+
+    // A field stored as is.
+    template <auto Member, typename Raw>
+    struct Integer {
+        static constexpr std::size_t size = sizeof(Raw);
+
+        static Raw quantize(const Cam& cam) { return static_cast<Raw>(cam.*Member); }
+        static void dequantize(Raw raw, Cam& cam) {
+            cam.*Member = static_cast<std::remove_reference_t<decltype(cam.*Member)>>(raw);
+        }
+
+        static void encode(const Cam& cam, std::byte* out) { store<Raw>(quantize(cam), out); }
+        static void decode(const std::byte* in, Cam& cam) { dequantize(load<Raw>(in), cam); }
+    };
+
+    // A physical value stored as round(value * Scale), saturated to Raw.
+    template <auto Member, typename Raw, int64_t Scale>
+    struct FixedPoint {
+        static constexpr std::size_t size = sizeof(Raw);
+
+        static Raw quantize(const Cam& cam) {
+            double scaled = std::round(cam.*Member * static_cast<double>(Scale));
+            constexpr double lo = static_cast<double>(std::numeric_limits<Raw>::min());
+            constexpr double hi = static_cast<double>(std::numeric_limits<Raw>::max());
+            scaled = scaled < lo ? lo : (scaled > hi ? hi : scaled);
+            return static_cast<Raw>(scaled);
+        }
+        static void dequantize(Raw raw, Cam& cam) {
+            cam.*Member = static_cast<double>(raw) / static_cast<double>(Scale);
+        }
+
+        static void encode(const Cam& cam, std::byte* out) { store<Raw>(quantize(cam), out); }
+        static void decode(const std::byte* in, Cam& cam) { dequantize(load<Raw>(in), cam); }
+    };
+
+    // Binary schema, in wire order. Resolutions follow the ETSI CAM
+    // (EN 302 637-2) data elements where one exists: 0.1 microdegree
+    // positions, 0.01 m altitude, 0.01 m/s speed, 0.1 degree heading and
+    // 0.1 m/s^2 acceleration.
+    using Schema = std::tuple<Integer<&Cam::station_id, uint32_t>,
+                              Integer<&Cam::time, int32_t>,
+                              FixedPoint<&Cam::lat, int32_t, 10'000'000>,
+                              FixedPoint<&Cam::lon, int32_t, 10'000'000>,
+                              FixedPoint<&Cam::alt, int32_t, 100>,
+                              FixedPoint<&Cam::speed, uint16_t, 100>,
+                              FixedPoint<&Cam::heading, uint16_t, 10>,
+                              FixedPoint<&Cam::acc, int16_t, 10>>;
+
+    template <typename Tuple>
+    struct SchemaSize;
+    template <typename... Fields>
+    struct SchemaSize<std::tuple<Fields...>> {
+        static constexpr std::size_t value = (Fields::size + ...);
+    };
+
+} // namespace cam_codec
+
+// First byte of every binary CAM, so a receiver can tell the format and
+// version apart from a text CAM (which starts with 'C').
+constexpr std::byte CAM_BINARY_VERSION{0x01};
+
+// Size of one binary CAM: version byte plus the schema fields.
+constexpr std::size_t CAM_BINARY_SIZE = 1 + cam_codec::SchemaSize<cam_codec::Schema>::value;
+
+// Writes one CAM into exactly CAM_BINARY_SIZE bytes.
+void encode_cam(const Cam& cam, std::span<std::byte, CAM_BINARY_SIZE> out);
+
+// Reads one CAM; std::nullopt if the version byte does not match.
+std::optional<Cam> decode_cam(std::span<const std::byte, CAM_BINARY_SIZE> in);
+
+// Concatenated binary CAMs, the binary counterpart of a text bundle.
+std::string encode_cams(const std::vector<Cam>& cams);
+
+// Splits a bundle back into CAMs; std::nullopt if it is not a whole number
+// of valid binary CAMs.
+std::optional<std::vector<Cam>> decode_cams(std::string_view bytes);
+
+// Upper bound of one text CAM line: the labels plus the longest
+// fixed-notation rendering of six finite doubles.
+constexpr std::size_t CAM_TEXT_MAX = 2048;
+
+// Writes the text line of one CAM, as written by generate_messages, with
+// std::to_chars. Returns the number of characters written.
+std::size_t format_cam_to(const Cam& cam, std::span<char, CAM_TEXT_MAX> out);
+
+// Text line of one CAM, as written by generate_messages.
+std::string format_cam(const Cam& cam);
+
+#endif // CAM_CODEC_H
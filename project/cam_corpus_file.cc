@@ -0,0 +1,201 @@
+#include "cam_corpus_file.h"
+
+#include "cam_codec.h"
+
+#include <array>
+#include <cstring>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+    constexpr char MAGIC[8] = {'V', '2', 'X', 'C', 'A', 'M', 'S', '\0'};
+    constexpr std::size_t HEADER_SIZE = 40;
+    constexpr std::size_t V1_HEADER_SIZE = 32;
+    constexpr std::size_t RECORD_HEADER_SIZE = 8;
+
+    using cam_codec::load;
+    using cam_codec::store;
+
+    std::array<std::byte, HEADER_SIZE> make_header(const CamCorpusInfo& info, uint64_t count,
+                                                   uint64_t index_offset) {
+        std::array<std::byte, HEADER_SIZE> h{};
+        std::memcpy(h.data(), MAGIC, sizeof(MAGIC));
+        store<uint16_t>(CAM_CORPUS_VERSION, h.data() + 8);
+        h[10] = std::byte{info.binary_cams ? uint8_t{1} : uint8_t{0}};
+        h[11] = static_cast<std::byte>(info.engine);
+        store<uint64_t>(count, h.data() + 16);
+        store<uint64_t>(index_offset, h.data() + 24);
+        store<uint64_t>(info.key_seed, h.data() + 32);
+        return h;
+    }
+
+} // namespace
+
+CamCorpusWriter::~CamCorpusWriter() {
+    if (file_) std::fclose(file_);
+}
+
+bool CamCorpusWriter::open(const std::string& path, const CamCorpusInfo& info) {
+    if (file_) std::fclose(file_);
+    file_ = std::fopen(path.c_str(), "wb");
+    info_ = info;
+    offsets_.clear();
+    position_ = 0;
+    ok_ = file_ != nullptr;
+
+    // Zero record count and index offset until close(), so a corpus left
+    // half written is rejected by the reader.
+    auto header = make_header(info_, 0, 0);
+    return write(header.data(), header.size());
+}
+
+bool CamCorpusWriter::append(std::string_view plain, std::string_view wire) {
+    if (plain.size() > UINT32_MAX || wire.size() > UINT32_MAX) return ok_ = false;
+
+    std::byte lengths[RECORD_HEADER_SIZE];
+    store<uint32_t>(static_cast<uint32_t>(plain.size()), lengths);
+    store<uint32_t>(static_cast<uint32_t>(wire.size()), lengths + 4);
+
+    offsets_.push_back(position_);
+    return write(lengths, sizeof(lengths)) && write(plain.data(), plain.size()) &&
+           write(wire.data(), wire.size());
+}
+
+bool CamCorpusWriter::close() {
+    if (!file_) return false;
+
+    const uint64_t index_offset = position_;
+    std::byte entry[8];
+    for (uint64_t offset : offsets_) {
+        store<uint64_t>(offset, entry);
+        write(entry, sizeof(entry));
+    }
+
+    auto header = make_header(info_, offsets_.size(), index_offset);
+    if (std::fseek(file_, 0, SEEK_SET) != 0) ok_ = false;
+    write(header.data(), header.size());
+
+    if (std::fclose(file_) != 0) ok_ = false;
+    file_ = nullptr;
+    return ok_;
+}
+
+bool CamCorpusWriter::write(const void* data, std::size_t size) {
+    if (!ok_) return false;
+    if (size > 0 && std::fwrite(data, 1, size, file_) != size) return ok_ = false;
+    position_ += size;
+    return true;
+}
+
+CamCorpusFile::~CamCorpusFile() {
+    unmap();
+}
+
+CamCorpusFile::CamCorpusFile(CamCorpusFile&& other) noexcept {
+    *this = std::move(other);
+}
+
+CamCorpusFile& CamCorpusFile::operator=(CamCorpusFile&& other) noexcept {
+    if (this != &other) {
+        unmap();
+        data_ = std::exchange(other.data_, nullptr);
+        length_ = std::exchange(other.length_, 0);
+        index_ = std::exchange(other.index_, nullptr);
+        count_ = std::exchange(other.count_, 0);
+        info_ = other.info_;
+        error_ = std::move(other.error_);
+    }
+    return *this;
+}
+
+void CamCorpusFile::unmap() {
+    if (data_) munmap(const_cast<std::byte*>(data_), length_);
+    data_ = nullptr;
+    length_ = 0;
+    index_ = nullptr;
+    count_ = 0;
+}
+
+bool CamCorpusFile::fail(std::string reason) {
+    unmap();
+    error_ = std::move(reason);
+    return false;
+}
+
+bool CamCorpusFile::open(const std::string& path) {
+    unmap();
+    error_.clear();
+
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) return fail("can't open " + path);
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size < static_cast<off_t>(V1_HEADER_SIZE)) {
+        ::close(fd);
+        return fail(path + " is too short for a corpus header");
+    }
+    void* map = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (map == MAP_FAILED) return fail("can't map " + path);
+    data_ = static_cast<const std::byte*>(map);
+    length_ = static_cast<std::size_t>(st.st_size);
+
+    if (std::memcmp(data_, MAGIC, sizeof(MAGIC)) != 0) return fail(path + " is not a CAM corpus");
+    const uint16_t version = load<uint16_t>(data_ + 8);
+    if (version != 1 && version != CAM_CORPUS_VERSION) {
+        return fail(path + " has an unsupported corpus version");
+    }
+    const std::size_t header_size = version == 1 ? V1_HEADER_SIZE : HEADER_SIZE;
+    if (length_ < header_size) return fail(path + " is too short for a corpus header");
+    const auto format = static_cast<uint8_t>(data_[10]);
+    const auto engine = static_cast<uint8_t>(data_[11]);
+    if (format > 1 || engine > static_cast<uint8_t>(CryptoEngine::He)) {
+        return fail(path + " has an unknown CAM format or engine");
+    }
+    info_.binary_cams = format == 1;
+    info_.engine = static_cast<CryptoEngine>(engine);
+    info_.key_seed = version == 1 ? 0 : load<uint64_t>(data_ + 32);
+    if (version == 1 && encrypted()) {
+        return fail(path + " holds wire bytes of keys that were not stored; write it again");
+    }
+
+    const uint64_t count = load<uint64_t>(data_ + 16);
+    const uint64_t index_offset = load<uint64_t>(data_ + 24);
+    if (index_offset < header_size || index_offset > length_ ||
+        (length_ - index_offset) / 8 != count || (length_ - index_offset) % 8 != 0) {
+        return fail(path + " has a truncated or incomplete index");
+    }
+
+    // Every record has to lie between the header and the index, so
+    // operator[] can return views without further checks.
+    const std::byte* index = data_ + index_offset;
+    for (uint64_t i = 0; i < count; ++i) {
+        const uint64_t offset = load<uint64_t>(index + i * 8);
+        if (offset < header_size || offset > index_offset ||
+            index_offset - offset < RECORD_HEADER_SIZE) {
+            return fail(path + " has a record outside the data section");
+        }
+        const uint64_t bytes = uint64_t{load<uint32_t>(data_ + offset)} +
+                               load<uint32_t>(data_ + offset + 4);
+        if (bytes > index_offset - offset - RECORD_HEADER_SIZE) {
+            return fail(path + " has a record outside the data section");
+        }
+    }
+
+    index_ = index;
+    count_ = static_cast<std::size_t>(count);
+    madvise(map, length_, MADV_SEQUENTIAL);
+    return true;
+}
+
+CamCorpusFile::Record CamCorpusFile::operator[](std::size_t i) const {
+    const std::byte* record = data_ + load<uint64_t>(index_ + i * 8);
+    const uint32_t plain = load<uint32_t>(record);
+    const uint32_t wire = load<uint32_t>(record + 4);
+    const char* bytes = reinterpret_cast<const char*>(record + RECORD_HEADER_SIZE);
+    return {{bytes, plain}, {bytes + plain, wire}};
+}
@@ -0,0 +1,106 @@
+#ifndef CAM_CORPUS_FILE_H
+#define CAM_CORPUS_FILE_H
+
+#include "crypto_engine.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// CAM corpus files: a recorded sequence of CAM payloads (each one a bundle
+// as sent by a TX node), optionally with their ciphertext for one engine, so
+// runs can replay the same workload without generating or encrypting it.
+//
+// Layout, integers big-endian:
+//   header  magic "V2XCAMS\0", u16 version, u8 CAM format (0 text,
+//           1 binary), u8 engine (CryptoEngine; None if not encrypted),
+//           u32 reserved, u64 record count, u64 index offset, u64 key seed
+//           (engine_set_key_seed of the wire bytes)
+//   records u32 plain length, u32 wire length, plain bytes, wire bytes
+//   index   u64 offset of every record, in order
+//
+// Files are read through mmap and records are returned as views into the
+// mapping, so opening a corpus costs one pass over the index.
+//
+// Version 1 files have no key seed (32 byte header); their wire bytes were
+// encrypted with keys that were never stored, so only the unencrypted ones
+// are still accepted.
+
+constexpr uint16_t CAM_CORPUS_VERSION = 2;
+
+struct CamCorpusInfo {
+    bool binary_cams = false;               // cam_codec records instead of text lines
+    CryptoEngine engine = CryptoEngine::None; // engine of the wire bytes, if any
+    uint64_t key_seed = 0;                    // engine_set_key_seed of the wire bytes
+};
+
+class CamCorpusWriter {
+  public:
+    CamCorpusWriter() = default;
+    ~CamCorpusWriter();
+
+    CamCorpusWriter(const CamCorpusWriter&) = delete;
+    CamCorpusWriter& operator=(const CamCorpusWriter&) = delete;
+
+    // Creates (or truncates) the file. Returns false if it can't be written.
+    bool open(const std::string& path, const CamCorpusInfo& info);
+
+    // Appends one payload and, for encrypted corpora, its wire bytes.
+    bool append(std::string_view plain, std::string_view wire = {});
+
+    // Writes the index and the final header. Returns false on any write
+    // error since open; the file is then incomplete and fails to load.
+    bool close();
+
+  private:
+    bool write(const void* data, std::size_t size);
+
+    std::FILE* file_ = nullptr;
+    CamCorpusInfo info_;
+    std::vector<uint64_t> offsets_;
+    uint64_t position_ = 0;
+    bool ok_ = false;
+};
+
+class CamCorpusFile {
+  public:
+    struct Record {
+        std::string_view plain;
+        std::string_view wire; // empty unless the corpus is encrypted
+    };
+
+    CamCorpusFile() = default;
+    ~CamCorpusFile();
+
+    CamCorpusFile(CamCorpusFile&& other) noexcept;
+    CamCorpusFile& operator=(CamCorpusFile&& other) noexcept;
+    CamCorpusFile(const CamCorpusFile&) = delete;
+    CamCorpusFile& operator=(const CamCorpusFile&) = delete;
+
+    // Maps the file and checks the header and every index entry. Returns
+    // false, with the reason in error(), if it is not a valid corpus.
+    bool open(const std::string& path);
+
+    const std::string& error() const { return error_; }
+    const CamCorpusInfo& info() const { return info_; }
+    bool encrypted() const { return info_.engine != CryptoEngine::None; }
+
+    std::size_t size() const { return count_; }
+    Record operator[](std::size_t i) const;
+
+  private:
+    void unmap();
+    bool fail(std::string reason);
+
+    const std::byte* data_ = nullptr;
+    std::size_t length_ = 0;
+    const std::byte* index_ = nullptr;
+    std::size_t count_ = 0;
+    CamCorpusInfo info_;
+    std::string error_;
+};
+
+#endif // CAM_CORPUS_FILE_H
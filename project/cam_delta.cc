@@ -0,0 +1,150 @@
+#include "cam_delta.h"
+
+#include <optional>
+#include <tuple>
+#include <type_traits>
+
+namespace {
+
+    // The schema starts with the station id, which identifies the stream
+    // and is never delta coded; the remaining fields are.
+    template <typename StationId, typename... Fields>
+    CamDeltaFields quantize_fields(const Cam& cam, std::tuple<StationId, Fields...>*) {
+        static_assert(sizeof...(Fields) == std::tuple_size_v<CamDeltaFields>);
+        return {static_cast<int64_t>(Fields::quantize(cam))...};
+    }
+
+    template <typename StationId, typename... Fields>
+    void dequantize_fields(const CamDeltaFields& raw, Cam& cam, std::tuple<StationId, Fields...>*) {
+        std::size_t i = 0;
+        (Fields::dequantize(static_cast<decltype(Fields::quantize(cam))>(raw[i++]), cam), ...);
+    }
+
+    constexpr cam_codec::Schema* schema = nullptr;
+
+    void put_varint(uint64_t value, std::string& out) {
+        while (value >= 0x80) {
+            out.push_back(static_cast<char>((value & 0x7f) | 0x80));
+            value >>= 7;
+        }
+        out.push_back(static_cast<char>(value));
+    }
+
+    void put_zigzag(int64_t value, std::string& out) {
+        put_varint((static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63), out);
+    }
+
+    std::optional<uint64_t> get_varint(std::string_view& in) {
+        uint64_t value = 0;
+        for (int shift = 0; shift < 64; shift += 7) {
+            if (in.empty()) return std::nullopt;
+            const auto byte = static_cast<uint8_t>(in.front());
+            in.remove_prefix(1);
+            value |= uint64_t{byte & 0x7fu} << shift;
+            if ((byte & 0x80) == 0) return value;
+        }
+        return std::nullopt;
+    }
+
+    std::optional<int64_t> get_zigzag(std::string_view& in) {
+        auto v = get_varint(in);
+        if (!v) return std::nullopt;
+        return static_cast<int64_t>((*v >> 1) ^ (~(*v & 1) + 1));
+    }
+
+} // namespace
+
+CamDeltaEncoder::CamDeltaEncoder(uint32_t keyframe_interval, bool optimistic)
+    : keyframe_interval_(keyframe_interval == 0 ? 1 : keyframe_interval),
+      optimistic_(optimistic) {}
+
+std::string CamDeltaEncoder::encode(std::span<const Cam> cams) {
+    std::string out;
+    out.reserve(1 + cams.size() * 16);
+    out.push_back(static_cast<char>(CAM_DELTA_VERSION));
+
+    for (const Cam& cam : cams) {
+        Station& st = stations_[cam.station_id];
+        const uint32_t seq = st.next_seq++;
+        const CamDeltaFields fields = quantize_fields(cam, schema);
+
+        // The reference has to still be in the receiver's history window.
+        const bool keyframe = !st.has_ref || seq - st.last_keyframe >= keyframe_interval_ ||
+                              seq - st.ref_seq >= CAM_DELTA_HISTORY;
+        const uint32_t back = keyframe ? 0 : seq - st.ref_seq;
+
+        put_varint(cam.station_id, out);
+        put_varint(seq, out);
+        put_varint(back, out);
+        for (std::size_t f = 0; f < fields.size(); ++f) {
+            put_zigzag(keyframe ? fields[f] : fields[f] - st.ref[f], out);
+        }
+
+        if (keyframe) st.last_keyframe = seq;
+        st.sent[seq % CAM_DELTA_HISTORY] = {seq, fields};
+        if (optimistic_) acknowledge({cam.station_id, seq});
+    }
+    return out;
+}
+
+void CamDeltaEncoder::acknowledge(const CamDeltaAck& ack) {
+    auto it = stations_.find(ack.station_id);
+    if (it == stations_.end()) return;
+    Station& st = it->second;
+
+    const auto& [seq, fields] = st.sent[ack.seq % CAM_DELTA_HISTORY];
+    if (seq != ack.seq || ack.seq >= st.next_seq) return;
+    if (st.has_ref && ack.seq <= st.ref_seq) return; // older than the current reference
+    st.ref_seq = seq;
+    st.ref = fields;
+    st.has_ref = true;
+}
+
+bool CamDeltaDecoder::decode(std::string_view bundle, std::vector<Cam>& out,
+                             std::vector<CamDeltaAck>* acks) {
+    if (bundle.empty() || static_cast<std::byte>(bundle.front()) != CAM_DELTA_VERSION) {
+        return false;
+    }
+    bundle.remove_prefix(1);
+    if (bundle.empty()) return false; // a packet carries at least one CAM
+
+    while (!bundle.empty()) {
+        auto station = get_varint(bundle);
+        auto seq = get_varint(bundle);
+        auto back = get_varint(bundle);
+        if (!station || !seq || !back || *station > UINT32_MAX || *seq > UINT32_MAX ||
+            *back >= CAM_DELTA_HISTORY || *back > *seq) {
+            return false;
+        }
+
+        CamDeltaFields fields;
+        for (auto& f : fields) {
+            auto v = get_zigzag(bundle);
+            if (!v) return false;
+            f = *v;
+        }
+
+        Station& st = stations_[static_cast<uint32_t>(*station)];
+        if (*back != 0) {
+            const uint64_t ref = *seq - *back;
+            const std::size_t slot = ref % CAM_DELTA_HISTORY;
+            if (!st.valid[slot] || st.history[slot].first != ref) {
+                // Neither stored nor acked: later deltas referring to it
+                // are skipped as well, until the station's next keyframe.
+                ++missing_references_;
+                continue;
+            }
+            for (std::size_t f = 0; f < fields.size(); ++f) fields[f] += st.history[slot].second[f];
+        }
+        const std::size_t slot = *seq % CAM_DELTA_HISTORY;
+        st.history[slot] = {static_cast<uint32_t>(*seq), fields};
+        st.valid[slot] = true;
+
+        Cam cam;
+        cam.station_id = static_cast<uint32_t>(*station);
+        dequantize_fields(fields, cam, schema);
+        out.push_back(cam);
+        if (acks) acks->push_back({cam.station_id, static_cast<uint32_t>(*seq)});
+    }
+    return true;
+}
@@ -0,0 +1,106 @@
+#ifndef CAM_DELTA_H
+#define CAM_DELTA_H
+
+#include "cam_codec.h"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+// Per-station delta compression of CAMs, applied before encryption.
+//
+// Every field is quantized to the fixed-point resolution of the binary
+// schema (cam_codec::Schema), so a delta bundle decodes to exactly the CAMs
+// a binary bundle would. A CAM is sent either as a keyframe (absolute
+// values) or as the difference to an earlier CAM of the same station that
+// the receiver is known to hold, all as LEB128 varints (zigzag for signed
+// values). Consecutive CAMs of a vehicle differ by a few units of the last
+// digit, so most deltas take one byte per field.
+//
+// Only crypto_bench (--delta) uses it so far: the TX applications of eris
+// send one payload, set once with SetFill, over and over, so there is no
+// stream of changing CAMs per station to delta code in the simulation.
+//
+// Bundle layout: CAM_DELTA_VERSION, then per CAM
+//   station id, sequence number, back (0: keyframe, else the reference is
+//   sequence number - back), 7 zigzag values (time, lat, lon, alt, speed,
+//   heading, acc)
+
+// First byte of a delta bundle; text CAMs start with 'C' and binary ones
+// with CAM_BINARY_VERSION.
+constexpr std::byte CAM_DELTA_VERSION{0x02};
+
+// Number of past CAMs per station a decoder keeps to resolve references.
+constexpr uint32_t CAM_DELTA_HISTORY = 8;
+
+// Fields of a CAM besides the station id, in fixed-point units.
+using CamDeltaFields = std::array<int64_t, 7>;
+
+// Receiver feedback: the station's CAM with this sequence number arrived.
+struct CamDeltaAck {
+    uint32_t station_id;
+    uint32_t seq;
+};
+
+class CamDeltaEncoder {
+  public:
+    // keyframe_interval: a station's CAM is sent as a keyframe at least
+    // every this many CAMs, so receivers that missed packets recover.
+    // optimistic: treat every CAM as acknowledged once encoded, for
+    // channels without feedback (broadcast sidelink); otherwise deltas
+    // only refer to CAMs passed to acknowledge().
+    explicit CamDeltaEncoder(uint32_t keyframe_interval = 10, bool optimistic = true);
+
+    // Encodes one bundle (as sent in one packet).
+    std::string encode(std::span<const Cam> cams);
+
+    // Marks a sent CAM as received; later deltas of the station may refer
+    // to it. Acks of unknown or too old CAMs are ignored.
+    void acknowledge(const CamDeltaAck& ack);
+
+  private:
+    struct Station {
+        uint32_t next_seq = 0;
+        uint32_t last_keyframe = 0;
+        bool has_ref = false;
+        uint32_t ref_seq = 0;
+        CamDeltaFields ref{};
+        // CAMs sent but not acknowledged yet, indexed by seq % history
+        std::array<std::pair<uint32_t, CamDeltaFields>, CAM_DELTA_HISTORY> sent{};
+    };
+
+    uint32_t keyframe_interval_;
+    bool optimistic_;
+    std::unordered_map<uint32_t, Station> stations_;
+};
+
+class CamDeltaDecoder {
+  public:
+    // Decodes one bundle, appending its CAMs to out and, if given, one ack
+    // per CAM to acks. A delta that refers to a CAM this decoder does not
+    // hold, e.g. because its packet was lost, is skipped (and counted, see
+    // missing_references) while the other CAMs of the bundle still decode.
+    // Returns false (out then holds the CAMs decoded so far) if the bundle
+    // is malformed.
+    bool decode(std::string_view bundle, std::vector<Cam>& out,
+                std::vector<CamDeltaAck>* acks = nullptr);
+
+    // CAMs skipped so far because their reference was missing.
+    uint64_t missing_references() const { return missing_references_; }
+
+  private:
+    struct Station {
+        std::array<std::pair<uint32_t, CamDeltaFields>, CAM_DELTA_HISTORY> history{};
+        std::array<bool, CAM_DELTA_HISTORY> valid{};
+    };
+
+    std::unordered_map<uint32_t, Station> stations_;
+    uint64_t missing_references_ = 0;
+};
+
+#endif // CAM_DELTA_H
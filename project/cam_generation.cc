@@ -1,14 +1,22 @@
-#include "cam_generation"
+#include "cam_generation.h"
+
+#include "philox.h"
 
 #include <random>
 #include <cstdio>
 #include <cstdlib>
 #include <numeric>
 #include <algorithm>
+#include <array>
+#include <cmath>
+#include <thread>
 #include <cstring>
-#include <sstream>
+#include <span>
+#include <stdexcept>
 #include <string>
-#include <iomanip>
+#include <iterator>
+#include <string_view>
+#include <vector>
 
 constexpr int MAX_IDS = 1000, MIN_MSG = 1, MAX_MSG = 1;
 
@@ -21,40 +29,264 @@ constexpr struct {
 constexpr double SPD = 13.4, HDG = 92.3, ACC = 0.5;
 constexpr int TIME = 171364;
 
-std::string generate_messages(int n) {
-    if (n < MIN_MSG || n > MAX_IDS) {
-        return "Error: Must be between " + std::to_string(MIN_MSG) +
-               " and " + std::to_string(MAX_IDS) + " (got " + std::to_string(n) + ").\n";
+namespace {
+
+    // Text chunks are handed out once they pass this size.
+    constexpr std::size_t CHUNK_SIZE = 64 * 1024;
+
+    // Below this many stations per drawn CAM a dense id array is cheaper
+    // than the hash map; both give the same draws.
+    constexpr uint64_t DENSE_RATIO = 4;
+
+    CamGenerator& shared_generator() {
+        static CamGenerator generator(MAX_IDS);
+        return generator;
+    }
+
+} // namespace
+
+CamGenerator::CamGenerator(uint32_t stations, uint32_t seed)
+    : stations_(stations), rng_(seed) {}
+
+template <typename Sink>
+void CamGenerator::draw(uint32_t n, Sink&& sink) {
+    if (n > stations_) {
+        throw std::invalid_argument("CamGenerator: " + std::to_string(n) +
+                                    " CAMs need as many stations, only " +
+                                    std::to_string(stations_) + " configured");
     }
 
-    static std::mt19937 rng(5489u);
     std::uniform_int_distribution<int> dt(-5, 5);
     std::uniform_real_distribution<double>
         dlat(-0.0005, 0.0005), dlon(-0.0005, 0.0005),
         dalt(-0.5, 0.5), dspd(-1.0, 1.0), dhdg(-15.0, 15.0);
 
-    int ids[MAX_IDS];
-    std::iota(ids, ids + MAX_IDS, 0);
-
-    std::ostringstream out;
+    // Partial Fisher-Yates over [0, stations): position p holds p unless a
+    // previous swap moved another id there. Positions below i are never
+    // read again, so only the swapped-in id at j has to be remembered.
+    const bool dense = static_cast<uint64_t>(n) * DENSE_RATIO >= stations_;
+    if (dense) {
+        ids_.resize(stations_);
+        std::iota(ids_.begin(), ids_.end(), 0u);
+    } else {
+        swapped_.clear();
+        swapped_.reserve(n);
+    }
+    auto at = [&](uint32_t p) {
+        if (dense) return ids_[p];
+        auto it = swapped_.find(p);
+        return it == swapped_.end() ? p : it->second;
+    };
 
-    for (int i = 0; i < n; ++i) {
-        int j = i + (rng() % (MAX_IDS - i));
-        std::swap(ids[i], ids[j]);
+    Cam cam;
+    cam.acc = ACC;
+    for (uint32_t i = 0; i < n; ++i) {
+        uint32_t j = i + static_cast<uint32_t>(rng_() % (stations_ - i));
+        uint32_t id = at(j);
+        if (dense) ids_[j] = ids_[i];
+        else swapped_[j] = at(i);
 
-        double heading = HDG + dhdg(rng);
+        double heading = HDG + dhdg(rng_);
         if (heading < 0.0) heading += 360.0;
         else if (heading >= 360.0) heading -= 360.0;
 
-        out << "CAM,StationID=" << ids[i]
-            << ",Time=" << (TIME + dt(rng))
-            << ",Lat=" << std::fixed << std::setprecision(6) << (JACKSON_GRAVE.lat + dlat(rng))
-            << ",Lon=" << std::fixed << std::setprecision(6) << (JACKSON_GRAVE.lon + dlon(rng))
-            << ",Alt=" << std::fixed << std::setprecision(1) << (JACKSON_GRAVE.alt + dalt(rng))
-            << ",Speed=" << (SPD + dspd(rng))
-            << ",Heading=" << heading
-            << ",Acc=" << ACC << "\n";
+        // Drawn in the order the text format used to print them, so the
+        // sequence of values is unchanged.
+        cam.station_id = id;
+        cam.time = TIME + dt(rng_);
+        cam.lat = JACKSON_GRAVE.lat + dlat(rng_);
+        cam.lon = JACKSON_GRAVE.lon + dlon(rng_);
+        cam.alt = JACKSON_GRAVE.alt + dalt(rng_);
+        cam.speed = SPD + dspd(rng_);
+        cam.heading = heading;
+        sink(cam);
+    }
+}
+
+void CamGenerator::generate(uint32_t n, const std::function<void(const Cam&)>& sink) {
+    draw(n, sink);
+}
+
+void CamGenerator::generate_text(uint32_t n, const std::function<void(std::string_view)>& sink) {
+    chunk_.resize(CHUNK_SIZE + CAM_TEXT_MAX);
+    std::size_t used = 0;
+    draw(n, [&](const Cam& cam) {
+        used += format_cam_to(cam, std::span(chunk_).subspan(used).first<CAM_TEXT_MAX>());
+        if (used >= CHUNK_SIZE) {
+            sink(std::string_view(chunk_.data(), used));
+            used = 0;
+        }
+    });
+    if (used) sink(std::string_view(chunk_.data(), used));
+}
+
+void CamGenerator::append_text(uint32_t n, std::string& out) {
+    out.reserve(out.size() + static_cast<std::size_t>(n) * 112); // typical line length
+    generate_text(n, [&](std::string_view chunk) { out.append(chunk); });
+}
+
+std::vector<Cam> generate_cams(int n) {
+    if (n < MIN_MSG || n > MAX_IDS) return {};
+
+    std::vector<Cam> cams;
+    cams.reserve(n);
+    shared_generator().generate(n, [&](const Cam& cam) { cams.push_back(cam); });
+    return cams;
+}
+
+std::string generate_messages(int n) {
+    if (n < MIN_MSG || n > MAX_IDS) {
+        return "Error: Must be between " + std::to_string(MIN_MSG) +
+               " and " + std::to_string(MAX_IDS) + " (got " + std::to_string(n) + ").\n";
+    }
+
+    std::string out;
+    shared_generator().append_text(n, out);
+    return out;
+}
+
+Cam deterministic_cam(uint64_t seed, uint32_t station, uint32_t step) {
+    const Philox4x32::Key key{static_cast<uint32_t>(seed), static_cast<uint32_t>(seed >> 32)};
+    const auto a = Philox4x32::generate({station, step, 0, 0}, key);
+    const auto b = Philox4x32::generate({station, step, 1, 0}, key);
+    const auto c = Philox4x32::generate({station, step, 2, 0}, key);
+
+    // Same ranges as the distributions of CamGenerator.
+    auto uniform = [](double lo, double hi, uint32_t w0, uint32_t w1) {
+        return lo + (hi - lo) * philox_unit(w0, w1);
+    };
+    const int dt = static_cast<int>((uint64_t{a[0]} * 11) >> 32) - 5; // [-5, 5]
+
+    double heading = HDG + uniform(-15.0, 15.0, c[1], c[2]);
+    if (heading < 0.0) heading += 360.0;
+    else if (heading >= 360.0) heading -= 360.0;
+
+    Cam cam;
+    cam.station_id = station;
+    cam.time = TIME + static_cast<int32_t>(step) + dt;
+    cam.lat = JACKSON_GRAVE.lat + uniform(-0.0005, 0.0005, a[1], a[2]);
+    cam.lon = JACKSON_GRAVE.lon + uniform(-0.0005, 0.0005, a[3], b[0]);
+    cam.alt = JACKSON_GRAVE.alt + uniform(-0.5, 0.5, b[1], b[2]);
+    cam.speed = SPD + uniform(-1.0, 1.0, b[3], c[0]);
+    cam.heading = heading;
+    cam.acc = ACC;
+    return cam;
+}
+
+Cam next_cam(const Cam& cam, double dt) {
+    constexpr double METRES_PER_DEGREE = 111'320.0;
+    constexpr double PI = 3.14159265358979323846;
+    const double distance = cam.speed * dt;
+    const double heading = cam.heading * PI / 180.0;
+
+    Cam next = cam;
+    next.time = cam.time + 1;
+    next.lat = cam.lat + distance * std::cos(heading) / METRES_PER_DEGREE;
+    next.lon = cam.lon + distance * std::sin(heading) /
+                             (METRES_PER_DEGREE * std::cos(cam.lat * PI / 180.0));
+    return next;
+}
+
+namespace {
+
+    // Runs work(begin, end, slice) over [0, total) split in contiguous
+    // slices, one per worker thread. The slices only depend on total and
+    // the worker count, and callers combine them in slice order.
+    template <typename Work>
+    void for_slices(uint64_t total, unsigned threads, Work work) {
+        if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+        threads = static_cast<unsigned>(std::min<uint64_t>(threads, std::max<uint64_t>(total, 1)));
+
+        std::vector<std::thread> workers;
+        const uint64_t per = total / threads, extra = total % threads;
+        uint64_t begin = 0;
+        for (unsigned t = 0; t < threads; ++t) {
+            uint64_t end = begin + per + (t < extra ? 1 : 0);
+            workers.emplace_back(work, begin, end, t);
+            begin = end;
+        }
+        for (auto& w : workers) w.join();
+    }
+
+    Cam corpus_cam(const CamCorpusSpec& spec, uint64_t index) {
+        return deterministic_cam(spec.seed, static_cast<uint32_t>(index % spec.stations),
+                                 static_cast<uint32_t>(index / spec.stations));
+    }
+
+    uint64_t corpus_size(const CamCorpusSpec& spec) {
+        return uint64_t{spec.stations} * spec.steps;
     }
 
-    return out.str();
+} // namespace
+
+std::vector<Cam> generate_cam_corpus(const CamCorpusSpec& spec, unsigned threads) {
+    std::vector<Cam> cams(corpus_size(spec));
+    for_slices(cams.size(), threads, [&](uint64_t begin, uint64_t end, unsigned) {
+        for (uint64_t i = begin; i < end; ++i) cams[i] = corpus_cam(spec, i);
+    });
+    return cams;
+}
+
+std::string generate_cam_corpus_text(const CamCorpusSpec& spec, unsigned threads) {
+    // Lines differ in length, so each worker formats its slice on its own
+    // and the slices are joined in order.
+    std::vector<std::string> slices(threads ? threads : std::max(1u, std::thread::hardware_concurrency()));
+    for_slices(corpus_size(spec), threads, [&](uint64_t begin, uint64_t end, unsigned slice) {
+        std::string& out = slices[slice];
+        out.reserve((end - begin) * 112); // typical line length
+        std::array<char, CAM_TEXT_MAX> line;
+        for (uint64_t i = begin; i < end; ++i) {
+            out.append(line.data(), format_cam_to(corpus_cam(spec, i), line));
+        }
+    });
+
+    std::size_t total = 0;
+    for (const auto& slice : slices) total += slice.size();
+    std::string text;
+    text.reserve(total);
+    for (const auto& slice : slices) text += slice;
+    return text;
+}
+
+std::string generate_cam_corpus_binary(const CamCorpusSpec& spec, unsigned threads) {
+    std::string out(corpus_size(spec) * CAM_BINARY_SIZE, '\0');
+    auto bytes = std::as_writable_bytes(std::span(out));
+    for_slices(corpus_size(spec), threads, [&](uint64_t begin, uint64_t end, unsigned) {
+        for (uint64_t i = begin; i < end; ++i) {
+            encode_cam(corpus_cam(spec, i),
+                       bytes.subspan(i * CAM_BINARY_SIZE).first<CAM_BINARY_SIZE>());
+        }
+    });
+    return out;
+}
+
+std::string generate_binary_messages(int n) {
+    return encode_cams(generate_cams(n));
+}
+
+bool validate_binary_messages(std::string_view bytes) {
+    return decode_cams(bytes).has_value();
+}
+
+bool validate_messages(std::string_view text) {
+    static constexpr std::string_view FIELDS[] = {
+        "CAM", "StationID=", "Time=", "Lat=", "Lon=", "Alt=", "Speed=", "Heading=", "Acc="};
+
+    if (text.empty() || text.back() != '\n') return false;
+
+    while (!text.empty()) {
+        size_t eol = text.find('\n');
+        std::string_view line = text.substr(0, eol);
+        text.remove_prefix(eol + 1);
+
+        for (size_t f = 0; f < std::size(FIELDS); ++f) {
+            size_t comma = line.find(',');
+            std::string_view field = line.substr(0, comma);
+            if (field.substr(0, FIELDS[f].size()) != FIELDS[f]) return false;
+            if (f > 0 && field.size() == FIELDS[f].size()) return false; // empty value
+            if ((comma == std::string_view::npos) != (f + 1 == std::size(FIELDS))) return false;
+            line.remove_prefix(comma == std::string_view::npos ? line.size() : comma + 1);
+        }
+    }
+    return true;
 }
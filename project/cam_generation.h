@@ -1,10 +1,94 @@
 #ifndef CAM_GENERATION_H
 #define CAM_GENERATION_H
 
+#include "cam_codec.h"
+
+#include <cstdint>
+#include <functional>
+#include <random>
 #include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+// Streaming CAM generator with its own RNG state.
+//
+// Station ids are drawn without replacement from [0, stations) by a sparse
+// Fisher-Yates shuffle, so memory grows with the number of CAMs drawn, not
+// with the station count, and millions of stations are fine. Text output is
+// formatted with std::to_chars into a reused chunk buffer. With the default
+// station count and seed the draws are those of generate_messages.
+class CamGenerator {
+  public:
+    explicit CamGenerator(uint32_t stations = 1000, uint32_t seed = 5489u);
+
+    uint32_t stations() const { return stations_; }
+
+    // Draws n CAMs with distinct station ids and hands each one to sink.
+    // Throws std::invalid_argument if n > stations().
+    void generate(uint32_t n, const std::function<void(const Cam&)>& sink);
+
+    // Same CAMs as text, handed to sink in chunks of whole lines.
+    void generate_text(uint32_t n, const std::function<void(std::string_view)>& sink);
+
+    // Same CAMs as text, appended to out.
+    void append_text(uint32_t n, std::string& out);
+
+  private:
+    template <typename Sink>
+    void draw(uint32_t n, Sink&& sink);
+
+    uint32_t stations_;
+    std::mt19937 rng_;
+    std::unordered_map<uint32_t, uint32_t> swapped_; // sparse shuffle state
+    std::vector<uint32_t> ids_;                      // dense shuffle state
+    std::vector<char> chunk_;
+};
+
+// A deterministic CAM corpus: one CAM per station of [0, stations) and time
+// step of [0, steps), in time-major order (all stations of step 0 first).
+struct CamCorpusSpec {
+    uint64_t seed = 5489u;
+    uint32_t stations = 1000;
+    uint32_t steps = 1;
+};
 
-// Generates n CAM-style messages as a single string.
-// Returns an error message if n is out of bounds.
+// The CAM of one station at one time step. A pure function of its
+// arguments: the values come from a Philox counter keyed by the seed, with
+// the station and step as the counter, so no RNG state is shared.
+Cam deterministic_cam(uint64_t seed, uint32_t station, uint32_t step);
+
+// The next CAM of the same vehicle, dt seconds later: one time unit on and
+// dead-reckoned along its heading at its speed, everything else unchanged.
+// Repeated calls give the smooth per-station streams real CAMs form.
+Cam next_cam(const Cam& cam, double dt = 0.1);
+
+// All CAMs of a corpus, split over threads workers (0: one per hardware
+// thread). The output is identical for every thread count.
+std::vector<Cam> generate_cam_corpus(const CamCorpusSpec& spec, unsigned threads = 0);
+
+// Same corpus as text lines or as binary CAMs.
+std::string generate_cam_corpus_text(const CamCorpusSpec& spec, unsigned threads = 0);
+std::string generate_cam_corpus_binary(const CamCorpusSpec& spec, unsigned threads = 0);
+
+// Generates n CAM-style messages as a single string, from a shared
+// CamGenerator with 1000 stations. Returns an error message if n is out of
+// bounds.
 std::string generate_messages(int n);
 
+// Generates n CAMs, drawing the same values generate_messages prints.
+// Returns an empty vector if n is out of bounds.
+std::vector<Cam> generate_cams(int n);
+
+// Generates n CAMs in the binary format of cam_codec (CAM_BINARY_SIZE
+// bytes each). Returns an empty string if n is out of bounds.
+std::string generate_binary_messages(int n);
+
+// Checks that bytes is one or more valid binary CAMs.
+bool validate_binary_messages(std::string_view bytes);
+
+// Checks that text is one or more newline-terminated CAM lines carrying
+// the fields written by generate_messages, in the same order.
+bool validate_messages(std::string_view text);
+
 #endif // CAM_GENERATION_H
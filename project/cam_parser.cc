@@ -0,0 +1,126 @@
+#include "cam_parser.h"
+
+#include <charconv>
+#include <cmath>
+#include <cstring>
+#include <system_error>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace {
+
+    // First '\n' in [p, end), or end. Lines are around 110 bytes, so the
+    // 16 byte compare finds one in about seven loads.
+    const char* find_newline(const char* p, const char* end) {
+#if defined(__SSE2__)
+        const __m128i newline = _mm_set1_epi8('\n');
+        for (; end - p >= 16; p += 16) {
+            __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+            int mask = _mm_movemask_epi8(_mm_cmpeq_epi8(block, newline));
+            if (mask != 0) return p + __builtin_ctz(static_cast<unsigned>(mask));
+        }
+#endif
+        const void* hit = std::memchr(p, '\n', static_cast<std::size_t>(end - p));
+        return hit ? static_cast<const char*>(hit) : end;
+    }
+
+    // Reads "label=value,label=value..." left to right; from_chars stops at
+    // the first character that is not part of the value, which has to be
+    // the start of the next label.
+    struct LineReader {
+        const char* pos;
+        const char* end;
+
+        bool label(std::string_view text) {
+            if (static_cast<std::size_t>(end - pos) < text.size() ||
+                std::memcmp(pos, text.data(), text.size()) != 0) {
+                return false;
+            }
+            pos += text.size();
+            return true;
+        }
+        template <typename Int>
+        bool integer(Int& value) {
+            auto [ptr, ec] = std::from_chars(pos, end, value);
+            if (ec != std::errc{} || ptr == pos) return false;
+            pos = ptr;
+            return true;
+        }
+        bool fixed(double& value) {
+            auto [ptr, ec] = std::from_chars(pos, end, value, std::chars_format::fixed);
+            if (ec != std::errc{} || ptr == pos || !std::isfinite(value)) return false;
+            pos = ptr;
+            return true;
+        }
+    };
+
+} // namespace
+
+std::optional<Cam> parse_cam_line(std::string_view line) {
+    LineReader r{line.data(), line.data() + line.size()};
+    Cam cam;
+    bool ok = r.label("CAM,StationID=") && r.integer(cam.station_id) &&
+              r.label(",Time=") && r.integer(cam.time) &&
+              r.label(",Lat=") && r.fixed(cam.lat) &&
+              r.label(",Lon=") && r.fixed(cam.lon) &&
+              r.label(",Alt=") && r.fixed(cam.alt) &&
+              r.label(",Speed=") && r.fixed(cam.speed) &&
+              r.label(",Heading=") && r.fixed(cam.heading) &&
+              r.label(",Acc=") && r.fixed(cam.acc) && r.pos == r.end;
+    if (!ok) return std::nullopt;
+    return cam;
+}
+
+CamParser::CamParser(std::string_view bundle, bool binary)
+    : rest_(bundle), binary_(binary), ok_(!bundle.empty()) {}
+
+bool CamParser::next(Cam& cam) {
+    if (!ok_ || rest_.empty()) return false;
+    ok_ = binary_ ? next_binary(cam) : next_text(cam);
+    return ok_;
+}
+
+bool CamParser::next_text(Cam& cam) {
+    const char* begin = rest_.data();
+    const char* end = begin + rest_.size();
+    const char* eol = find_newline(begin, end);
+    if (eol == end) return false; // every line, the last one too, ends in '\n'
+
+    auto parsed = parse_cam_line({begin, static_cast<std::size_t>(eol - begin)});
+    if (!parsed) return false;
+    cam = *parsed;
+    rest_.remove_prefix(static_cast<std::size_t>(eol - begin) + 1);
+    return true;
+}
+
+bool CamParser::next_binary(Cam& cam) {
+    if (rest_.size() < CAM_BINARY_SIZE) return false;
+    auto parsed = decode_cam(std::as_bytes(std::span(rest_)).first<CAM_BINARY_SIZE>());
+    if (!parsed) return false;
+    cam = *parsed;
+    rest_.remove_prefix(CAM_BINARY_SIZE);
+    return true;
+}
+
+std::optional<std::size_t> parse_cams(std::string_view bundle, bool binary, std::span<Cam> out) {
+    CamParser parser(bundle, binary);
+    std::size_t n = 0;
+    Cam cam;
+    while (parser.next(cam)) {
+        if (n == out.size()) return std::nullopt;
+        out[n++] = cam;
+    }
+    if (!parser.ok()) return std::nullopt;
+    return n;
+}
+
+std::optional<std::size_t> count_cams(std::string_view bundle, bool binary) {
+    CamParser parser(bundle, binary);
+    std::size_t n = 0;
+    Cam cam;
+    while (parser.next(cam)) ++n;
+    if (!parser.ok()) return std::nullopt;
+    return n;
+}
@@ -0,0 +1,51 @@
+#ifndef CAM_PARSER_H
+#define CAM_PARSER_H
+
+#include "cam_codec.h"
+
+#include <cstddef>
+#include <optional>
+#include <span>
+#include <string_view>
+
+// Parses the CAMs of a received bundle back into fields, in place: nothing
+// is copied or allocated. Text bundles are split into lines with a SIMD
+// newline scan (SSE2 where available, memchr otherwise) and the values are
+// read with std::from_chars; binary bundles are read with decode_cam.
+//
+//     CamParser parser(plain, binary);
+//     Cam cam;
+//     while (parser.next(cam)) { ... }
+//     if (!parser.ok()) { ... malformed ... }
+class CamParser {
+  public:
+    CamParser(std::string_view bundle, bool binary);
+
+    // Parses the next CAM into cam. Returns false at the end of the bundle
+    // or at the first malformed CAM, after which ok() tells the two apart.
+    bool next(Cam& cam);
+
+    // False once a malformed CAM was hit; an empty bundle is malformed, as
+    // a packet always carries at least one CAM.
+    bool ok() const { return ok_; }
+
+  private:
+    bool next_text(Cam& cam);
+    bool next_binary(Cam& cam);
+
+    std::string_view rest_;
+    bool binary_;
+    bool ok_;
+};
+
+// Parses one text line (without its newline), as written by format_cam.
+std::optional<Cam> parse_cam_line(std::string_view line);
+
+// Parses a whole bundle into out. Returns the number of CAMs, or
+// std::nullopt if the bundle is malformed or holds more than out.size().
+std::optional<std::size_t> parse_cams(std::string_view bundle, bool binary, std::span<Cam> out);
+
+// Number of CAMs in a well formed bundle, std::nullopt if it is malformed.
+std::optional<std::size_t> count_cams(std::string_view bundle, bool binary);
+
+#endif // CAM_PARSER_H
@@ -0,0 +1,74 @@
+#ifndef CBC_PADDING_H
+#define CBC_PADDING_H
+
+// PKCS#7 padded CBC over caller provided buffers, shared by aes.cc and
+// ecc.cc. The output is byte for byte what a StreamTransformationFilter with
+// the default padding produces, without going through a StringSink.
+
+#include <cryptopp/aes.h>
+#include <cryptopp/cryptlib.h>
+
+#include <cstddef>
+#include <cstring>
+#include <optional>
+#include <span>
+
+// Size of the padded ciphertext of n plaintext bytes (always at least one
+// padding byte, so a full extra block when n is block aligned).
+constexpr std::size_t cbc_padded_size(std::size_t n) {
+    return (n / CryptoPP::AES::BLOCKSIZE + 1) * CryptoPP::AES::BLOCKSIZE;
+}
+
+// Encrypts in into out with a keyed CBC encryption object.
+// Returns the bytes written, or std::nullopt if out is too small.
+inline std::optional<std::size_t> cbc_encrypt_padded(CryptoPP::StreamTransformation& enc,
+                                                     std::span<const std::byte> in,
+                                                     std::span<std::byte> out) {
+    constexpr std::size_t block = CryptoPP::AES::BLOCKSIZE;
+    const std::size_t total = cbc_padded_size(in.size());
+    if (out.size() < total) return std::nullopt;
+
+    auto* o = reinterpret_cast<CryptoPP::byte*>(out.data());
+    const std::size_t full = in.size() - in.size() % block;
+    if (full) enc.ProcessData(o, reinterpret_cast<const CryptoPP::byte*>(in.data()), full);
+
+    CryptoPP::byte last[block];
+    const std::size_t rest = in.size() - full;
+    if (rest) std::memcpy(last, in.data() + full, rest);
+    std::memset(last + rest, static_cast<int>(block - rest), block - rest);
+    enc.ProcessData(o + full, last, block);
+    return total;
+}
+
+// Decrypts in into out with a keyed CBC decryption object and strips the
+// padding. Returns the plaintext size, or std::nullopt if in is not a
+// whole number of blocks, the padding is invalid or out is too small.
+inline std::optional<std::size_t> cbc_decrypt_padded(CryptoPP::StreamTransformation& dec,
+                                                     std::span<const std::byte> in,
+                                                     std::span<std::byte> out) {
+    constexpr std::size_t block = CryptoPP::AES::BLOCKSIZE;
+    if (in.empty() || in.size() % block != 0) return std::nullopt;
+
+    // Everything but the last block goes straight to out; the last block
+    // holds the padding, so it is decrypted aside and only its data copied.
+    const std::size_t lead = in.size() - block;
+    if (out.size() < lead) return std::nullopt;
+    auto* o = reinterpret_cast<CryptoPP::byte*>(out.data());
+    const auto* i = reinterpret_cast<const CryptoPP::byte*>(in.data());
+    if (lead) dec.ProcessData(o, i, lead);
+
+    CryptoPP::byte last[block];
+    dec.ProcessData(last, i + lead, block);
+    const std::size_t pad = last[block - 1];
+    if (pad == 0 || pad > block) return std::nullopt;
+    for (std::size_t k = block - pad; k < block; ++k) {
+        if (last[k] != pad) return std::nullopt;
+    }
+
+    const std::size_t rest = block - pad;
+    if (out.size() < lead + rest) return std::nullopt;
+    std::memcpy(o + lead, last, rest);
+    return lead + rest;
+}
+
+#endif // CBC_PADDING_H
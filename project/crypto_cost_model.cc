@@ -0,0 +1,151 @@
+#include "crypto_cost_model.h"
+
+#include "cam_generation.h"
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+    struct Sample {
+        double bytes;
+        double seconds;
+    };
+
+    // Ordinary least squares; negative coefficients are clamped because a
+    // crypto call can neither take negative time nor get faster with size.
+    LatencyFit fit(const std::vector<Sample>& samples) {
+        LatencyFit f;
+        if (samples.empty()) return f;
+
+        double n = static_cast<double>(samples.size());
+        double sx = 0, sy = 0, sxx = 0, sxy = 0;
+        for (const auto& s : samples) {
+            sx += s.bytes;
+            sy += s.seconds;
+            sxx += s.bytes * s.bytes;
+            sxy += s.bytes * s.seconds;
+        }
+        double denom = n * sxx - sx * sx;
+        if (denom != 0.0) f.slope = (n * sxy - sx * sy) / denom;
+        f.slope = std::max(f.slope, 0.0);
+        f.intercept = std::max((sy - f.slope * sx) / n, 0.0);
+        return f;
+    }
+
+    double seconds_since(std::chrono::high_resolution_clock::time_point start) {
+        std::chrono::duration<double> d = std::chrono::high_resolution_clock::now() - start;
+        return d.count();
+    }
+
+} // namespace
+
+bool CryptoCostModel::has(CryptoEngine engine) const {
+    return engines.at(static_cast<size_t>(engine)).has_value();
+}
+
+double CryptoCostModel::encrypt_delay(CryptoEngine engine, std::size_t plain_bytes) const {
+    const auto& e = engines.at(static_cast<size_t>(engine));
+    return e ? e->encrypt(plain_bytes) * cpu_scale : 0.0;
+}
+
+double CryptoCostModel::decrypt_delay(CryptoEngine engine, std::size_t wire_bytes) const {
+    const auto& e = engines.at(static_cast<size_t>(engine));
+    return e ? e->decrypt(wire_bytes) * cpu_scale : 0.0;
+}
+
+EngineCostFit calibrate_engine(CryptoEngine engine, const std::vector<int>& cam_counts,
+                               int repetitions, bool binary_cams,
+                               const PayloadCompressor* compressor) {
+    EngineCostFit result;
+    if (engine == CryptoEngine::None) return result;
+
+    // First call builds keys/contexts, which must not end up in the fit.
+    engine_decrypt(engine, engine_encrypt(engine, "WARMUP"));
+
+    // A generator of its own: drawing from the one behind generate_messages
+    // would shift the CAMs of the simulation depending on the calibration.
+    CamGenerator generator;
+    std::vector<Cam> cams;
+    std::vector<Sample> enc, dec;
+    for (int n : cam_counts) {
+        for (int r = 0; r < repetitions; ++r) {
+            std::string msg;
+            if (binary_cams) {
+                cams.clear();
+                generator.generate(static_cast<uint32_t>(n), [&](const Cam& cam) { cams.push_back(cam); });
+                msg = encode_cams(cams);
+            } else {
+                generator.append_text(static_cast<uint32_t>(n), msg);
+            }
+            if (compressor) msg = compressor->compress(msg);
+
+            auto start = std::chrono::high_resolution_clock::now();
+            std::string wire = engine_encrypt(engine, msg);
+            enc.push_back({static_cast<double>(msg.size()), seconds_since(start)});
+
+            start = std::chrono::high_resolution_clock::now();
+            engine_decrypt(engine, wire);
+            dec.push_back({static_cast<double>(wire.size()), seconds_since(start)});
+        }
+    }
+
+    result.encrypt = fit(enc);
+    result.decrypt = fit(dec);
+    return result;
+}
+
+std::optional<double> cpu_profile_scale(std::string_view profile) {
+    // Rough single-core slowdowns against a desktop x86 core, for the
+    // Cortex-A class CPUs found in OBUs. Measured factors can be passed
+    // directly instead (see costCpuScale in eris).
+    if (profile == "host") return 1.0;
+    if (profile == "obu-a72") return 2.5;
+    if (profile == "obu-a53") return 5.0;
+    return std::nullopt;
+}
+
+bool save_cost_model(const CryptoCostModel& model, const std::string& path) {
+    std::ofstream out(path, std::ios_base::out | std::ios_base::trunc);
+    if (!out.is_open()) return false;
+
+    out.precision(17);
+    for (size_t i = 0; i < model.engines.size(); ++i) {
+        const auto& e = model.engines[i];
+        if (!e) continue;
+        out << engine_name(static_cast<CryptoEngine>(i)) << ' ' << e->encrypt.intercept << ' '
+            << e->encrypt.slope << ' ' << e->decrypt.intercept << ' ' << e->decrypt.slope
+            << '\n';
+    }
+    return static_cast<bool>(out);
+}
+
+bool load_cost_model(CryptoCostModel& model, const std::string& path) {
+    std::ifstream in(path);
+    if (!in.is_open()) return false;
+
+    std::string line;
+    while (std::getline(in, line)) {
+        std::istringstream ss(line);
+        std::string name;
+        EngineCostFit f;
+        if (!(ss >> name >> f.encrypt.intercept >> f.encrypt.slope >> f.decrypt.intercept >>
+              f.decrypt.slope)) {
+            return false;
+        }
+
+        bool known = false;
+        for (size_t i = 0; i < model.engines.size(); ++i) {
+            if (name == engine_name(static_cast<CryptoEngine>(i))) {
+                model.engines[i] = f;
+                known = true;
+            }
+        }
+        if (!known) return false;
+    }
+    return true;
+}
@@ -0,0 +1,62 @@
+#ifndef CRYPTO_COST_MODEL_H
+#define CRYPTO_COST_MODEL_H
+
+#include "crypto_engine.h"
+#include "payload_compressor.h"
+
+#include <array>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Latency in seconds modelled as intercept + slope * bytes.
+struct LatencyFit {
+    double intercept = 0.0;
+    double slope = 0.0;
+
+    double operator()(std::size_t bytes) const { return intercept + slope * bytes; }
+};
+
+// Fitted costs of one engine. Encryption is a function of the plaintext
+// size, decryption of the wire (ciphertext) size.
+struct EngineCostFit {
+    LatencyFit encrypt;
+    LatencyFit decrypt;
+};
+
+// Per-engine fits plus a CPU scaling factor. A scale of 1 reproduces the
+// host the model was calibrated on; slower OBU-class CPUs use larger values.
+struct CryptoCostModel {
+    std::array<std::optional<EngineCostFit>, 5> engines;
+    double cpu_scale = 1.0;
+
+    bool has(CryptoEngine engine) const;
+    // Modelled encryption delay of a plaintext, in seconds.
+    double encrypt_delay(CryptoEngine engine, std::size_t plain_bytes) const;
+    // Modelled decryption delay of a wire payload, in seconds.
+    double decrypt_delay(CryptoEngine engine, std::size_t wire_bytes) const;
+};
+
+// Times engine_encrypt/engine_decrypt over bundles of n CAMs for every n in
+// cam_counts, repetitions times each, and least-squares fits the latency
+// against the message size. The bundles are binary CAMs (cam_codec) if
+// binary_cams, text otherwise, and go through compressor first if given,
+// so the fit covers the sizes the simulation sends. The CAMs come from a
+// CamGenerator of its own with the default seed, so calibrating neither
+// depends on nor disturbs the draws of generate_messages. Throws
+// std::invalid_argument if an n exceeds the default station count.
+EngineCostFit calibrate_engine(CryptoEngine engine, const std::vector<int>& cam_counts,
+                               int repetitions, bool binary_cams = false,
+                               const PayloadCompressor* compressor = nullptr);
+
+// CPU scale of a named profile ("host", "obu-a72", "obu-a53").
+// Returns std::nullopt for unknown names.
+std::optional<double> cpu_profile_scale(std::string_view profile);
+
+// Plain-text persistence, one "engine enc_a enc_b dec_a dec_b" line per fit,
+// so sweeps can calibrate once and reuse the file.
+bool save_cost_model(const CryptoCostModel& model, const std::string& path);
+bool load_cost_model(CryptoCostModel& model, const std::string& path);
+
+#endif // CRYPTO_COST_MODEL_H
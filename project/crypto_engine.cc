@@ -0,0 +1,173 @@
+#include "crypto_engine.h"
+
+#include "aes.h"
+#include "ecc.h"
+#include "he.h"
+#include "rsa.h"
+
+#include <atomic>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+
+    std::atomic<bool> perf_enabled{false};
+
+    struct PerfState {
+        std::unique_ptr<PerfCounterGroup> group;
+        std::vector<CryptoOpSample> samples;
+    };
+
+    PerfState& perf_state() {
+        thread_local PerfState state;
+        return state;
+    }
+
+    // Runs op, wrapped in the calling thread's counter group when the
+    // instrumentation is enabled.
+    template <typename Op>
+    auto measured(CryptoEngine engine, bool encrypt, std::size_t bytes, Op op) -> decltype(op()) {
+        if (!perf_enabled.load(std::memory_order_relaxed)) return op();
+
+        PerfState& state = perf_state();
+        if (!state.group) state.group = std::make_unique<PerfCounterGroup>();
+        state.group->start();
+        auto out = op();
+        state.samples.push_back({engine, encrypt, bytes, state.group->stop()});
+        return out;
+    }
+
+    std::optional<std::size_t> copy_into(std::span<const std::byte> in, std::span<std::byte> out) {
+        if (out.size() < in.size()) return std::nullopt;
+        if (!in.empty()) std::memcpy(out.data(), in.data(), in.size());
+        return in.size();
+    }
+
+    std::optional<std::size_t> encrypt_impl(CryptoEngine engine, std::span<const std::byte> message,
+                                            std::span<std::byte> out) {
+        switch (engine) {
+        case CryptoEngine::Aes:
+            return aes_encrypt_into(message, out);
+        case CryptoEngine::Rsa:
+            return rsa_encrypt_into(message, out);
+        case CryptoEngine::Ecc:
+            return ecc_encrypt_into(message, out);
+        case CryptoEngine::He:
+            return example::encrypt_into(message, out);
+        case CryptoEngine::None:
+            break;
+        }
+        return copy_into(message, out);
+    }
+
+    std::optional<std::size_t> decrypt_impl(CryptoEngine engine, std::span<const std::byte> wire,
+                                            std::span<std::byte> out) {
+        // The engines report malformed input by returning std::nullopt, but
+        // Crypto++ and SEAL can still throw on odd input; a receiver only
+        // needs to know that nothing usable came out.
+        try {
+            switch (engine) {
+            case CryptoEngine::Aes:
+                return aes_decrypt_into(wire, out);
+            case CryptoEngine::Rsa:
+                if (wire.empty()) return std::nullopt;
+                return rsa_decrypt_into(wire, out);
+            case CryptoEngine::Ecc:
+                return ecc_decrypt_into(wire, out);
+            case CryptoEngine::He:
+                return example::decrypt_into(wire, out);
+            case CryptoEngine::None:
+                break;
+            }
+        } catch (...) {
+            return std::nullopt;
+        }
+        return copy_into(wire, out);
+    }
+
+} // namespace
+
+const char* engine_name(CryptoEngine engine) {
+    switch (engine) {
+    case CryptoEngine::None: return "none";
+    case CryptoEngine::Aes: return "aes";
+    case CryptoEngine::Rsa: return "rsa";
+    case CryptoEngine::Ecc: return "ecc";
+    case CryptoEngine::He: return "he";
+    }
+    return "unknown";
+}
+
+bool engine_set_key_seed(uint64_t seed) {
+    // every engine is seeded, even after a failure, so none is left behind
+    bool ok = aes_set_key_seed(seed);
+    ok = rsa_set_key_seed(seed) && ok;
+    ok = ecc_set_key_seed(seed) && ok;
+    ok = example::set_key_seed(seed) && ok;
+    return ok;
+}
+
+std::size_t engine_encrypted_size(CryptoEngine engine, std::size_t plain_bytes) {
+    switch (engine) {
+    case CryptoEngine::Aes: return aes_encrypted_size(plain_bytes);
+    case CryptoEngine::Rsa: return rsa_encrypted_size(plain_bytes);
+    case CryptoEngine::Ecc: return ecc_encrypted_size(plain_bytes);
+    case CryptoEngine::He: return example::encrypted_size();
+    case CryptoEngine::None: break;
+    }
+    return plain_bytes;
+}
+
+std::size_t engine_decrypted_size(CryptoEngine engine, std::size_t wire_bytes) {
+    switch (engine) {
+    case CryptoEngine::Aes: return aes_decrypted_size(wire_bytes);
+    case CryptoEngine::Rsa: return rsa_decrypted_size(wire_bytes);
+    case CryptoEngine::Ecc: return ecc_decrypted_size(wire_bytes);
+    case CryptoEngine::He: return example::decrypted_size();
+    case CryptoEngine::None: break;
+    }
+    return wire_bytes;
+}
+
+std::optional<std::size_t> engine_encrypt_into(CryptoEngine engine,
+                                               std::span<const std::byte> message,
+                                               std::span<std::byte> out) {
+    return measured(engine, true, message.size(), [&] { return encrypt_impl(engine, message, out); });
+}
+
+std::optional<std::size_t> engine_decrypt_into(CryptoEngine engine,
+                                               std::span<const std::byte> wire,
+                                               std::span<std::byte> out) {
+    return measured(engine, false, wire.size(), [&] { return decrypt_impl(engine, wire, out); });
+}
+
+std::string engine_encrypt(CryptoEngine engine, const std::string& message) {
+    std::string wire(engine_encrypted_size(engine, message.size()), '\0');
+    auto written = engine_encrypt_into(engine, std::as_bytes(std::span(message)),
+                                       std::as_writable_bytes(std::span(wire)));
+    if (!written) throw std::length_error("engine_encrypt: wire size bound too small");
+    wire.resize(*written);
+    return wire;
+}
+
+std::string engine_decrypt(CryptoEngine engine, const std::string& wire) {
+    std::string message(engine_decrypted_size(engine, wire.size()), '\0');
+    auto length = engine_decrypt_into(engine, std::as_bytes(std::span(wire)),
+                                      std::as_writable_bytes(std::span(message)));
+    if (!length) return "";
+    message.resize(*length);
+    return message;
+}
+
+void engine_set_perf_counters(bool enabled) {
+    perf_enabled.store(enabled, std::memory_order_relaxed);
+}
+
+std::vector<CryptoOpSample> engine_take_perf_samples() {
+    std::vector<CryptoOpSample> out;
+    out.swap(perf_state().samples);
+    return out;
+}
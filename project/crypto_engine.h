@@ -0,0 +1,76 @@
+#ifndef CRYPTO_ENGINE_H
+#define CRYPTO_ENGINE_H
+
+#include "perf_counters.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <string>
+#include <vector>
+
+// Encryption engines, numbered as in eris' encryptType flag.
+enum class CryptoEngine : uint16_t {
+    None = 0,
+    Aes = 1,
+    Rsa = 2,
+    Ecc = 3,
+    He = 4,
+};
+
+// Short printable name of the engine ("none", "aes", "rsa", "ecc", "he").
+const char* engine_name(CryptoEngine engine);
+
+// Derives the keys of every engine from seed instead of drawing them at
+// random, so wire bytes stored by one process (e.g. an encrypted CAM corpus)
+// decrypt in another that set the same seed. Must be called before the
+// first encryption or decryption; returns false if some engine had already
+// generated its keys, which then stay as they are.
+bool engine_set_key_seed(uint64_t seed);
+
+// Encrypts a message into the bytes carried on the wire by the given engine.
+// RSA chunks are concatenated and HE ciphertexts are serialized, so the
+// result can be handed to a packet as-is.
+std::string engine_encrypt(CryptoEngine engine, const std::string& message);
+
+// Recovers the message from wire bytes produced by engine_encrypt.
+// Returns an empty string when the bytes cannot be decrypted.
+std::string engine_decrypt(CryptoEngine engine, const std::string& wire);
+
+// Upper bound of the wire size engine_encrypt_into needs for plain_bytes.
+std::size_t engine_encrypted_size(CryptoEngine engine, std::size_t plain_bytes);
+
+// Upper bound of the plaintext size engine_decrypt_into needs for wire_bytes.
+std::size_t engine_decrypted_size(CryptoEngine engine, std::size_t wire_bytes);
+
+// Span versions of engine_encrypt/engine_decrypt: same wire format, but the
+// input is read in place and the output written into a caller buffer sized
+// with engine_encrypted_size/engine_decrypted_size, with no intermediate
+// copies. Return the bytes written, or std::nullopt when out is too small
+// or (decryption) the wire bytes cannot be decrypted. Encryption errors of
+// the engines (e.g. HE messages longer than the slot count) still throw.
+std::optional<std::size_t> engine_encrypt_into(CryptoEngine engine,
+                                               std::span<const std::byte> message,
+                                               std::span<std::byte> out);
+std::optional<std::size_t> engine_decrypt_into(CryptoEngine engine,
+                                               std::span<const std::byte> wire,
+                                               std::span<std::byte> out);
+
+// Hardware counters of one engine_encrypt/engine_decrypt call.
+struct CryptoOpSample {
+    CryptoEngine engine;
+    bool encrypt;        // false for a decryption
+    std::size_t bytes;   // input size: plaintext or wire bytes
+    PerfCounts counts;
+};
+
+// Opt-in perf_event_open instrumentation of engine_encrypt/engine_decrypt.
+// While enabled, every call on a thread appends a sample to that thread's
+// buffer; the counter group is opened lazily, once per thread.
+void engine_set_perf_counters(bool enabled);
+
+// Returns and clears the samples recorded by the calling thread.
+std::vector<CryptoOpSample> engine_take_perf_samples();
+
+#endif // CRYPTO_ENGINE_H
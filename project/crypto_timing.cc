@@ -0,0 +1,98 @@
+#include "crypto_timing.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+#ifdef __linux__
+#include <sched.h>
+#endif
+
+namespace {
+
+    // Pins the calling thread to one core and restores the previous
+    // affinity on destruction. A no-op off Linux or when core < 0.
+    class CorePin {
+      public:
+        explicit CorePin(int core) {
+#ifdef __linux__
+            if (core < 0) return;
+            if (sched_getaffinity(0, sizeof(saved_), &saved_) != 0) return;
+            cpu_set_t set;
+            CPU_ZERO(&set);
+            CPU_SET(core, &set);
+            pinned_ = sched_setaffinity(0, sizeof(set), &set) == 0;
+#else
+            (void)core;
+#endif
+        }
+
+        ~CorePin() {
+#ifdef __linux__
+            if (pinned_) sched_setaffinity(0, sizeof(saved_), &saved_);
+#endif
+        }
+
+        CorePin(const CorePin&) = delete;
+        CorePin& operator=(const CorePin&) = delete;
+
+      private:
+#ifdef __linux__
+        cpu_set_t saved_;
+        bool pinned_ = false;
+#endif
+    };
+
+} // namespace
+
+double percentile(const std::vector<double>& sorted, double p) {
+    if (sorted.empty()) return 0.0;
+    size_t rank = static_cast<size_t>(std::ceil(p / 100.0 * sorted.size()));
+    rank = std::clamp<size_t>(rank, 1, sorted.size());
+    return sorted[rank - 1];
+}
+
+TimingStats summarize_samples(std::vector<double>& samples) {
+    TimingStats s;
+    s.iterations = static_cast<int>(samples.size());
+    if (samples.empty()) return s;
+
+    std::sort(samples.begin(), samples.end());
+    s.min = samples.front();
+    s.p99 = percentile(samples, 99.0);
+
+    size_t mid = samples.size() / 2;
+    s.median = samples.size() % 2 ? samples[mid] : (samples[mid - 1] + samples[mid]) / 2.0;
+
+    double sum = 0.0;
+    for (double v : samples) sum += v;
+    s.mean = sum / samples.size();
+
+    if (samples.size() > 1) {
+        double sq = 0.0;
+        for (double v : samples) sq += (v - s.mean) * (v - s.mean);
+        s.stddev = std::sqrt(sq / (samples.size() - 1));
+    }
+    return s;
+}
+
+TimingStats single_sample(double seconds) {
+    std::vector<double> samples{seconds};
+    return summarize_samples(samples);
+}
+
+TimingStats time_repeated(const TimingOptions& options, const std::function<void()>& fn) {
+    CorePin pin(options.pin_core);
+
+    for (int i = 0; i < options.warmup; ++i) fn();
+
+    std::vector<double> samples;
+    samples.reserve(std::max(options.iterations, 1));
+    for (int i = 0; i < std::max(options.iterations, 1); ++i) {
+        auto start = std::chrono::high_resolution_clock::now();
+        fn();
+        std::chrono::duration<double> d = std::chrono::high_resolution_clock::now() - start;
+        samples.push_back(d.count());
+    }
+    return summarize_samples(samples);
+}
@@ -0,0 +1,38 @@
+#ifndef CRYPTO_TIMING_H
+#define CRYPTO_TIMING_H
+
+#include <functional>
+#include <vector>
+
+// Summary of repeated timings of one operation, in seconds.
+struct TimingStats {
+    double min = 0.0;
+    double median = 0.0;
+    double p99 = 0.0;
+    double mean = 0.0;
+    double stddev = 0.0;
+    int iterations = 0;
+};
+
+// How to time an operation: untimed warmup runs first (caches, page faults,
+// lazy key setup, frequency ramp-up), then timed iterations. pin_core >= 0
+// pins the calling thread to that core for the duration of the measurement.
+struct TimingOptions {
+    int iterations = 1;
+    int warmup = 0;
+    int pin_core = -1;
+};
+
+// Runs fn according to options and summarizes the timed iterations.
+TimingStats time_repeated(const TimingOptions& options, const std::function<void()>& fn);
+
+// Summarizes raw samples (seconds); the vector is sorted in place.
+TimingStats summarize_samples(std::vector<double>& samples);
+
+// Stats of a single value, e.g. a modelled latency.
+TimingStats single_sample(double seconds);
+
+// Nearest-rank percentile (p in [0, 100]) of an already sorted sample.
+double percentile(const std::vector<double>& sorted, double p);
+
+#endif // CRYPTO_TIMING_H
@@ -1,4 +1,6 @@
 #include "ecc.h"
+#include "cbc_padding.h"
+#include "seeded_rng.h"
 #include <cryptopp/eccrypto.h>
 #include <cryptopp/osrng.h>
 #include <cryptopp/oids.h>
@@ -6,7 +8,10 @@
 #include <cryptopp/aes.h>
 #include <cryptopp/modes.h>
 #include <cryptopp/filters.h>
+#include <atomic>
 #include <mutex>
+#include <optional>
+#include <span>
 #include <string>
 #include <cstring>
 
@@ -22,14 +27,23 @@ namespace {
 
     static std::once_flag keys_once_flag;
     static SecByteBlock privateKey, publicKey;
+    static std::atomic<bool> keys_ready{false};
+    static std::optional<uint64_t> key_seed; // see ecc_set_key_seed
 
     void do_init_keys() {
-        AutoSeededRandomPool rng;
         const auto& dom = get_ec_do();
 
         privateKey.CleanNew(dom.PrivateKeyLength());
         publicKey.CleanNew(dom.PublicKeyLength());
-        dom.GenerateKeyPair(rng, privateKey, publicKey);
+        if (key_seed) {
+            SeededRng rng;
+            seed_rng(rng, *key_seed, 3);
+            dom.GenerateKeyPair(rng, privateKey, publicKey);
+        } else {
+            AutoSeededRandomPool rng;
+            dom.GenerateKeyPair(rng, privateKey, publicKey);
+        }
+        keys_ready = true;
     }
 
     void ensure_keys_initialized() {
@@ -37,71 +51,94 @@ namespace {
     }
 }
 
-std::string ecc_encrypt(const std::string& message) {
-    if (message.empty()) return "";
+bool ecc_set_key_seed(uint64_t seed) {
+    if (keys_ready) return false;
+    key_seed = seed;
+    return true;
+}
+
+std::size_t ecc_encrypted_size(std::size_t message_bytes) {
+    if (message_bytes == 0) return 0;
+    return get_ec_do().PublicKeyLength() + AES::BLOCKSIZE + cbc_padded_size(message_bytes);
+}
+
+std::size_t ecc_decrypted_size(std::size_t blob_bytes) {
+    const size_t header = get_ec_do().PublicKeyLength() + AES::BLOCKSIZE;
+    return blob_bytes > header ? blob_bytes - header : 0;
+}
+
+std::optional<std::size_t> ecc_encrypt_into(std::span<const std::byte> message,
+                                            std::span<std::byte> out) {
+    if (message.empty()) return 0;
     ensure_keys_initialized();
 
     AutoSeededRandomPool rng;
     const auto& dom = get_ec_do();
+    const size_t ephLen = dom.PublicKeyLength();
+    if (out.size() < ecc_encrypted_size(message.size())) return std::nullopt;
+
+    // The ephemeral public key and the IV are generated in place.
+    byte* ephPub = reinterpret_cast<byte*>(out.data());
+    byte* iv = ephPub + ephLen;
 
-    SecByteBlock ephPriv(dom.PrivateKeyLength()), ephPub(dom.PublicKeyLength());
+    SecByteBlock ephPriv(dom.PrivateKeyLength());
     dom.GenerateKeyPair(rng, ephPriv, ephPub);
 
     SecByteBlock shared(dom.AgreedValueLength());
-    if (!dom.Agree(shared, ephPriv, publicKey)) return "";
+    if (!dom.Agree(shared, ephPriv, publicKey)) return std::nullopt;
 
-    SecByteBlock aesKey(AES::DEFAULT_KEYLENGTH);
-    std::memcpy(aesKey.data(), shared.data(), aesKey.size());
+    rng.GenerateBlock(iv, AES::BLOCKSIZE);
 
-    byte iv[AES::BLOCKSIZE];
-    rng.GenerateBlock(iv, sizeof(iv));
-
-    std::string ciphertext;
     try {
+        // AES key = first DEFAULT_KEYLENGTH bytes of the shared secret
         CBC_Mode<AES>::Encryption aesEnc;
-        aesEnc.SetKeyWithIV(aesKey, aesKey.size(), iv);
-        StringSource(message, true,
-            new StreamTransformationFilter(aesEnc, new StringSink(ciphertext))
-        );
+        aesEnc.SetKeyWithIV(shared, AES::DEFAULT_KEYLENGTH, iv);
+        auto written = cbc_encrypt_padded(aesEnc, message, out.subspan(ephLen + AES::BLOCKSIZE));
+        if (!written) return std::nullopt;
+        return ephLen + AES::BLOCKSIZE + *written;
     } catch (...) {
-        return "";
+        return std::nullopt;
     }
-
-    std::string output;
-    output.append(reinterpret_cast<const char*>(ephPub.data()), ephPub.size());
-    output.append(reinterpret_cast<const char*>(iv), sizeof(iv));
-    output.append(ciphertext);
-    return output;
 }
 
-std::string ecc_decrypt(const std::string& blob) {
+std::optional<std::size_t> ecc_decrypt_into(std::span<const std::byte> blob,
+                                            std::span<std::byte> out) {
     ensure_keys_initialized();
     const auto& dom = get_ec_do();
 
     const size_t ephLen = dom.PublicKeyLength();
     const size_t ivLen = AES::BLOCKSIZE;
-    if (blob.size() < ephLen + ivLen) return "";
+    if (blob.size() < ephLen + ivLen) return std::nullopt;
 
-    SecByteBlock ephPub(reinterpret_cast<const byte*>(blob.data()), ephLen);
-    const byte* iv = reinterpret_cast<const byte*>(blob.data() + ephLen);
-    std::string cipherText = blob.substr(ephLen + ivLen);
+    const byte* ephPub = reinterpret_cast<const byte*>(blob.data());
+    const byte* iv = ephPub + ephLen;
 
     SecByteBlock shared(dom.AgreedValueLength());
-    if (!dom.Agree(shared, privateKey, ephPub)) return "";
-
-    SecByteBlock aesKey(AES::DEFAULT_KEYLENGTH);
-    std::memcpy(aesKey.data(), shared.data(), aesKey.size());
-
-    std::string recovered;
     try {
+        if (!dom.Agree(shared, privateKey, ephPub)) return std::nullopt;
+
         CBC_Mode<AES>::Decryption aesDec;
-        aesDec.SetKeyWithIV(aesKey, aesKey.size(), iv);
-        StringSource(cipherText, true,
-            new StreamTransformationFilter(aesDec, new StringSink(recovered))
-        );
+        aesDec.SetKeyWithIV(shared, AES::DEFAULT_KEYLENGTH, iv);
+        return cbc_decrypt_padded(aesDec, blob.subspan(ephLen + ivLen), out);
     } catch (...) {
-        return "";
+        return std::nullopt;
     }
+}
 
+std::string ecc_encrypt(const std::string& message) {
+    std::string output(ecc_encrypted_size(message.size()), '\0');
+    auto written = ecc_encrypt_into(std::as_bytes(std::span(message)),
+                                    std::as_writable_bytes(std::span(output)));
+    if (!written) return "";
+    output.resize(*written);
+    return output;
+}
+
+std::string ecc_decrypt(const std::string& blob) {
+    std::string recovered(ecc_decrypted_size(blob.size()), '\0');
+    auto length = ecc_decrypt_into(std::as_bytes(std::span(blob)),
+                                   std::as_writable_bytes(std::span(recovered)));
+    if (!length) return "";
+    recovered.resize(*length);
     return recovered;
 }
@@ -1,7 +1,15 @@
 #pragma once
+#include <cstddef>
+#include <cstdint>
+#include <span>
 #include <string>
 #include <optional>
 
+// Derives the static key pair from seed instead of drawing it at random, so
+// blobs stored by one process decrypt in another. Returns false if the key
+// pair was already generated.
+bool ecc_set_key_seed(uint64_t seed);
+
 // Encrypts a string using ephemeral ECDH + AES-CBC.
 // Returns output blob or std::nullopt on error.
 std::string ecc_encrypt(const std::string& message);
@@ -9,3 +17,19 @@ std::string ecc_encrypt(const std::string& message);
 // Decrypts a string produced by encrypt_string.
 // Returns plaintext or std::nullopt on error.
 std::string ecc_decrypt(const std::string& blob);
+
+// Span API, same blob layout (ephemeral public key | IV | AES-CBC
+// ciphertext) written straight into the caller buffer. Both return the
+// bytes written, or std::nullopt on error or when out is too small.
+
+// Exact blob size of message_bytes of plaintext.
+std::size_t ecc_encrypted_size(std::size_t message_bytes);
+
+// Upper bound of the plaintext size of a blob_bytes blob.
+std::size_t ecc_decrypted_size(std::size_t blob_bytes);
+
+std::optional<std::size_t> ecc_encrypt_into(std::span<const std::byte> message,
+                                            std::span<std::byte> out);
+
+std::optional<std::size_t> ecc_decrypt_into(std::span<const std::byte> blob,
+                                            std::span<std::byte> out);
@@ -67,25 +67,32 @@ $ ./ns3 run "nr-v2x-west-to-east-highway --help"
 #include <cstdlib>
 #include <ctime>
 #include <chrono>
+#include <memory>
+#include <span>
+#include <string_view>
 
 #include "aes.h"
 #include "he.h"
 #include "rsa.h"
 #include "ecc.h"
 #include "cam_generation.h"
+#include "cam_corpus_file.h"
+#include "payload_compressor.h"
+#include "crypto_engine.h"
+#include "crypto_cost_model.h"
+#include "crypto_timing.h"
+#include "alloc_tracker.h"
+#include "buffer_pool.h"
+#include "cam-crypto-sink.h"
 
 using namespace ns3;
 
 NS_LOG_COMPONENT_DEFINE("eris");
 
-struct CryptoOverheadEntry {
-    uint32_t nodeId;
-    double encryptTime;
-    double decryptTime;
-    std::size_t length;
-    std::size_t declength;
-};
-std::vector<CryptoOverheadEntry> cryptoLog;
+std::vector<V2xKpi::CryptoOverheadRecord> cryptoLog;
+std::vector<V2xKpi::CryptoPerfRecord> cryptoPerfLog;
+std::vector<V2xKpi::CompressionRecord> compressionLog;
+OnlineKpiEngine* onlineKpis = nullptr;
 
 /*
  * Global methods to hook trace sources from different layers of
@@ -120,6 +127,16 @@ NotifySlPsschScheduling(UeMacPsschTxOutputStats* psschStats,
                         const SlPsschUeMacStatParameters psschStatsParams)
 {
     psschStats->Save(psschStatsParams);
+    if (onlineKpis)
+    {
+        onlineKpis->NotifyPsschTx({psschStatsParams.frameNum,
+                                   psschStatsParams.subframeNum,
+                                   psschStatsParams.slotNum,
+                                   psschStatsParams.symStart,
+                                   psschStatsParams.symLength,
+                                   psschStatsParams.rbStart,
+                                   psschStatsParams.rbLength});
+    }
 }
 
 /**
@@ -150,6 +167,39 @@ NotifySlPsschRx(UePhyPsschRxOutputStats* psschStats,
                 const SlRxDataPacketTraceParams psschStatsParams)
 {
     psschStats->Save(psschStatsParams);
+    if (onlineKpis)
+    {
+        onlineKpis->NotifyPsschRx(psschStatsParams.m_corrupt, psschStatsParams.m_sci2Corrupted);
+    }
+}
+
+/**
+ * \brief Convert an address of the application traces to the IP string used
+ *        by V2xKpi
+ * \param addrs The address, with or without port
+ * \return The IP address as a string
+ */
+std::string
+AddressToIp(const Address& addrs)
+{
+    std::ostringstream ip;
+    if (InetSocketAddress::IsMatchingType(addrs))
+    {
+        ip << InetSocketAddress::ConvertFrom(addrs).GetIpv4();
+    }
+    else if (Inet6SocketAddress::IsMatchingType(addrs))
+    {
+        ip << Inet6SocketAddress::ConvertFrom(addrs).GetIpv6();
+    }
+    else if (Ipv4Address::IsMatchingType(addrs))
+    {
+        ip << Ipv4Address::ConvertFrom(addrs);
+    }
+    else if (Ipv6Address::IsMatchingType(addrs))
+    {
+        ip << Ipv6Address::ConvertFrom(addrs);
+    }
+    return ip.str();
 }
 
 /**
@@ -180,6 +230,23 @@ UePacketTraceDb(UeToUePktTxRxOutputStats* stats,
     uint32_t pktSize = p->GetSize();
 
     stats->Save(txRx, localAddrs, nodeId, imsi, pktSize, srcAddrs, dstAddrs, seq);
+    if (onlineKpis)
+    {
+        if (txRx == "tx")
+        {
+            onlineKpis->NotifyPktTx(nodeId, imsi, AddressToIp(localAddrs), seq);
+        }
+        else
+        {
+            onlineKpis->NotifyPktRx(Simulator::Now().GetSeconds(),
+                                    nodeId,
+                                    imsi,
+                                    AddressToIp(localAddrs),
+                                    AddressToIp(srcAddrs),
+                                    pktSize,
+                                    seq);
+        }
+    }
 }
 
 /**
@@ -461,6 +528,38 @@ SavePositionPerIP(V2xKpi* v2xKpi)
     }
 }
 
+/**
+ * \brief Sample the position of the UEs for the range based KPIs, periodically
+ * \param v2xKpi pointer to the V2xKpi API storing the positions
+ * \param period The sampling period
+ */
+void
+SamplePositionPerIP(V2xKpi* v2xKpi, Time period)
+{
+    for (NodeList::Iterator it = NodeList::Begin(); it != NodeList::End(); ++it)
+    {
+        Ptr<Node> node = *it;
+        int nDevs = node->GetNDevices();
+        for (int j = 0; j < nDevs; j++)
+        {
+            Ptr<NrUeNetDevice> uedev = node->GetDevice(j)->GetObject<NrUeNetDevice>();
+            if (uedev)
+            {
+                Ptr<Ipv4L3Protocol> ipv4Protocol = node->GetObject<Ipv4L3Protocol>();
+                Ipv4InterfaceAddress addresses = ipv4Protocol->GetAddress(1, 0);
+                std::ostringstream ueIpv4Addr;
+                ueIpv4Addr << addresses.GetLocal();
+                Vector pos = node->GetObject<MobilityModel>()->GetPosition();
+                v2xKpi->AddPositionSample(ueIpv4Addr.str(),
+                                          Simulator::Now().GetSeconds(),
+                                          pos);
+            }
+        }
+    }
+
+    Simulator::Schedule(period, &SamplePositionPerIP, v2xKpi, period);
+}
+
 int
 main(int argc, char* argv[])
 {
@@ -517,11 +616,43 @@ main(int argc, char* argv[])
 
     // flag for encryption type
     uint16_t encryptType = 0; // 0 - No encryption, 1 - AES, 2 - RSA, 3 - ECC, 4 - Homomorphic
+    bool decryptOnRx = false;
+    std::string camFormat = "text"; // text or binary (cam_codec)
+    std::string camCorpus = "";     // CAM corpus file replayed instead of generating CAMs
+
+    // crypto cost model, replaces wall-clock crypto timing when enabled
+    bool costModel = false;
+    std::string costModelFile = "";
+    std::string costProfile = "host";
+    double costCpuScale = 0.0;
+
+    // repeated crypto timing, a single timed run by default
+    uint32_t cryptoIterations = 1;
+    uint32_t cryptoWarmup = 0;
+    int32_t cryptoPinCore = -1;
+    bool perfCounters = false;
+    bool trackMemory = false;
+
+    // zstd compression of the payloads before encryption
+    bool compress = false;
+    int32_t compressLevel = 3;
+    double compressMinGain = 0.1;
 
     // Where we will store the output files.
     std::string simTag = "Default";
     std::string outputDir = "./";
     bool saveDb = true;
+    uint32_t kpiBatchSize = 0; // rows per KPI table transaction, 0 for the whole table
+    // pragmas of the KPI connections, SQLite defaults unless set
+    bool kpiWal = false;
+    uint64_t kpiMmapMb = 0;
+    uint64_t kpiCacheMb = 0;
+    bool kpiTempStoreMemory = false;
+    std::string kpiSynchronous = "";
+    bool kpiReadOnly = false;
+    uint32_t kpiThreads = 1;
+    bool useOnlineKpis = false;
+    double kpiPositionPeriod = 0.0;
 
     /*
      * From here, we instruct the ns3::CommandLine class of all the input parameters
@@ -609,6 +740,36 @@ main(int argc, char* argv[])
     cmd.AddValue("outputDir", "directory where to store simulation results", outputDir);
     cmd.AddValue("simTag", "tag identifying the simulation campaigns", simTag);
     cmd.AddValue("saveDb", "Flag to control the saving of database file", saveDb);
+    cmd.AddValue("kpiBatchSize",
+                 "Number of rows written per transaction to the KPI tables; 0 writes "
+                 "each table in a single transaction",
+                 kpiBatchSize);
+    cmd.AddValue("kpiWal", "If true, the DB is switched to write-ahead logging", kpiWal);
+    cmd.AddValue("kpiMmapMb",
+                 "MiB of the DB memory-mapped by each KPI connection, 0 for no mmap",
+                 kpiMmapMb);
+    cmd.AddValue("kpiCacheMb", "Page cache of each KPI connection in MiB", kpiCacheMb);
+    cmd.AddValue("kpiTempStoreMemory",
+                 "If true, temporary tables and indices of the KPI queries are kept in memory",
+                 kpiTempStoreMemory);
+    cmd.AddValue("kpiSynchronous",
+                 "Synchronous level of the KPI writer: OFF, NORMAL, FULL or EXTRA",
+                 kpiSynchronous);
+    cmd.AddValue("kpiReadOnly",
+                 "If true, the trace tables are read through read-only connections",
+                 kpiReadOnly);
+    cmd.AddValue("kpiThreads",
+                 "Threads computing the KPIs after the simulation; more than one "
+                 "implies kpiReadOnly",
+                 kpiThreads);
+    cmd.AddValue("onlineKpis",
+                 "If true, the KPIs are accumulated during the simulation instead of "
+                 "computed from the trace tables at the end",
+                 useOnlineKpis);
+    cmd.AddValue("kpiPositionPeriod",
+                 "Period in seconds of the UE positions sampled for the range based "
+                 "PIR and PRR; 0 uses the initial positions",
+                 kpiPositionPeriod);
     cmd.AddValue("generateInitialPosGnuScript",
                  "generate gnuplot script to plot initial positions of the UEs",
                  generateInitialPosGnuScript);
@@ -616,6 +777,63 @@ main(int argc, char* argv[])
                  "generate gnuplot script to generate GIF to show UEs mobility",
                  generateGifGnuScript);
     cmd.AddValue("encryptType", "Flag to control the encryption type used", encryptType);
+    cmd.AddValue("camFormat",
+                 "Encoding of the generated CAMs: text (CSV-like lines) or binary "
+                 "(fixed-point, CAM_BINARY_SIZE bytes per CAM)",
+                 camFormat);
+    cmd.AddValue("camCorpus",
+                 "CAM corpus file (see tools/make_cam_corpus.cc) whose records are sent "
+                 "instead of generated CAMs, TX node i sending record i modulo the record "
+                 "count; its CAM format overrides camFormat",
+                 camCorpus);
+    cmd.AddValue("decryptOnRx",
+                 "If true, the receivers decrypt and validate every packet and log the "
+                 "decrypt latency, otherwise, they are plain echo servers. Homomorphic "
+                 "payloads are split over zero filled packets, so they never decrypt on rx",
+                 decryptOnRx);
+    cmd.AddValue("costModel",
+                 "If true, crypto costs come from a calibrated model and delay the "
+                 "sends (and, with decryptOnRx, the deliveries) in simulated time",
+                 costModel);
+    cmd.AddValue("costModelFile",
+                 "File to load the cost model from; it is calibrated and written "
+                 "there when missing or lacking the selected engine",
+                 costModelFile);
+    cmd.AddValue("costProfile",
+                 "CPU profile scaling the modelled costs: host, obu-a72 or obu-a53",
+                 costProfile);
+    cmd.AddValue("costCpuScale",
+                 "Explicit CPU scale for the modelled costs, overrides costProfile if > 0",
+                 costCpuScale);
+    cmd.AddValue("cryptoIterations",
+                 "Number of timed encryptions/decryptions of each TX payload; "
+                 "cryptoOverhead stores their min, median, p99 and stddev",
+                 cryptoIterations);
+    cmd.AddValue("cryptoWarmup",
+                 "Number of untimed encryptions/decryptions run before the timed ones",
+                 cryptoWarmup);
+    cmd.AddValue("cryptoPinCore",
+                 "CPU core the crypto timing runs pinned to, -1 to not pin (Linux only)",
+                 cryptoPinCore);
+    cmd.AddValue("perfCounters",
+                 "If true, the cycles, instructions, cache misses and branch misses of "
+                 "every TX crypto call are read with perf_event_open and saved in the "
+                 "cryptoPerfCounters table (Linux only, subject to perf_event_paranoid)",
+                 perfCounters);
+    cmd.AddValue("trackMemory",
+                 "If true, heap allocations, SEAL memory pool size and peak RSS of each "
+                 "simulation phase are saved in the memoryFootprint table",
+                 trackMemory);
+    cmd.AddValue("compress",
+                 "If true, every payload is compressed with zstd and a dictionary trained "
+                 "on CAM bundles before it is encrypted (and decompressed after decryption "
+                 "on rx); sizes, ratio and times go to the compressionOverhead table",
+                 compress);
+    cmd.AddValue("compressLevel", "zstd compression level", compressLevel);
+    cmd.AddValue("compressMinGain",
+                 "Payloads whose compression saves less than this fraction of their size "
+                 "are sent uncompressed",
+                 compressMinGain);
 
     // Parse the command line
     cmd.Parse(argc, argv);
@@ -625,6 +843,23 @@ main(int argc, char* argv[])
      * If you need to add other checks, here is the best position to put them.
      */
     NS_ABORT_IF(centralFrequencyBandSl > 6e9);
+    NS_ABORT_MSG_IF(encryptType > 4,
+                    "Unknown encryptType " << encryptType << ", use 0 to 4");
+    NS_ABORT_MSG_IF(camFormat != "text" && camFormat != "binary",
+                    "Unknown camFormat " << camFormat << ", use text or binary");
+    NS_ABORT_MSG_IF(useOnlineKpis && kpiPositionPeriod > 0.0,
+                    "kpiPositionPeriod requires the KPIs to be computed from the trace tables");
+    CamCorpusFile corpus;
+    if (!camCorpus.empty())
+    {
+        NS_ABORT_MSG_UNLESS(corpus.open(camCorpus), corpus.error());
+        NS_ABORT_MSG_IF(corpus.size() == 0, "CAM corpus " << camCorpus << " holds no records");
+        // The stored wire bytes are sent to receivers that decrypt them, so
+        // the keys are derived as when the corpus was written.
+        NS_ABORT_MSG_IF(corpus.encrypted() && !engine_set_key_seed(corpus.info().key_seed),
+                        "The engine keys were generated before the corpus key seed was set");
+    }
+    const bool binaryCam = camCorpus.empty() ? camFormat == "binary" : corpus.info().binary_cams;
 
     /*
      * If the logging variable is set to true, enable the log of some components
@@ -1102,6 +1337,29 @@ main(int argc, char* argv[])
     std::cout << "Data rate " << DataRate(dataRateBeString) << std::endl;
     
     
+    // Memory footprint per simulation phase: each call closes the current
+    // phase and starts the next one.
+    std::vector<V2xKpi::MemoryFootprintRecord> memoryLog;
+    NS_ABORT_MSG_IF(trackMemory && !alloc_tracking_available(),
+                    "trackMemory needs a build with ALLOC_TRACKER_COUNT_NEW defined");
+    alloc_tracking_enable(trackMemory);
+    AllocSnapshot phaseStart = alloc_snapshot();
+    auto endMemoryPhase = [&](const std::string& phase) {
+        if (!trackMemory)
+        {
+            return;
+        }
+        AllocSnapshot now = alloc_snapshot();
+        AllocSnapshot used = alloc_delta(phaseStart, now);
+        memoryLog.push_back({phase,
+                             engine_name(static_cast<CryptoEngine>(encryptType)),
+                             used.bytes,
+                             used.count,
+                             example::memory_pool_bytes(),
+                             peak_rss_bytes()});
+        phaseStart = now;
+    };
+
     bool usesetfill = true;
     // Set Application in the UEs
     //warmup encryption
@@ -1123,6 +1381,54 @@ main(int argc, char* argv[])
         usesetfill = false;
     }
     
+    std::shared_ptr<const PayloadCompressor> compressor;
+    if (compress)
+    {
+        NS_ABORT_MSG_UNLESS(PayloadCompressor::available(),
+                            "compress needs a build with zstd (zstd.h and -lzstd)");
+        compressor = std::make_shared<const PayloadCompressor>(train_cam_dictionary(binaryCam),
+                                                               compressLevel,
+                                                               compressMinGain);
+        std::cout << "Payload compression: zstd level " << compressLevel << ", "
+                  << compressor->dictionary_size() << " byte dictionary" << std::endl;
+    }
+
+    std::shared_ptr<CryptoCostModel> costModelPtr;
+    if (costModel)
+    {
+        CryptoEngine engine = static_cast<CryptoEngine>(encryptType);
+        costModelPtr = std::make_shared<CryptoCostModel>();
+        bool loaded = !costModelFile.empty() && load_cost_model(*costModelPtr, costModelFile);
+        if (!loaded || !costModelPtr->has(engine))
+        {
+            // same bundle sizes, CAM format and compression as the payloads
+            // of the TX loop below
+            costModelPtr->engines.at(encryptType) =
+                calibrate_engine(engine, {1, 2, 4, 6, 8, 10}, 10, binaryCam, compressor.get());
+            if (!costModelFile.empty())
+            {
+                NS_ABORT_MSG_UNLESS(save_cost_model(*costModelPtr, costModelFile),
+                                    "Can't write cost model file " << costModelFile);
+            }
+        }
+        auto profileScale = cpu_profile_scale(costProfile);
+        NS_ABORT_MSG_IF(!profileScale, "Unknown cost profile " << costProfile);
+        costModelPtr->cpu_scale = costCpuScale > 0.0 ? costCpuScale : *profileScale;
+        std::cout << "Crypto cost model: " << engine_name(engine) << " scale "
+                  << costModelPtr->cpu_scale << std::endl;
+    }
+
+    endMemoryPhase("cryptoSetup"); // keys, contexts and cost model calibration
+
+    TimingOptions timingOpts;
+    timingOpts.iterations = static_cast<int>(std::max<uint32_t>(cryptoIterations, 1));
+    timingOpts.warmup = static_cast<int>(cryptoWarmup);
+    timingOpts.pin_core = cryptoPinCore;
+
+    // Enabled after the key setup and calibration calls above, so only the
+    // per node calls below are counted (warmup runs included).
+    engine_set_perf_counters(perfCounters);
+
     ApplicationContainer clientApps;
     double realAppStart = 0.0;
     double realAppStopTime = 0.0;
@@ -1133,87 +1439,106 @@ main(int argc, char* argv[])
     
         UdpEchoClientHelper sidelinkClient(remoteAddress, port);
         std::string msg = "";
-        if (usesamplepacket) {
+        // Plaintext handed to the engines: msg, or a view into the corpus
+        // mapping when replaying one.
+        std::string_view plain;
+        CamCorpusFile::Record record;
+        if (corpus.size() > 0) {
+            record = corpus[i % corpus.size()];
+        } else if (usesamplepacket) {
             int randomNumber = (std::rand() % 10) + 1;
-            msg = generate_messages(randomNumber);
+            msg = binaryCam ? generate_binary_messages(randomNumber)
+                            : generate_messages(randomNumber);
         } else {
             int randomNumber = (std::rand() % 1400) + 1;
             char c = 'a';
             std::string msg(randomNumber, c);
         }
-        
-        
-        // record encryption overhead
-        std::chrono::duration<double> encryptelapsed;
-        std::chrono::duration<double> decryptelapsed;
-        std::string decmsg;
+        plain = corpus.size() > 0 ? record.plain : std::string_view(msg);
 
-        if (encryptType == 1) //AES
+        // The engines see the compressed payload; it is decompressed once
+        // here to record the receive side cost next to the sender's.
+        std::string compressed;
+        if (compressor)
         {
-            auto start = std::chrono::high_resolution_clock::now();
-            msg = aes_encrypt(msg);
-            auto end = std::chrono::high_resolution_clock::now();
-            encryptelapsed = end - start;
-
-            auto dstart = std::chrono::high_resolution_clock::now();
-            decmsg = aes_decrypt(msg);
-            auto dend = std::chrono::high_resolution_clock::now();
-            decryptelapsed = dend - dstart;
+            V2xKpi::CompressionRecord entry{txSlUes.Get(i)->GetId(), {}, 0.0};
+            compressed = compressor->compress(plain, &entry.result);
+            NS_ABORT_MSG_UNLESS(compressor->decompress(compressed, &entry.decompressTime) ==
+                                    plain,
+                                "Compression round trip failed");
+            compressionLog.push_back(entry);
+            plain = compressed;
         }
-        else if (encryptType == 2) //RSA
+        
+        
+        // record encryption overhead
+        TimingStats encryptStats;
+        TimingStats decryptStats;
+        // Ciphertext handed to the application: a view into the pooled
+        // buffer it was encrypted into, into the corpus mapping, or into
+        // msg, so it is never copied again before SetFill.
+        PooledBuffer wire;
+        std::span<const std::byte> payload;
+        std::size_t declength = 0;
+
+        // The wire format of every engine comes from crypto_engine, so the
+        // receivers (see decryptOnRx) decode exactly what is sent here.
+        CryptoEngine engine = static_cast<CryptoEngine>(encryptType);
+        double cryptoDelay = 0.0; // modelled encryption delay before the first send
+        if (costModelPtr)
         {
-            std::cout << msg;
-            auto start = std::chrono::high_resolution_clock::now();
-            auto rct = rsa_encrypt_chunks(msg);
-            auto end = std::chrono::high_resolution_clock::now();
-            encryptelapsed = end - start;
-            for (const auto& s : rct) {
-                msg += s;
+            // Sizes come from a real encryption (or the ciphertext stored in
+            // the corpus), times from the model; the round-trip check is
+            // skipped as nothing is timed.
+            std::size_t plainLength = plain.length();
+            if (corpus.encrypted() && corpus.info().engine == engine && !compressor)
+            {
+                NS_ABORT_MSG_UNLESS(engine_decrypt(engine, std::string(record.wire)) == plain,
+                                    "Record " << i % corpus.size() << " of " << camCorpus
+                                              << " does not decrypt back");
+                payload = std::as_bytes(std::span(record.wire));
             }
-            std::cout << msg;
-
-            auto dstart = std::chrono::high_resolution_clock::now();
-            auto rdecmsg = rsa_decrypt_chunks(rct);
-            auto dend = std::chrono::high_resolution_clock::now();
-            decryptelapsed = dend - dstart;
-            decmsg = rdecmsg.value_or("");
-            std::cout << decmsg;
-        }
-        else if (encryptType == 3) //ECC
-        {
-            auto start = std::chrono::high_resolution_clock::now();
-            msg = ecc_encrypt(msg);
-            auto end = std::chrono::high_resolution_clock::now();
-            encryptelapsed = end - start;
-
-            auto dstart = std::chrono::high_resolution_clock::now();
-            decmsg = ecc_decrypt(msg);
-            auto dend = std::chrono::high_resolution_clock::now();
-            decryptelapsed = dend - dstart;
+            else
+            {
+                msg = engine_encrypt(engine, std::string(plain));
+                payload = std::as_bytes(std::span(msg));
+            }
+            encryptStats = single_sample(costModelPtr->encrypt_delay(engine, plainLength));
+            decryptStats = single_sample(costModelPtr->decrypt_delay(engine, payload.size()));
+            declength = plainLength;
+            cryptoDelay = encryptStats.median;
         }
-        else if (encryptType == 4) //Homomorphic
+        else
         {
-            auto start = std::chrono::high_resolution_clock::now();
-            auto ct = example::encrypt_string(msg);
-            auto end = std::chrono::high_resolution_clock::now();
-            encryptelapsed = end - start;
-            std::stringstream ss;
-            ct.save(ss); // serialize to stream
-            msg = ss.str();
-
-            auto dstart = std::chrono::high_resolution_clock::now();
-            decmsg = example::decrypt_string(ct);
-            auto dend = std::chrono::high_resolution_clock::now();
-            decryptelapsed = dend - dstart;
+            // Every iteration encrypts the same plaintext into the same
+            // pooled buffer, so only the engines are timed, not the
+            // allocator; the last ciphertext is the one sent.
+            wire = buffer_pool_acquire(engine_encrypted_size(engine, plain.size()));
+            std::optional<std::size_t> wireLength;
+            encryptStats = time_repeated(timingOpts, [&] {
+                wireLength =
+                    engine_encrypt_into(engine, std::as_bytes(std::span(plain)), wire.span());
+            });
+            NS_ABORT_MSG_UNLESS(wireLength,
+                                "Encryption with " << engine_name(engine) << " failed");
+            wire.resize(*wireLength);
+            payload = wire.span();
+
+            PooledBuffer decrypted = buffer_pool_acquire(engine_decrypted_size(engine, *wireLength));
+            decryptStats = time_repeated(timingOpts, [&] {
+                declength = engine_decrypt_into(engine, wire.span(), decrypted.span()).value_or(0);
+            });
+            if (engine == CryptoEngine::None) // No encryption
+            {
+                encryptStats = single_sample(0.0);
+                decryptStats = single_sample(0.0);
+            }
         }
-        else // No encryption
+        cryptoLog.push_back({ txSlUes.Get(i)->GetId(), encryptStats, decryptStats, payload.size(), declength });
+        for (const auto& sample : engine_take_perf_samples())
         {
-            auto start = std::chrono::high_resolution_clock::now();
-            decmsg = msg;
-            encryptelapsed = start - start;
-            decryptelapsed = start - start;
+            cryptoPerfLog.push_back({txSlUes.Get(i)->GetId(), sample});
         }
-        cryptoLog.push_back({ txSlUes.Get(i)->GetId(), encryptelapsed.count(), decryptelapsed.count(), msg.length(), decmsg.length() });
 
 
         uint32_t packetSize = 1024;
@@ -1222,13 +1547,13 @@ main(int argc, char* argv[])
             // Max Transmission unit to base packet size off of. Can still work at larger sizes
             // 1500 is common for most comunications 1420 often used for 5G
             uint32_t mtu = 1420; 
-            maxPacketCount = std::ceil(static_cast<double>(msg.length()) / mtu);
-            packetSize = std::ceil(static_cast<double>(msg.length()) / maxPacketCount);
+            maxPacketCount = std::ceil(static_cast<double>(payload.size()) / mtu);
+            packetSize = std::ceil(static_cast<double>(payload.size()) / maxPacketCount);
         }
         Time interPacketInterval;
         
         if (usesetfill) {
-            interPacketInterval = Seconds(((double)msg.length() * 8.0 / (DataRate(dataRateBeString).GetBitRate())));
+            interPacketInterval = Seconds(((double)payload.size() * 8.0 / (DataRate(dataRateBeString).GetBitRate())));
         } else {
             interPacketInterval = Seconds(((double)packetSize * 8.0 / (DataRate(dataRateBeString).GetBitRate())));
         }
@@ -1242,15 +1567,22 @@ main(int argc, char* argv[])
         double jitter = startTimeSeconds->GetValue();
 
 
-        Time appStart = slBearersActivationTime + Seconds(jitter) + 
+        Time appStart = slBearersActivationTime + Seconds(jitter) + Seconds(cryptoDelay) +
                 Seconds(((double)udpPacketSizeBe * 8.0) / (DataRate(dataRateBeString).GetBitRate()));
         clientApps.Get(i)->SetStartTime(appStart);
 
         if (usesetfill) {
-            sidelinkClient.SetFill (clientApps.Get (i), msg);
+            // SetFill copies the bytes into the application, without the
+            // string terminator SetFill(std::string) appends; the const_cast
+            // is only there for its non-const pointer parameter.
+            auto fill = reinterpret_cast<const uint8_t*>(payload.data());
+            sidelinkClient.SetFill(clientApps.Get(i),
+                                   const_cast<uint8_t*>(fill),
+                                   payload.size(),
+                                   payload.size());
         }
 
-        realAppStart = slBearersActivationTime.GetSeconds() + jitter +
+        realAppStart = slBearersActivationTime.GetSeconds() + jitter + cryptoDelay +
                        ((double)udpPacketSizeBe * 8.0) / (DataRate(dataRateBeString).GetBitRate());
         realAppStopTime = realAppStart + simTime.GetSeconds();
         clientApps.Get(i)->SetStopTime(Seconds(realAppStopTime));
@@ -1264,14 +1596,36 @@ main(int argc, char* argv[])
                   << std::endl;
     }
 
+    engine_set_perf_counters(false);
+    endMemoryPhase("txCrypto");
+    if (perfCounters && !cryptoPerfLog.empty() && !cryptoPerfLog.front().sample.counts.valid)
+    {
+        std::cout << "perf_event_open not available, cryptoPerfCounters will hold NULL counters"
+                  << std::endl;
+    }
+
     ApplicationContainer serverApps;
-    UdpEchoServerHelper sidelinkSink(port);
-    //sidelinkSink.SetAttribute("EnableSeqTsSizeHeader", BooleanValue(true));
-    for (uint32_t i = 0; i < rxSlUes.GetN(); i++)
+    if (decryptOnRx)
     {
-        serverApps.Add(sidelinkSink.Install(rxSlUes.Get(i)));
+        CamCryptoSinkHelper cryptoSink(port, static_cast<CryptoEngine>(encryptType));
+        cryptoSink.SetCostModel(costModelPtr);
+        cryptoSink.SetCompressor(compressor);
+        cryptoSink.SetAttribute("BinaryCam", BooleanValue(binaryCam));
+        // the payload is set from its bytes, without a string terminator
+        cryptoSink.SetAttribute("FillTerminator", BooleanValue(false));
+        serverApps.Add(cryptoSink.Install(rxSlUes));
         serverApps.Start(Seconds(0.0));
     }
+    else
+    {
+        UdpEchoServerHelper sidelinkSink(port);
+        //sidelinkSink.SetAttribute("EnableSeqTsSizeHeader", BooleanValue(true));
+        for (uint32_t i = 0; i < rxSlUes.GetN(); i++)
+        {
+            serverApps.Add(sidelinkSink.Install(rxSlUes.Get(i)));
+            serverApps.Start(Seconds(0.0));
+        }
+    }
 
     /*
      * Hook the traces, for trace data to be stored in a database
@@ -1395,14 +1749,31 @@ main(int argc, char* argv[])
     V2xKpi v2xKpi;
     v2xKpi.SetDbPath(outputDir + exampleName);
     v2xKpi.SetTxAppDuration(txAppDuration);
+    v2xKpi.SetKpiBatchSize(kpiBatchSize);
+    v2xKpi.SetDbWal(kpiWal);
+    if (kpiMmapMb > 0)
+    {
+        v2xKpi.SetDbMmapSize(kpiMmapMb << 20);
+    }
+    v2xKpi.SetDbCacheSize(kpiCacheMb << 10);
+    v2xKpi.SetDbTempStoreMemory(kpiTempStoreMemory);
+    v2xKpi.SetDbSynchronous(kpiSynchronous);
+    v2xKpi.SetDbReadOnlyReaders(kpiReadOnly || kpiThreads > 1);
+    v2xKpi.SetKpiThreads(kpiThreads);
     SavePositionPerIP(&v2xKpi);
     v2xKpi.SetRangeForV2xKpis(200);
-
-    for (const auto& entry : cryptoLog)
+    if (kpiPositionPeriod > 0.0)
+    {
+        SamplePositionPerIP(&v2xKpi, Seconds(kpiPositionPeriod));
+    }
+    OnlineKpiEngine kpiEngine;
+    if (useOnlineKpis)
     {
-    v2xKpi.SaveCryptoOverhead(entry.nodeId, entry.encryptTime, entry.decryptTime, entry.length, entry.declength);
+        onlineKpis = &kpiEngine;
     }
 
+    v2xKpi.SaveCryptoOverhead(cryptoLog);
+
     if (generateInitialPosGnuScript)
     {
         std::string initPosFileName = "init-pos-ues-" + exampleName + ".txt";
@@ -1426,6 +1797,7 @@ main(int argc, char* argv[])
 
     Simulator::Stop(simStopTime);
     Simulator::Run();
+    endMemoryPhase("simulation");
 
     /*
      * VERY IMPORTANT: Do not forget to empty the database cache, which would
@@ -1437,7 +1809,61 @@ main(int argc, char* argv[])
     pscchPhyStats.EmptyCache();
     psschPhyStats.EmptyCache();
     ueRlcRxStats.EmptyCache();
-    v2xKpi.WriteKpis();
+    if (onlineKpis)
+    {
+        v2xKpi.WriteKpis(kpiEngine);
+        onlineKpis = nullptr;
+    }
+    else
+    {
+        v2xKpi.WriteKpis();
+    }
+
+    if (decryptOnRx)
+    {
+        std::vector<V2xKpi::RxCryptoRecord> rxCryptoLog;
+        for (uint32_t ac = 0; ac < serverApps.GetN(); ac++)
+        {
+            Ptr<CamCryptoSink> sink = DynamicCast<CamCryptoSink>(serverApps.Get(ac));
+            for (const auto& entry : sink->GetEntries())
+            {
+                rxCryptoLog.push_back({sink->GetNode()->GetId(),
+                                       entry.rxTime,
+                                       entry.srcIp,
+                                       entry.pktSize,
+                                       entry.decryptTime,
+                                       entry.declength,
+                                       entry.valid,
+                                       entry.queueTime,
+                                       entry.modelled,
+                                       entry.cams,
+                                       entry.parseTime});
+            }
+        }
+        v2xKpi.SaveRxCryptoOverhead(rxCryptoLog);
+    }
+
+    if (perfCounters)
+    {
+        v2xKpi.SaveCryptoPerfCounters(cryptoPerfLog);
+    }
+
+    if (compressor)
+    {
+        v2xKpi.SaveCompressionOverhead(compressionLog);
+    }
+
+    if (trackMemory)
+    {
+        endMemoryPhase("kpi");
+        alloc_tracking_enable(false);
+        v2xKpi.SaveMemoryFootprint(memoryLog);
+    }
+
+    BufferPoolStats poolStats = buffer_pool_stats();
+    std::cout << "Crypto buffer pool hit rate " << poolStats.hit_rate() << " ("
+              << poolStats.local_hits << " local, " << poolStats.global_hits << " shared, "
+              << poolStats.misses << " allocated)" << std::endl;
 
     // GtkConfigStore config;
     //  config.ConfigureAttributes ();
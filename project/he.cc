@@ -42,11 +42,15 @@
 #include <string_view>
 #include <vector>
 #include <memory>
+#include <stdexcept>
 #include <seal/seal.h>
 
 namespace example {
 namespace {
 
+    std::optional<uint64_t> key_seed; // see set_key_seed
+    bool keys_built = false;
+
     // Static Singleton containing all SEAL components
     struct SEALSingleton {
         seal::EncryptionParameters parms;
@@ -69,9 +73,24 @@ namespace {
 
             context = std::make_shared<seal::SEALContext>(parms);
 
-            keygen = std::make_unique<seal::KeyGenerator>(*context);
+            if (key_seed) {
+                // The secret key comes from a context whose random generator
+                // is seeded; parms_id does not depend on the generator, so
+                // the key is valid for the shared context too, whose
+                // encryptions keep drawing fresh randomness.
+                seal::prng_seed_type seed{};
+                seed[0] = *key_seed;
+                seed[1] = 4; // CryptoEngine::He, as the other engines' streams
+                seal::EncryptionParameters seeded = parms;
+                seeded.set_random_generator(std::make_shared<seal::Blake2xbPRNGFactory>(seed));
+                seal::SEALContext seeded_context(seeded);
+                secret_key = seal::KeyGenerator(seeded_context).secret_key();
+                keygen = std::make_unique<seal::KeyGenerator>(*context, secret_key);
+            } else {
+                keygen = std::make_unique<seal::KeyGenerator>(*context);
+                secret_key = keygen->secret_key();
+            }
             keygen->create_public_key(public_key);
-            secret_key = keygen->secret_key();
             keygen->create_relin_keys(relin_keys);
             keygen->create_galois_keys(galois_keys);
 
@@ -79,6 +98,7 @@ namespace {
             decryptor = std::make_unique<seal::Decryptor>(*context, secret_key);
             evaluator = std::make_unique<seal::Evaluator>(*context);
             batch_encoder = std::make_unique<seal::BatchEncoder>(*context);
+            keys_built = true;
         }
     };
 
@@ -89,7 +109,112 @@ namespace {
 
 } // namespace
 
+bool set_key_seed(uint64_t seed) {
+    if (keys_built) return false;
+    key_seed = seed;
+    return true;
+}
+
 seal::Ciphertext encrypt_string(std::string_view msg) {
     if (msg.empty()) throw std::invalid_argument("Input message is empty");
 
     std::vector<uint64_t> ascii_values;
+    const auto &s = singleton();
+    const size_t slot_count = s.batch_encoder->slot_count();
+    if (msg.size() > slot_count) throw std::invalid_argument("Input message exceeds slot count");
+
+    // Bytes go in as value + 1, so 0 only ever marks the unused slots and
+    // binary messages (e.g. binary CAMs) with zero bytes survive.
+    ascii_values.reserve(slot_count);
+    for (unsigned char c : msg) {
+        ascii_values.push_back(static_cast<uint64_t>(c) + 1);
+    }
+    ascii_values.resize(slot_count, 0ULL);
+
+    seal::Plaintext plain;
+    s.batch_encoder->encode(ascii_values, plain);
+
+    seal::Ciphertext cipher;
+    s.encryptor->encrypt(plain, cipher);
+    return cipher;
+}
+
+std::string decrypt_string(const seal::Ciphertext &cipher) {
+    const auto &s = singleton();
+
+    seal::Plaintext plain;
+    s.decryptor->decrypt(cipher, plain);
+
+    std::vector<uint64_t> ascii_values;
+    s.batch_encoder->decode(plain, ascii_values);
+
+    std::string result;
+    for (uint64_t v : ascii_values) {
+        if (v == 0) break;
+        result.push_back(static_cast<char>(v - 1));
+    }
+    return result;
+}
+
+std::string save_ciphertext(const seal::Ciphertext &cipher) {
+    std::string out(static_cast<size_t>(cipher.save_size()), '\0');
+    auto written = cipher.save(reinterpret_cast<seal::seal_byte *>(out.data()), out.size());
+    out.resize(static_cast<size_t>(written));
+    return out;
+}
+
+seal::Ciphertext load_ciphertext(std::string_view bytes) {
+    seal::Ciphertext cipher;
+    cipher.load(*singleton().context,
+                reinterpret_cast<const seal::seal_byte *>(bytes.data()), bytes.size());
+    return cipher;
+}
+
+std::size_t encrypted_size() {
+    // save_size() is a worst case that only depends on the parameters, so
+    // one sample ciphertext gives the bound for all of them.
+    static const std::size_t size = static_cast<std::size_t>(encrypt_string("\x01").save_size());
+    return size;
+}
+
+std::size_t decrypted_size() {
+    return singleton().batch_encoder->slot_count();
+}
+
+std::optional<std::size_t> encrypt_into(std::span<const std::byte> msg, std::span<std::byte> out) {
+    seal::Ciphertext cipher =
+        encrypt_string(std::string_view(reinterpret_cast<const char *>(msg.data()), msg.size()));
+    if (out.size() < static_cast<std::size_t>(cipher.save_size())) return std::nullopt;
+    auto written = cipher.save(reinterpret_cast<seal::seal_byte *>(out.data()), out.size());
+    return static_cast<std::size_t>(written);
+}
+
+std::optional<std::size_t> decrypt_into(std::span<const std::byte> bytes, std::span<std::byte> out) {
+    const auto &s = singleton();
+    std::vector<uint64_t> ascii_values;
+    try {
+        seal::Ciphertext cipher;
+        cipher.load(*s.context, reinterpret_cast<const seal::seal_byte *>(bytes.data()),
+                    bytes.size());
+
+        seal::Plaintext plain;
+        s.decryptor->decrypt(cipher, plain);
+        s.batch_encoder->decode(plain, ascii_values);
+    } catch (...) {
+        return std::nullopt;
+    }
+
+    std::size_t length = 0;
+    for (uint64_t v : ascii_values) {
+        if (v == 0) break;
+        if (length == out.size()) return std::nullopt;
+        out[length++] = static_cast<std::byte>(v - 1);
+    }
+    return length;
+}
+
+std::size_t memory_pool_bytes() {
+    return static_cast<std::size_t>(seal::MemoryManager::GetPool().alloc_byte_count());
+}
+
+} // namespace example
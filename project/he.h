@@ -3,13 +3,50 @@
 
 #pragma once
 #include <seal/seal.h>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
 #include <string>
 #include <string_view>
 
 namespace example {
+// Derives the secret key from seed instead of drawing it at random, so
+// ciphertexts stored by one process decrypt in another. Only the key
+// generation is seeded, the encryptions stay randomized. Returns false if
+// the keys were already generated.
+bool set_key_seed(uint64_t seed);
+
 seal::Ciphertext encrypt_string(std::string_view msg);
 
 std::string decrypt_string(const seal::Ciphertext &cipher);
+
+// Serializes a ciphertext into the byte form carried in packets.
+std::string save_ciphertext(const seal::Ciphertext &cipher);
+
+// Rebuilds a ciphertext from bytes produced by save_ciphertext.
+// Throws if the bytes are not a valid ciphertext for the shared context.
+seal::Ciphertext load_ciphertext(std::string_view bytes);
+
+// Span API: the message is encoded from the input in place and the
+// serialized ciphertext written straight into the caller buffer.
+// encrypt_into throws like encrypt_string for messages longer than the slot
+// count; both return std::nullopt when out is too small, and decrypt_into
+// also for bytes that are not a valid ciphertext.
+
+// Upper bound of the serialized size of any ciphertext.
+std::size_t encrypted_size();
+
+// Upper bound of a decrypted message, i.e. the slot count.
+std::size_t decrypted_size();
+
+std::optional<std::size_t> encrypt_into(std::span<const std::byte> msg, std::span<std::byte> out);
+
+std::optional<std::size_t> decrypt_into(std::span<const std::byte> bytes, std::span<std::byte> out);
+
+// Bytes currently allocated by SEAL's global memory pool, which holds the
+// polynomial buffers of keys, plaintexts and ciphertexts.
+std::size_t memory_pool_bytes();
 } // namespace example
 
 #endif
\ No newline at end of file
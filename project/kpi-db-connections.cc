@@ -0,0 +1,190 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+
+// SPDX-License-Identifier: GPL-2.0-only
+
+#include "kpi-db-connections.h"
+
+#include <ns3/core-module.h>
+
+#include <algorithm>
+#include <cctype>
+
+namespace ns3
+{
+
+NS_LOG_COMPONENT_DEFINE("KpiDbConnections");
+
+KpiDbConnections::KpiDbConnections()
+{
+}
+
+KpiDbConnections::~KpiDbConnections()
+{
+    for (auto* reader : m_readers)
+    {
+        sqlite3_close(reader);
+    }
+    sqlite3_close(m_writer);
+    m_writer = nullptr;
+}
+
+void
+KpiDbConnections::SetPath(const std::string& path)
+{
+    NS_ABORT_MSG_IF(IsOpen(), "The DB " << m_path << " is already open");
+    m_path = path;
+}
+
+void
+KpiDbConnections::SetWal(bool wal)
+{
+    NS_ABORT_MSG_IF(IsOpen(), "Pragmas must be set before the DB is opened");
+    m_wal = wal;
+}
+
+void
+KpiDbConnections::SetMmapSize(uint64_t bytes)
+{
+    NS_ABORT_MSG_IF(IsOpen(), "Pragmas must be set before the DB is opened");
+    m_mmapSet = true;
+    m_mmapSize = bytes;
+}
+
+void
+KpiDbConnections::SetCacheSize(uint64_t kib)
+{
+    NS_ABORT_MSG_IF(IsOpen(), "Pragmas must be set before the DB is opened");
+    m_cacheSize = kib;
+}
+
+void
+KpiDbConnections::SetTempStoreMemory(bool memory)
+{
+    NS_ABORT_MSG_IF(IsOpen(), "Pragmas must be set before the DB is opened");
+    m_tempStoreMemory = memory;
+}
+
+void
+KpiDbConnections::SetSynchronous(const std::string& level)
+{
+    NS_ABORT_MSG_IF(IsOpen(), "Pragmas must be set before the DB is opened");
+    std::string upper = level;
+    std::transform(upper.begin(), upper.end(), upper.begin(), [](unsigned char c) {
+        return std::toupper(c);
+    });
+    NS_ABORT_MSG_UNLESS(upper.empty() || upper == "OFF" || upper == "NORMAL" || upper == "FULL" ||
+                            upper == "EXTRA",
+                        "Unknown synchronous level " << level);
+    m_synchronous = upper;
+}
+
+void
+KpiDbConnections::SetReadOnlyReaders(bool readOnly)
+{
+    NS_ABORT_MSG_IF(IsOpen(), "Readers must be set before the DB is opened");
+    m_readOnlyReaders = readOnly;
+}
+
+sqlite3*
+KpiDbConnections::GetWriter()
+{
+    if (m_writer == nullptr)
+    {
+        m_writer = Open(false);
+    }
+    return m_writer;
+}
+
+sqlite3*
+KpiDbConnections::GetReader(uint32_t index)
+{
+    if (!m_readOnlyReaders)
+    {
+        return GetWriter();
+    }
+    // Open the writer first, so that the DB is already in WAL mode, if
+    // requested, when the readers attach to it.
+    GetWriter();
+    if (index >= m_readers.size())
+    {
+        m_readers.resize(index + 1, nullptr);
+    }
+    if (m_readers[index] == nullptr)
+    {
+        m_readers[index] = Open(true);
+    }
+    return m_readers[index];
+}
+
+bool
+KpiDbConnections::IsOpen() const
+{
+    return m_writer != nullptr ||
+           std::any_of(m_readers.begin(), m_readers.end(), [](sqlite3* db) {
+               return db != nullptr;
+           });
+}
+
+sqlite3*
+KpiDbConnections::Open(bool readOnly)
+{
+    NS_ABORT_MSG_IF(m_path.empty(), "The path of the DB is not set");
+
+    sqlite3* db = nullptr;
+    int flags = readOnly ? SQLITE_OPEN_READONLY : (SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE);
+    int rc = sqlite3_open_v2(m_path.c_str(), &db, flags, nullptr);
+    NS_ABORT_MSG_UNLESS(rc == SQLITE_OK, "Error open DB. Db error: " << sqlite3_errmsg(db));
+
+    if (m_wal && !readOnly)
+    {
+        // The mode can not change while another connection holds a lock;
+        // the KPIs are still correct without WAL, so only warn.
+        std::string mode = Pragma(db, "journal_mode = WAL");
+        if (mode != "wal")
+        {
+            NS_LOG_WARN("Could not switch " << m_path << " to WAL, journal mode is " << mode);
+        }
+    }
+    if (m_mmapSet)
+    {
+        Pragma(db, "mmap_size = " + std::to_string(m_mmapSize));
+    }
+    if (m_cacheSize > 0)
+    {
+        // A negative cache_size is in KiB, a positive one in pages.
+        Pragma(db, "cache_size = -" + std::to_string(m_cacheSize));
+    }
+    if (m_tempStoreMemory)
+    {
+        Pragma(db, "temp_store = MEMORY");
+    }
+    if (!m_synchronous.empty() && !readOnly)
+    {
+        Pragma(db, "synchronous = " + m_synchronous);
+    }
+    return db;
+}
+
+std::string
+KpiDbConnections::Pragma(sqlite3* db, const std::string& pragma)
+{
+    sqlite3_stmt* stmt;
+    std::string sql = "PRAGMA " + pragma + ";";
+    int rc = sqlite3_prepare_v2(db, sql.c_str(), static_cast<int>(sql.size()), &stmt, nullptr);
+    NS_ABORT_MSG_UNLESS(rc == SQLITE_OK, "Error " << sql << " Db error: " << sqlite3_errmsg(db));
+
+    std::string result;
+    rc = sqlite3_step(stmt);
+    if (rc == SQLITE_ROW && sqlite3_column_text(stmt, 0) != nullptr)
+    {
+        result = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 0));
+    }
+    else if (rc != SQLITE_DONE && rc != SQLITE_ROW)
+    {
+        NS_LOG_WARN("Error " << sql << " Db error: " << sqlite3_errmsg(db));
+    }
+    sqlite3_finalize(stmt);
+    return result;
+}
+
+} // namespace ns3
@@ -0,0 +1,135 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+
+// SPDX-License-Identifier: GPL-2.0-only
+
+#ifndef KPI_DB_CONNECTIONS_H
+#define KPI_DB_CONNECTIONS_H
+
+#include <inttypes.h>
+#include <sqlite3.h>
+#include <string>
+#include <vector>
+
+namespace ns3
+{
+
+/**
+ * \brief Owns the connections of V2xKpi to the trace DB.
+ *
+ * There is one writer connection, used to create and fill the KPI tables,
+ * and optionally read-only connections used to scan the trace tables. All
+ * of them are opened lazily, on first use, and configured with the
+ * pragmas set beforehand; the ones left unset keep the SQLite defaults.
+ *
+ * WAL is a property of the DB file, so it is switched on through the
+ * writer and stays on for later runs. The other pragmas are per
+ * connection and are applied to every handle: mmap_size and cache_size
+ * matter most to the readers, which scan trace tables of up to several
+ * GB, and synchronous only to the writer.
+ */
+class KpiDbConnections
+{
+  public:
+    /**
+     * \brief KpiDbConnections constructor
+     */
+    KpiDbConnections();
+
+    /**
+     * \brief KpiDbConnections destructor, closes every connection
+     */
+    ~KpiDbConnections();
+
+    KpiDbConnections(const KpiDbConnections&) = delete;
+    KpiDbConnections& operator=(const KpiDbConnections&) = delete;
+
+    /**
+     * \brief Set the path of the DB file
+     * \param path The path, extension included
+     */
+    void SetPath(const std::string& path);
+    /**
+     * \brief Switch the DB to write-ahead logging when the writer is opened
+     * \param wal True to use WAL
+     */
+    void SetWal(bool wal);
+    /**
+     * \brief Set the size of the memory map of each connection
+     * \param bytes The maximum number of bytes mapped, 0 for no mmap
+     */
+    void SetMmapSize(uint64_t bytes);
+    /**
+     * \brief Set the page cache size of each connection
+     * \param kib The cache size in KiB
+     */
+    void SetCacheSize(uint64_t kib);
+    /**
+     * \brief Keep temporary tables and indices, e.g., of ORDER BY, in memory
+     * \param memory True to keep them in memory
+     */
+    void SetTempStoreMemory(bool memory);
+    /**
+     * \brief Set the synchronous level of the writer
+     * \param level One of "OFF", "NORMAL", "FULL" or "EXTRA"
+     */
+    void SetSynchronous(const std::string& level);
+    /**
+     * \brief Scan the trace tables through read-only connections
+     *
+     * If not set, GetReader returns the writer.
+     *
+     * \param readOnly True to open read-only connections
+     */
+    void SetReadOnlyReaders(bool readOnly);
+
+    /**
+     * \brief Get the writer connection, opening it if needed
+     * \return The writer connection
+     */
+    sqlite3* GetWriter();
+    /**
+     * \brief Get a read-only connection, opening it if needed
+     *
+     * Each index is a distinct connection, so that readers running in
+     * parallel do not share one.
+     *
+     * \param index The index of the reader
+     * \return The reader connection
+     */
+    sqlite3* GetReader(uint32_t index = 0);
+    /**
+     * \brief Check if any connection is open
+     * \return true if a connection is open
+     */
+    bool IsOpen() const;
+
+  private:
+    /**
+     * \brief Open a connection and apply the pragmas
+     * \param readOnly True to open it read-only
+     * \return The connection
+     */
+    sqlite3* Open(bool readOnly);
+    /**
+     * \brief Run a PRAGMA on a connection
+     * \param db The connection
+     * \param pragma The pragma and its value, e.g., "cache_size = -1024"
+     * \return The first column of the first row returned, if any
+     */
+    std::string Pragma(sqlite3* db, const std::string& pragma);
+
+    std::string m_path{""};          //!< path of the DB file
+    bool m_wal{false};               //!< switch the DB to WAL
+    bool m_mmapSet{false};           //!< true if m_mmapSize was set
+    uint64_t m_mmapSize{0};          //!< mmap_size in bytes
+    uint64_t m_cacheSize{0};         //!< cache_size in KiB, 0 for the default
+    bool m_tempStoreMemory{false};   //!< temp_store = MEMORY
+    std::string m_synchronous{""};   //!< synchronous level of the writer, empty for the default
+    bool m_readOnlyReaders{false};   //!< open read-only connections for the readers
+    sqlite3* m_writer{nullptr};      //!< writer connection
+    std::vector<sqlite3*> m_readers; //!< read-only connections, by index
+};
+
+} // namespace ns3
+
+#endif // KPI_DB_CONNECTIONS_H
@@ -0,0 +1,87 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+
+// SPDX-License-Identifier: GPL-2.0-only
+
+#include "kpi-node-registry.h"
+
+#include <ns3/abort.h>
+
+#include <algorithm>
+
+namespace ns3
+{
+
+KpiNodeRegistry::KpiNodeRegistry()
+{
+}
+
+uint32_t
+KpiNodeRegistry::Add(const std::string& ip, const Vector& pos)
+{
+    uint32_t node = Intern(ip);
+    NS_ABORT_MSG_IF(m_located[node],
+                    "Insert Error: Pos of the ip " << ip << " already exist in the map");
+    m_positions[node] = pos;
+    m_located[node] = true;
+    return node;
+}
+
+uint32_t
+KpiNodeRegistry::Intern(const std::string& ip)
+{
+    auto [it, inserted] = m_index.try_emplace(ip, m_ips.size());
+    if (inserted)
+    {
+        m_ips.push_back(ip);
+        m_positions.emplace_back();
+        m_located.push_back(false);
+        m_txPkts.push_back(0);
+    }
+    return it->second;
+}
+
+uint32_t
+KpiNodeRegistry::Find(const std::string& ip) const
+{
+    auto it = m_index.find(ip);
+    return it == m_index.end() ? NONE : it->second;
+}
+
+uint32_t
+KpiNodeRegistry::GetN() const
+{
+    return m_ips.size();
+}
+
+const std::string&
+KpiNodeRegistry::GetIp(uint32_t node) const
+{
+    return m_ips[node];
+}
+
+const Vector&
+KpiNodeRegistry::GetPosition(uint32_t node) const
+{
+    NS_ABORT_MSG_IF(!m_located[node], "Unable to find the position of IP " << m_ips[node]);
+    return m_positions[node];
+}
+
+uint64_t
+KpiNodeRegistry::GetTxPkts(uint32_t node) const
+{
+    return m_txPkts[node];
+}
+
+void
+KpiNodeRegistry::SetTxPkts(uint32_t node, uint64_t txPkts)
+{
+    m_txPkts[node] = txPkts;
+}
+
+void
+KpiNodeRegistry::ClearTxPkts()
+{
+    std::fill(m_txPkts.begin(), m_txPkts.end(), 0);
+}
+
+} // namespace ns3
@@ -0,0 +1,109 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+
+// SPDX-License-Identifier: GPL-2.0-only
+
+#ifndef KPI_NODE_REGISTRY_H
+#define KPI_NODE_REGISTRY_H
+
+#include <ns3/vector.h>
+
+#include <inttypes.h>
+#include <limits>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace ns3
+{
+
+/**
+ * \brief Dense index of the nodes V2xKpi computes KPIs for.
+ *
+ * Each IP address is given an index, in registration order, and the
+ * per node data is kept in arrays by index: IP, position and number of
+ * transmitted packets. Only the IP to index mapping is a hash lookup;
+ * V2xKpi resolves it once per IP, so the KPI loops access the arrays
+ * directly.
+ *
+ * The nodes are registered with their position before the KPIs are
+ * computed. IPs seen in the traces but never registered may be added
+ * without a position, to hold their counters; asking for their position
+ * aborts.
+ */
+class KpiNodeRegistry
+{
+  public:
+    /// index returned for an unknown IP
+    static constexpr uint32_t NONE = std::numeric_limits<uint32_t>::max();
+
+    /**
+     * \brief KpiNodeRegistry constructor
+     */
+    KpiNodeRegistry();
+
+    /**
+     * \brief Register a node with its position
+     * \param ip The IP of the node, which must not be registered yet
+     * \param pos The position of the node
+     * \return The index of the node
+     */
+    uint32_t Add(const std::string& ip, const Vector& pos);
+    /**
+     * \brief Get the index of an IP, adding it without a position if unknown
+     * \param ip The IP
+     * \return The index of the node
+     */
+    uint32_t Intern(const std::string& ip);
+    /**
+     * \brief Find the index of an IP
+     * \param ip The IP
+     * \return The index of the node, NONE if unknown
+     */
+    uint32_t Find(const std::string& ip) const;
+    /**
+     * \brief Get the number of nodes
+     * \return The number of nodes
+     */
+    uint32_t GetN() const;
+
+    /**
+     * \brief Get the IP of a node
+     * \param node The index of the node
+     * \return The IP
+     */
+    const std::string& GetIp(uint32_t node) const;
+    /**
+     * \brief Get the position of a node, aborting if it was not registered
+     *        with one
+     * \param node The index of the node
+     * \return The position
+     */
+    const Vector& GetPosition(uint32_t node) const;
+    /**
+     * \brief Get the number of packets transmitted from the IP of a node
+     * \param node The index of the node
+     * \return The number of packets
+     */
+    uint64_t GetTxPkts(uint32_t node) const;
+    /**
+     * \brief Set the number of packets transmitted from the IP of a node
+     * \param node The index of the node
+     * \param txPkts The number of packets
+     */
+    void SetTxPkts(uint32_t node, uint64_t txPkts);
+    /**
+     * \brief Reset the number of transmitted packets of every node
+     */
+    void ClearTxPkts();
+
+  private:
+    std::unordered_map<std::string, uint32_t> m_index; //!< index of each IP
+    std::vector<std::string> m_ips;                    //!< IP, by index
+    std::vector<Vector> m_positions;                   //!< position, by index
+    std::vector<bool> m_located;                       //!< true if registered with a position
+    std::vector<uint64_t> m_txPkts;                    //!< transmitted packets, by index
+};
+
+} // namespace ns3
+
+#endif // KPI_NODE_REGISTRY_H
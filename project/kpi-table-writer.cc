@@ -0,0 +1,247 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+
+// SPDX-License-Identifier: GPL-2.0-only
+
+#include "kpi-table-writer.h"
+
+#include <ns3/core-module.h>
+
+#include <sstream>
+
+namespace ns3
+{
+
+NS_LOG_COMPONENT_DEFINE("KpiTableWriter");
+
+KpiTableWriter::KpiTableWriter(sqlite3* db,
+                               const std::string& table,
+                               const std::vector<std::string>& columns,
+                               uint32_t seed,
+                               uint64_t run,
+                               uint32_t batchSize)
+    : m_db(db),
+      m_columns(static_cast<int>(columns.size()) + 2),
+      m_seed(seed),
+      m_run(run),
+      m_batchSize(batchSize)
+{
+    NS_ABORT_MSG_UNLESS(m_db != nullptr, "The DB of table " << table << " is not open");
+
+    std::vector<std::string> definitions = columns;
+    definitions.emplace_back("SEED INTEGER NOT NULL");
+    definitions.emplace_back("RUN INTEGER NOT NULL");
+    if (!HasSchema(table, definitions))
+    {
+        RenameOutdated(table);
+    }
+
+    std::string cmd = "CREATE TABLE IF NOT EXISTS " + table + " (";
+    for (std::size_t i = 0; i < definitions.size(); ++i)
+    {
+        cmd += (i > 0 ? "," : "") + definitions[i];
+    }
+    cmd += ");";
+    int rc = sqlite3_exec(m_db, cmd.c_str(), nullptr, nullptr, nullptr);
+    NS_ABORT_MSG_UNLESS(rc == SQLITE_OK,
+                        "Error creating table. Db error: " << sqlite3_errmsg(m_db));
+
+    Exec("BEGIN TRANSACTION;");
+
+    sqlite3_stmt* stmt;
+    cmd = "DELETE FROM \"" + table + "\" WHERE SEED = ? AND RUN = ?;";
+    rc = sqlite3_prepare_v2(m_db, cmd.c_str(), static_cast<int>(cmd.size()), &stmt, nullptr);
+    NS_ABORT_MSG_UNLESS(
+        rc == SQLITE_OK,
+        "Could not prepare correctly the delete statement. Db error: " << sqlite3_errmsg(m_db));
+    NS_ABORT_UNLESS(sqlite3_bind_int(stmt, 1, m_seed) == SQLITE_OK);
+    NS_ABORT_UNLESS(sqlite3_bind_int64(stmt, 2, m_run) == SQLITE_OK);
+    rc = sqlite3_step(stmt);
+    NS_ABORT_MSG_UNLESS(
+        rc == SQLITE_OK || rc == SQLITE_DONE,
+        "Could not correctly execute the statement. Db error: " << sqlite3_errmsg(m_db));
+    rc = sqlite3_finalize(stmt);
+    NS_ABORT_MSG_UNLESS(
+        rc == SQLITE_OK || rc == SQLITE_DONE,
+        "Could not correctly execute the finalize statement. Db error: " << sqlite3_errmsg(m_db));
+
+    cmd = "INSERT INTO " + table + " VALUES (?";
+    for (int col = 1; col < m_columns; ++col)
+    {
+        cmd += ", ?";
+    }
+    cmd += ");";
+    rc = sqlite3_prepare_v2(m_db, cmd.c_str(), static_cast<int>(cmd.size()), &m_stmt, nullptr);
+    NS_ABORT_MSG_UNLESS(rc == SQLITE_OK, "Error INSERT. Db error: " << sqlite3_errmsg(m_db));
+}
+
+KpiTableWriter::~KpiTableWriter()
+{
+    Finish();
+}
+
+KpiTableWriter&
+KpiTableWriter::BindInt(int64_t value)
+{
+    NS_ABORT_MSG_UNLESS(m_next <= m_columns - 2, "Too many columns bound in the row");
+    NS_ABORT_MSG_UNLESS(sqlite3_bind_int64(m_stmt, m_next++, value) == SQLITE_OK,
+                        "Db error: " << sqlite3_errmsg(m_db));
+    return *this;
+}
+
+KpiTableWriter&
+KpiTableWriter::BindDouble(double value)
+{
+    NS_ABORT_MSG_UNLESS(m_next <= m_columns - 2, "Too many columns bound in the row");
+    NS_ABORT_MSG_UNLESS(sqlite3_bind_double(m_stmt, m_next++, value) == SQLITE_OK,
+                        "Db error: " << sqlite3_errmsg(m_db));
+    return *this;
+}
+
+KpiTableWriter&
+KpiTableWriter::BindText(const std::string& value)
+{
+    NS_ABORT_MSG_UNLESS(m_next <= m_columns - 2, "Too many columns bound in the row");
+    NS_ABORT_MSG_UNLESS(sqlite3_bind_text(m_stmt,
+                                          m_next++,
+                                          value.c_str(),
+                                          static_cast<int>(value.size()),
+                                          SQLITE_STATIC) == SQLITE_OK,
+                        "Db error: " << sqlite3_errmsg(m_db));
+    return *this;
+}
+
+KpiTableWriter&
+KpiTableWriter::BindNull()
+{
+    NS_ABORT_MSG_UNLESS(m_next <= m_columns - 2, "Too many columns bound in the row");
+    NS_ABORT_MSG_UNLESS(sqlite3_bind_null(m_stmt, m_next++) == SQLITE_OK,
+                        "Db error: " << sqlite3_errmsg(m_db));
+    return *this;
+}
+
+void
+KpiTableWriter::EndRow()
+{
+    NS_ABORT_MSG_UNLESS(m_stmt != nullptr, "Row written after Finish");
+    NS_ABORT_MSG_UNLESS(m_next == m_columns - 1,
+                        "Row with " << m_next - 1 << " of " << m_columns - 2 << " columns bound");
+    NS_ABORT_UNLESS(sqlite3_bind_int(m_stmt, m_columns - 1, m_seed) == SQLITE_OK);
+    NS_ABORT_UNLESS(sqlite3_bind_int64(m_stmt, m_columns, m_run) == SQLITE_OK);
+
+    int rc = sqlite3_step(m_stmt);
+    NS_ABORT_MSG_UNLESS(
+        rc == SQLITE_OK || rc == SQLITE_DONE,
+        "Could not correctly execute the statement. Db error: " << sqlite3_errmsg(m_db));
+    NS_ABORT_UNLESS(sqlite3_reset(m_stmt) == SQLITE_OK);
+    m_next = 1;
+    m_rows++;
+
+    if (m_batchSize > 0 && ++m_pending == m_batchSize)
+    {
+        Exec("COMMIT;");
+        Exec("BEGIN TRANSACTION;");
+        m_pending = 0;
+    }
+}
+
+void
+KpiTableWriter::Finish()
+{
+    if (m_stmt == nullptr)
+    {
+        return;
+    }
+    int rc = sqlite3_finalize(m_stmt);
+    NS_ABORT_MSG_UNLESS(
+        rc == SQLITE_OK || rc == SQLITE_DONE,
+        "Could not correctly finalize the statement. Db error: " << sqlite3_errmsg(m_db));
+    m_stmt = nullptr;
+    Exec("COMMIT;");
+}
+
+uint64_t
+KpiTableWriter::GetRows() const
+{
+    return m_rows;
+}
+
+bool
+KpiTableWriter::HasSchema(const std::string& table, const std::vector<std::string>& definitions)
+{
+    sqlite3_stmt* stmt;
+    std::string cmd = "PRAGMA table_info(\"" + table + "\");";
+    int rc = sqlite3_prepare_v2(m_db, cmd.c_str(), static_cast<int>(cmd.size()), &stmt, nullptr);
+    NS_ABORT_MSG_UNLESS(rc == SQLITE_OK, "Error PRAGMA. Db error: " << sqlite3_errmsg(m_db));
+
+    // A missing table has no columns, and is created as is
+    bool same = true;
+    std::size_t col = 0;
+    while ((rc = sqlite3_step(stmt)) == SQLITE_ROW)
+    {
+        if (col == definitions.size())
+        {
+            same = false;
+            break;
+        }
+        const std::string& definition = definitions[col++];
+        std::istringstream tokens(definition);
+        std::string name;
+        std::string type;
+        tokens >> name >> type;
+        bool notNull = definition.find("NOT NULL") != std::string::npos;
+        same = same &&
+               name == reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1)) &&
+               type == reinterpret_cast<const char*>(sqlite3_column_text(stmt, 2)) &&
+               notNull == (sqlite3_column_int(stmt, 3) != 0);
+    }
+    NS_ABORT_MSG_UNLESS(rc == SQLITE_DONE || rc == SQLITE_ROW,
+                        "Error not DONE. Db error: " << sqlite3_errmsg(m_db));
+    rc = sqlite3_finalize(stmt);
+    NS_ABORT_MSG_UNLESS(
+        rc == SQLITE_OK || rc == SQLITE_DONE,
+        "Could not correctly finalize the statement. Db error: " << sqlite3_errmsg(m_db));
+    return same && (col == 0 || col == definitions.size());
+}
+
+void
+KpiTableWriter::RenameOutdated(const std::string& table)
+{
+    // The first free name out of table_old1, table_old2, ...
+    std::string renamed;
+    for (uint32_t n = 1; renamed.empty(); ++n)
+    {
+        std::string candidate = table + "_old" + std::to_string(n);
+        sqlite3_stmt* stmt;
+        std::string cmd = "SELECT 1 FROM sqlite_master WHERE type = 'table' AND name = ?;";
+        int rc =
+            sqlite3_prepare_v2(m_db, cmd.c_str(), static_cast<int>(cmd.size()), &stmt, nullptr);
+        NS_ABORT_MSG_UNLESS(rc == SQLITE_OK, "Error SELECT. Db error: " << sqlite3_errmsg(m_db));
+        NS_ABORT_UNLESS(sqlite3_bind_text(stmt,
+                                          1,
+                                          candidate.c_str(),
+                                          static_cast<int>(candidate.size()),
+                                          SQLITE_STATIC) == SQLITE_OK);
+        rc = sqlite3_step(stmt);
+        NS_ABORT_MSG_UNLESS(rc == SQLITE_ROW || rc == SQLITE_DONE,
+                            "Error SELECT. Db error: " << sqlite3_errmsg(m_db));
+        if (rc == SQLITE_DONE)
+        {
+            renamed = candidate;
+        }
+        NS_ABORT_UNLESS(sqlite3_finalize(stmt) == SQLITE_OK);
+    }
+
+    NS_LOG_WARN("Table " << table << " has the columns of an older version, its rows are moved to "
+                         << renamed);
+    Exec("ALTER TABLE \"" + table + "\" RENAME TO \"" + renamed + "\";");
+}
+
+void
+KpiTableWriter::Exec(const std::string& sql)
+{
+    int rc = sqlite3_exec(m_db, sql.c_str(), nullptr, nullptr, nullptr);
+    NS_ABORT_MSG_UNLESS(rc == SQLITE_OK,
+                        "Error " << sql << " Db error: " << sqlite3_errmsg(m_db));
+}
+
+} // namespace ns3
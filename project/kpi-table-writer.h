@@ -0,0 +1,143 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+
+// SPDX-License-Identifier: GPL-2.0-only
+
+#ifndef KPI_TABLE_WRITER_H
+#define KPI_TABLE_WRITER_H
+
+#include <inttypes.h>
+#include <sqlite3.h>
+#include <string>
+#include <vector>
+
+namespace ns3
+{
+
+/**
+ * \brief Writes the rows of one KPI table of a given seed and run.
+ *
+ * On construction the table is created if it does not exist, a
+ * transaction is opened, the rows of the same seed and run are deleted and
+ * the INSERT statement is prepared once. Each row is then bound column by
+ * column with the Bind* methods and written with EndRow, which appends the
+ * SEED and RUN columns and resets the statement for the next row.
+ *
+ * All the rows go in one transaction, unless a batch size is given, in
+ * which case the transaction is committed every batchSize rows. Finish, or
+ * the destructor, commits the last one.
+ *
+ * A table left by an older version, whose columns differ in name, type or
+ * NOT NULL constraint from the given ones, is renamed to <table>_old<N>,
+ * N being the first free index, and a new one is created: its rows are
+ * kept there for reference instead of making every INSERT fail.
+ *
+ * Strings are bound without copying, so they must stay alive until the
+ * EndRow call of their row.
+ */
+class KpiTableWriter
+{
+  public:
+    /**
+     * \brief KpiTableWriter constructor
+     * \param db The open DB connection
+     * \param table The name of the table
+     * \param columns The column definitions, e.g., "nodeId INTEGER NOT NULL",
+     *        without the SEED and RUN columns, which are always added last
+     * \param seed The seed index of the rows
+     * \param run The run index of the rows
+     * \param batchSize The number of rows per transaction, 0 for all of them
+     */
+    KpiTableWriter(sqlite3* db,
+                   const std::string& table,
+                   const std::vector<std::string>& columns,
+                   uint32_t seed,
+                   uint64_t run,
+                   uint32_t batchSize = 0);
+
+    /**
+     * \brief KpiTableWriter destructor, calls Finish
+     */
+    ~KpiTableWriter();
+
+    KpiTableWriter(const KpiTableWriter&) = delete;
+    KpiTableWriter& operator=(const KpiTableWriter&) = delete;
+
+    /**
+     * \brief Bind an integer to the next column of the row
+     * \param value The value
+     * \return this writer
+     */
+    KpiTableWriter& BindInt(int64_t value);
+    /**
+     * \brief Bind a real to the next column of the row
+     * \param value The value
+     * \return this writer
+     */
+    KpiTableWriter& BindDouble(double value);
+    /**
+     * \brief Bind a text to the next column of the row
+     * \param value The value, which must outlive the EndRow call
+     * \return this writer
+     */
+    KpiTableWriter& BindText(const std::string& value);
+    /**
+     * \brief Bind a NULL to the next column of the row
+     * \return this writer
+     */
+    KpiTableWriter& BindNull();
+
+    /**
+     * \brief Write the row bound so far
+     *
+     * Every column but SEED and RUN must have been bound.
+     */
+    void EndRow();
+
+    /**
+     * \brief Finalize the statement and commit the open transaction
+     *
+     * Further calls have no effect.
+     */
+    void Finish();
+
+    /**
+     * \brief Get the number of rows written so far
+     * \return The number of rows
+     */
+    uint64_t GetRows() const;
+
+  private:
+    /**
+     * \brief Check whether the table is missing or has the given columns
+     * \param table The name of the table
+     * \param definitions The column definitions, SEED and RUN included
+     * \return true if the table can be written as is
+     */
+    bool HasSchema(const std::string& table, const std::vector<std::string>& definitions);
+
+    /**
+     * \brief Move an outdated table out of the way, see the class description
+     * \param table The name of the table
+     */
+    void RenameOutdated(const std::string& table);
+
+    /**
+     * \brief Run a statement without results, e.g., BEGIN or COMMIT
+     * \param sql The statement
+     */
+    void Exec(const std::string& sql);
+
+    sqlite3* m_db{nullptr};        //!< DB connection, not owned
+    sqlite3_stmt* m_stmt{nullptr}; //!< prepared INSERT statement
+    int m_columns{0};              //!< number of columns, SEED and RUN included
+    int m_next{1};                 //!< index of the next column to bind
+    uint32_t m_seed{0};            //!< seed index of the rows
+    uint64_t m_run{0};             //!< run index of the rows
+    uint32_t m_batchSize{0};       //!< rows per transaction, 0 for no limit
+    uint32_t m_pending{0};         //!< rows in the open transaction
+    uint64_t m_rows{0};            //!< rows written
+};
+
+} // namespace ns3
+
+#endif // KPI_TABLE_WRITER_H
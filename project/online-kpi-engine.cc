@@ -0,0 +1,133 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+
+// SPDX-License-Identifier: GPL-2.0-only
+
+#include "online-kpi-engine.h"
+
+namespace ns3
+{
+
+OnlineKpiEngine::OnlineKpiEngine()
+{
+}
+
+void
+OnlineKpiEngine::NotifyPktTx(uint32_t nodeId, uint64_t imsi, const std::string& ip, uint32_t seq)
+{
+    auto [it, inserted] = m_txNodes.try_emplace(nodeId);
+    TxNode& node = it->second;
+    if (inserted)
+    {
+        node.imsi = imsi;
+        node.ip = ip;
+        m_txNodeByIp.emplace(ip, nodeId);
+    }
+    node.txPkts++;
+    node.seqs.insert(seq);
+}
+
+void
+OnlineKpiEngine::NotifyPktRx(double time,
+                             uint32_t nodeId,
+                             uint64_t imsi,
+                             const std::string& ip,
+                             const std::string& txIp,
+                             uint32_t pktSize,
+                             uint32_t seq)
+{
+    auto [it, inserted] = m_rxNodes.try_emplace(nodeId);
+    RxNode& node = it->second;
+    if (inserted)
+    {
+        node.imsi = imsi;
+        node.ip = ip;
+    }
+    Link& link = node.links[txIp];
+    link.rxPkts++;
+    link.rxBytes += pktSize;
+
+    // Same rule as V2xKpi::ComputeAvrgPir: the first packet only starts
+    // the clock.
+    if (link.pirCount == 0 && link.lastRxTime == 0.0)
+    {
+        link.lastRxTime = time;
+    }
+    else
+    {
+        link.pirSum = link.pirSum + (time - link.lastRxTime);
+        link.lastRxTime = time;
+        link.pirCount++;
+    }
+
+    // A packet counts towards the PRR of its transmitter once per
+    // receiver, and only if the transmitter logged it.
+    if (link.seqs.insert(seq).second)
+    {
+        auto txIt = m_txNodeByIp.find(txIp);
+        if (txIt != m_txNodeByIp.end() && m_txNodes.at(txIt->second).seqs.count(seq) != 0)
+        {
+            link.txPktsRxed++;
+        }
+    }
+}
+
+void
+OnlineKpiEngine::NotifyPsschTx(const PsschAlloc& alloc)
+{
+    m_psschTx.Add(alloc);
+}
+
+void
+OnlineKpiEngine::NotifyPsschRx(bool psschCorrupt, bool sci2Corrupt)
+{
+    m_psschRx++;
+    if (!psschCorrupt)
+    {
+        ++m_psschSuccess;
+    }
+    if (!sci2Corrupt)
+    {
+        ++m_sci2Success;
+    }
+}
+
+const std::map<uint32_t, OnlineKpiEngine::TxNode>&
+OnlineKpiEngine::GetTxNodes() const
+{
+    return m_txNodes;
+}
+
+const std::map<uint32_t, OnlineKpiEngine::RxNode>&
+OnlineKpiEngine::GetRxNodes() const
+{
+    return m_rxNodes;
+}
+
+uint64_t
+OnlineKpiEngine::GetTotalTxPkts(const std::string& ip) const
+{
+    auto it = m_txNodeByIp.find(ip);
+    return it == m_txNodeByIp.end() ? 0 : m_txNodes.at(it->second).txPkts;
+}
+
+void
+OnlineKpiEngine::GetPsschTxStats(uint32_t& total,
+                                 uint32_t& nonOverlapping,
+                                 uint32_t& overlapping) const
+{
+    total = m_psschTx.GetTotal();
+    nonOverlapping = m_psschTx.GetNonOverlapping();
+    overlapping = m_psschTx.GetOverlapping();
+}
+
+void
+OnlineKpiEngine::GetPsschRxStats(uint32_t& total,
+                                 uint32_t& psschSuccess,
+                                 uint32_t& sci2Success) const
+{
+    total = m_psschRx;
+    psschSuccess = m_psschSuccess;
+    sci2Success = m_sci2Success;
+}
+
+} // namespace ns3
@@ -0,0 +1,157 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+
+// SPDX-License-Identifier: GPL-2.0-only
+
+#ifndef ONLINE_KPI_ENGINE_H
+#define ONLINE_KPI_ENGINE_H
+
+#include "pssch-overlap-index.h"
+
+#include <inttypes.h>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace ns3
+{
+
+/**
+ * \brief Accumulates the V2X KPIs while the simulation runs.
+ *
+ * It is fed by the same trace sinks that write the pktTxRx, psschTxUeMac
+ * and psschRxUePhy tables, and keeps per link (RX node, TX IP) and per
+ * node running sums instead of the rows themselves, so that the KPIs are
+ * ready when the simulation ends and V2xKpi::WriteKpis does not have to
+ * scan the trace tables again. The accumulated values are exactly the
+ * ones the post-run computation derives from the tables.
+ *
+ * \see V2xKpi::WriteKpis(const OnlineKpiEngine&)
+ */
+class OnlineKpiEngine
+{
+  public:
+    /**
+     * \brief Packets sent by one TX node
+     */
+    struct TxNode
+    {
+        uint64_t imsi{0};                  //!< IMSI of the node
+        std::string ip;                    //!< IP address of the node
+        uint64_t txPkts{0};                //!< number of transmitted packets
+        std::unordered_set<uint32_t> seqs; //!< sequence numbers of the transmitted packets
+    };
+
+    /**
+     * \brief Packets received by one RX node from one TX IP
+     */
+    struct Link
+    {
+        uint64_t rxPkts{0};                //!< number of received packets
+        uint64_t rxBytes{0};               //!< received bytes
+        double lastRxTime{0.0};            //!< time of the last reception in seconds
+        double pirSum{0.0};                //!< sum of the inter-reception times
+        uint64_t pirCount{0};              //!< number of inter-reception times
+        uint64_t txPktsRxed{0};            //!< distinct packets of the TX received
+        std::unordered_set<uint32_t> seqs; //!< sequence numbers received
+    };
+
+    /**
+     * \brief Packets received by one RX node
+     */
+    struct RxNode
+    {
+        uint64_t imsi{0};                  //!< IMSI of the node
+        std::string ip;                    //!< IP address of the node
+        std::map<std::string, Link> links; //!< links, by IP address of the transmitter
+    };
+
+    /// PSSCH allocation of one transmission
+    using PsschAlloc = PsschOverlapIndex::Alloc;
+
+    /**
+     * \brief OnlineKpiEngine constructor
+     */
+    OnlineKpiEngine();
+
+    /**
+     * \brief Account an application packet transmission
+     * \param nodeId The node id of the transmitter
+     * \param imsi The IMSI of the transmitter
+     * \param ip The IP address of the transmitter
+     * \param seq The packet sequence number
+     */
+    void NotifyPktTx(uint32_t nodeId, uint64_t imsi, const std::string& ip, uint32_t seq);
+    /**
+     * \brief Account an application packet reception
+     * \param time The simulation time in seconds
+     * \param nodeId The node id of the receiver
+     * \param imsi The IMSI of the receiver
+     * \param ip The IP address of the receiver
+     * \param txIp The IP address of the transmitter
+     * \param pktSize The packet size
+     * \param seq The packet sequence number
+     */
+    void NotifyPktRx(double time,
+                     uint32_t nodeId,
+                     uint64_t imsi,
+                     const std::string& ip,
+                     const std::string& txIp,
+                     uint32_t pktSize,
+                     uint32_t seq);
+    /**
+     * \brief Account a PSSCH transmission
+     * \param alloc The PSSCH allocation
+     */
+    void NotifyPsschTx(const PsschAlloc& alloc);
+    /**
+     * \brief Account a PSSCH TB reception
+     * \param psschCorrupt True if the PSSCH TB was corrupted
+     * \param sci2Corrupt True if the SCI 2 was corrupted
+     */
+    void NotifyPsschRx(bool psschCorrupt, bool sci2Corrupt);
+
+    /**
+     * \brief Get the TX nodes
+     * \return The TX nodes, by node id
+     */
+    const std::map<uint32_t, TxNode>& GetTxNodes() const;
+    /**
+     * \brief Get the RX nodes
+     * \return The RX nodes, by node id
+     */
+    const std::map<uint32_t, RxNode>& GetRxNodes() const;
+    /**
+     * \brief Get the packets transmitted from an IP
+     * \param ip The IP address of the transmitter
+     * \return The number of transmitted packets, 0 for an unknown IP
+     */
+    uint64_t GetTotalTxPkts(const std::string& ip) const;
+    /**
+     * \brief Get the PSSCH transmission counts
+     * \param total The total number of transmissions
+     * \param nonOverlapping The number of non-overlapping transmissions
+     * \param overlapping The number of overlapping transmissions
+     */
+    void GetPsschTxStats(uint32_t& total, uint32_t& nonOverlapping, uint32_t& overlapping) const;
+    /**
+     * \brief Get the PSSCH TB reception counts
+     * \param total The total number of received TBs
+     * \param psschSuccess The number of successfully decoded PSSCH
+     * \param sci2Success The number of successfully decoded SCI 2
+     */
+    void GetPsschRxStats(uint32_t& total, uint32_t& psschSuccess, uint32_t& sci2Success) const;
+
+  private:
+    std::map<uint32_t, TxNode> m_txNodes;                   //!< TX nodes, by node id
+    std::unordered_map<std::string, uint32_t> m_txNodeByIp; //!< TX node id, by IP address
+    std::map<uint32_t, RxNode> m_rxNodes;                   //!< RX nodes, by node id
+    PsschOverlapIndex m_psschTx;                            //!< PSSCH transmissions, by slot
+    uint32_t m_psschRx{0};                                  //!< received PSSCH TBs
+    uint32_t m_psschSuccess{0};                             //!< successfully decoded PSSCH
+    uint32_t m_sci2Success{0};                              //!< successfully decoded SCI 2
+};
+
+} // namespace ns3
+
+#endif // ONLINE_KPI_ENGINE_H
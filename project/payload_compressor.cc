@@ -0,0 +1,190 @@
+#include "payload_compressor.h"
+
+#include "cam_generation.h"
+
+#include <chrono>
+#include <cstring>
+#include <utility>
+
+#if __has_include(<zstd.h>) && __has_include(<zdict.h>)
+#define PAYLOAD_COMPRESSOR_ZSTD 1
+#include <zdict.h>
+#include <zstd.h>
+#endif
+
+namespace {
+
+    // First byte of every payload out of the stage.
+    constexpr char STORED = 0x00;
+    constexpr char ZSTD_FRAME = 0x01;
+
+    // Refuse to inflate beyond this, whatever a corrupt frame header says.
+    constexpr unsigned long long MAX_PAYLOAD = 16ull << 20;
+
+    using Clock = std::chrono::steady_clock;
+
+    std::string stored(std::string_view plain) {
+        std::string out;
+        out.reserve(plain.size() + 1);
+        out.push_back(STORED);
+        out.append(plain);
+        return out;
+    }
+
+#ifdef PAYLOAD_COMPRESSOR_ZSTD
+    // Contexts are not thread-safe, dictionaries are; one context of each
+    // kind per thread, reused across payloads and compressors.
+    struct Contexts {
+        ZSTD_CCtx* cctx = ZSTD_createCCtx();
+        ZSTD_DCtx* dctx = ZSTD_createDCtx();
+        ~Contexts() {
+            ZSTD_freeCCtx(cctx);
+            ZSTD_freeDCtx(dctx);
+        }
+    };
+
+    Contexts& contexts() {
+        thread_local Contexts ctx;
+        return ctx;
+    }
+#endif
+
+} // namespace
+
+struct PayloadCompressor::Dictionaries {
+#ifdef PAYLOAD_COMPRESSOR_ZSTD
+    ZSTD_CDict* cdict = nullptr;
+    ZSTD_DDict* ddict = nullptr;
+    ~Dictionaries() {
+        ZSTD_freeCDict(cdict);
+        ZSTD_freeDDict(ddict);
+    }
+#endif
+};
+
+PayloadCompressor::PayloadCompressor(std::string dictionary, int level, double min_gain)
+    : dictionary_(std::move(dictionary)), level_(level), min_gain_(min_gain),
+      dicts_(std::make_unique<Dictionaries>()) {
+#ifdef PAYLOAD_COMPRESSOR_ZSTD
+    if (!dictionary_.empty()) {
+        dicts_->cdict = ZSTD_createCDict(dictionary_.data(), dictionary_.size(), level_);
+        dicts_->ddict = ZSTD_createDDict(dictionary_.data(), dictionary_.size());
+    }
+#endif
+}
+
+PayloadCompressor::~PayloadCompressor() = default;
+
+bool PayloadCompressor::available() {
+#ifdef PAYLOAD_COMPRESSOR_ZSTD
+    return true;
+#else
+    return false;
+#endif
+}
+
+std::string PayloadCompressor::compress(std::string_view plain, CompressionResult* result) const {
+    auto start = Clock::now();
+    std::string out;
+    bool bypassed = true;
+
+#ifdef PAYLOAD_COMPRESSOR_ZSTD
+    out.resize(1 + ZSTD_compressBound(plain.size()));
+    out[0] = ZSTD_FRAME;
+    Contexts& ctx = contexts();
+    size_t n = dicts_->cdict
+                   ? ZSTD_compress_usingCDict(ctx.cctx, out.data() + 1, out.size() - 1,
+                                              plain.data(), plain.size(), dicts_->cdict)
+                   : ZSTD_compressCCtx(ctx.cctx, out.data() + 1, out.size() - 1, plain.data(),
+                                       plain.size(), level_);
+    // Bypass unless the frame saves at least min_gain of the input.
+    bypassed = ZSTD_isError(n) ||
+               static_cast<double>(n + 1) > static_cast<double>(plain.size()) * (1.0 - min_gain_);
+    if (!bypassed) out.resize(n + 1);
+#endif
+    if (bypassed) out = stored(plain);
+
+    if (result) {
+        result->in_bytes = plain.size();
+        result->out_bytes = out.size();
+        result->seconds = std::chrono::duration<double>(Clock::now() - start).count();
+        result->bypassed = bypassed;
+    }
+    return out;
+}
+
+std::optional<std::string> PayloadCompressor::decompress(std::string_view payload,
+                                                         double* seconds) const {
+    auto start = Clock::now();
+    if (payload.empty()) return std::nullopt;
+
+    std::optional<std::string> out;
+    const char kind = payload.front();
+    payload.remove_prefix(1);
+    if (kind == STORED) {
+        out.emplace(payload);
+    }
+#ifdef PAYLOAD_COMPRESSOR_ZSTD
+    else if (kind == ZSTD_FRAME) {
+        unsigned long long size = ZSTD_getFrameContentSize(payload.data(), payload.size());
+        if (size == ZSTD_CONTENTSIZE_ERROR || size == ZSTD_CONTENTSIZE_UNKNOWN ||
+            size > MAX_PAYLOAD) {
+            return std::nullopt;
+        }
+        std::string plain(static_cast<std::size_t>(size), '\0');
+        Contexts& ctx = contexts();
+        size_t n = dicts_->ddict
+                       ? ZSTD_decompress_usingDDict(ctx.dctx, plain.data(), plain.size(),
+                                                    payload.data(), payload.size(), dicts_->ddict)
+                       : ZSTD_decompressDCtx(ctx.dctx, plain.data(), plain.size(), payload.data(),
+                                             payload.size());
+        if (ZSTD_isError(n) || n != plain.size()) return std::nullopt;
+        out = std::move(plain);
+    }
+#endif
+
+    if (seconds) *seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    return out;
+}
+
+std::string train_dictionary(const std::vector<std::string>& samples, std::size_t dict_bytes) {
+#ifdef PAYLOAD_COMPRESSOR_ZSTD
+    std::string joined;
+    std::vector<size_t> sizes;
+    for (const auto& s : samples) {
+        joined += s;
+        sizes.push_back(s.size());
+    }
+    std::string dict(dict_bytes, '\0');
+    size_t n = ZDICT_trainFromBuffer(dict.data(), dict.size(), joined.data(), sizes.data(),
+                                     static_cast<unsigned>(sizes.size()));
+    if (ZDICT_isError(n)) return {};
+    dict.resize(n);
+    return dict;
+#else
+    (void)samples;
+    (void)dict_bytes;
+    return {};
+#endif
+}
+
+std::string train_cam_dictionary(bool binary_cams, std::size_t dict_bytes) {
+    // A seed of its own, so the samples are not the CAMs later sent.
+    constexpr uint64_t SEED = 0xD1C7;
+    constexpr uint32_t BUNDLES = 1000;
+
+    std::vector<std::string> samples;
+    std::vector<Cam> bundle;
+    for (uint32_t r = 0; r < BUNDLES; ++r) {
+        bundle.clear();
+        for (uint32_t s = 0; s <= r % 10; ++s) bundle.push_back(deterministic_cam(SEED, s, r));
+        if (binary_cams) {
+            samples.push_back(encode_cams(bundle));
+        } else {
+            std::string text;
+            for (const Cam& cam : bundle) text += format_cam(cam);
+            samples.push_back(std::move(text));
+        }
+    }
+    return train_dictionary(samples, dict_bytes);
+}
@@ -0,0 +1,73 @@
+#ifndef PAYLOAD_COMPRESSOR_H
+#define PAYLOAD_COMPRESSOR_H
+
+#include <cstddef>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Optional compression stage in front of the crypto engines: the payload is
+// compressed with zstd, using a dictionary trained on CAM bundles, and then
+// encrypted; receivers decrypt and then decompress. Short bundles compress
+// poorly on their own, and the dictionary is what makes single packets
+// worth compressing.
+//
+// Every compressed payload starts with one byte telling how it is stored,
+// so the stage can fall back to sending the bytes as they are (bypass)
+// whenever compression does not save at least min_gain of the input.
+//
+// zstd is used when its headers are found at build time (link with -lzstd);
+// otherwise available() is false and every payload is bypassed.
+
+struct CompressionResult {
+    std::size_t in_bytes = 0;  // payload handed to the stage
+    std::size_t out_bytes = 0; // payload handed to the engine, marker byte included
+    double seconds = 0.0;      // wall-clock compression time
+    bool bypassed = true;      // stored as is
+
+    double ratio() const { return out_bytes ? static_cast<double>(in_bytes) / out_bytes : 0.0; }
+};
+
+class PayloadCompressor {
+  public:
+    // dictionary: as returned by train_dictionary, or empty for none.
+    explicit PayloadCompressor(std::string dictionary = {}, int level = 3, double min_gain = 0.1);
+    ~PayloadCompressor();
+
+    PayloadCompressor(const PayloadCompressor&) = delete;
+    PayloadCompressor& operator=(const PayloadCompressor&) = delete;
+
+    // True if the build has zstd.
+    static bool available();
+
+    std::size_t dictionary_size() const { return dictionary_.size(); }
+
+    // Compresses (or bypasses) one payload. Thread-safe: each thread uses
+    // its own zstd context.
+    std::string compress(std::string_view plain, CompressionResult* result = nullptr) const;
+
+    // Recovers the payload; std::nullopt if it is malformed. seconds, if
+    // given, receives the wall-clock decompression time.
+    std::optional<std::string> decompress(std::string_view payload, double* seconds = nullptr) const;
+
+  private:
+    struct Dictionaries;
+
+    std::string dictionary_;
+    int level_;
+    double min_gain_;
+    std::unique_ptr<Dictionaries> dicts_;
+};
+
+// Trains a zstd dictionary of up to dict_bytes on the samples. Returns an
+// empty string if zstd is unavailable or the samples are too few.
+std::string train_dictionary(const std::vector<std::string>& samples, std::size_t dict_bytes);
+
+// Dictionary trained on bundles of 1 to 10 deterministic CAMs (see
+// deterministic_cam), text or binary. Sender and receivers build the same
+// one, so it does not need to be distributed.
+std::string train_cam_dictionary(bool binary_cams, std::size_t dict_bytes = 4096);
+
+#endif // PAYLOAD_COMPRESSOR_H
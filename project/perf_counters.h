@@ -0,0 +1,43 @@
+#ifndef PERF_COUNTERS_H
+#define PERF_COUNTERS_H
+
+#include <array>
+#include <cstdint>
+
+// User-space hardware counters of one measured region.
+struct PerfCounts {
+    uint64_t cycles = 0;
+    uint64_t instructions = 0;
+    uint64_t cache_misses = 0;
+    uint64_t branch_misses = 0;
+    // False when the counters could not be opened (not Linux, missing PMU,
+    // perf_event_paranoid too strict, seccomp in containers, ...).
+    bool valid = false;
+};
+
+// A group of cycles, instructions, cache-miss and branch-miss counters of
+// the calling thread, opened with perf_event_open and scheduled together so
+// the ratios between them are meaningful. Counters that the PMU does not
+// offer stay at zero; if cycles cannot be opened the whole group is invalid.
+//
+// Not thread-safe: each thread needs its own group.
+class PerfCounterGroup {
+  public:
+    PerfCounterGroup();
+    ~PerfCounterGroup();
+
+    PerfCounterGroup(const PerfCounterGroup&) = delete;
+    PerfCounterGroup& operator=(const PerfCounterGroup&) = delete;
+
+    bool available() const { return fds_[0] >= 0; }
+
+    // Resets and enables the counters.
+    void start();
+    // Disables the counters and reads them.
+    PerfCounts stop();
+
+  private:
+    std::array<int, 4> fds_{-1, -1, -1, -1};
+};
+
+#endif // PERF_COUNTERS_H
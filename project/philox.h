@@ -0,0 +1,35 @@
+#ifndef PHILOX_H
+#define PHILOX_H
+
+#include <array>
+#include <cstdint>
+
+// Philox4x32-10 counter-based RNG (Salmon et al., "Parallel random numbers:
+// as easy as 1, 2, 3", SC'11). Each (key, counter) pair maps to four
+// independent 32-bit words, so any draw can be computed on its own without
+// a shared sequential state.
+struct Philox4x32 {
+    using Counter = std::array<uint32_t, 4>;
+    using Key = std::array<uint32_t, 2>;
+
+    static constexpr Counter generate(Counter ctr, Key key) {
+        for (int round = 0; round < 10; ++round) {
+            if (round > 0) {
+                key[0] += 0x9E3779B9u;
+                key[1] += 0xBB67AE85u;
+            }
+            const uint64_t p0 = uint64_t{0xD2511F53u} * ctr[0];
+            const uint64_t p1 = uint64_t{0xCD9E8D57u} * ctr[2];
+            ctr = {static_cast<uint32_t>(p1 >> 32) ^ ctr[1] ^ key[0], static_cast<uint32_t>(p1),
+                   static_cast<uint32_t>(p0 >> 32) ^ ctr[3] ^ key[1], static_cast<uint32_t>(p0)};
+        }
+        return ctr;
+    }
+};
+
+// Uniform double in [0, 1) from 53 bits of two words.
+constexpr double philox_unit(uint32_t hi, uint32_t lo) {
+    return static_cast<double>((uint64_t{hi} << 21) ^ (lo >> 11)) * 0x1.0p-53;
+}
+
+#endif // PHILOX_H
@@ -0,0 +1,251 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+
+// SPDX-License-Identifier: GPL-2.0-only
+
+#include "pkt-trace-store.h"
+
+#include <algorithm>
+#include <numeric>
+
+namespace ns3
+{
+
+namespace
+{
+
+/**
+ * \brief Reorder a column
+ * \param column The column
+ * \param order The index of the old row of each new row
+ */
+template <typename T>
+void
+Permute(std::vector<T>& column, const std::vector<std::size_t>& order)
+{
+    std::vector<T> permuted;
+    permuted.reserve(order.size());
+    for (std::size_t i : order)
+    {
+        permuted.push_back(column[i]);
+    }
+    column.swap(permuted);
+}
+
+/**
+ * \brief Release the memory of a column
+ * \param column The column
+ */
+template <typename T>
+void
+Release(std::vector<T>& column)
+{
+    std::vector<T>().swap(column);
+}
+
+} // namespace
+
+PktTraceStore::PktTraceStore()
+{
+}
+
+uint32_t
+PktTraceStore::InternIp(std::string_view ip)
+{
+    std::lock_guard<std::mutex> lock(m_ipMutex);
+    auto [it, inserted] = m_ipIds.try_emplace(std::string(ip), m_ips.size());
+    if (inserted)
+    {
+        m_ips.push_back(it->first);
+    }
+    return it->second;
+}
+
+const std::string&
+PktTraceStore::GetIp(uint32_t id) const
+{
+    return m_ips.at(id);
+}
+
+uint32_t
+PktTraceStore::GetNumIps() const
+{
+    return m_ips.size();
+}
+
+void
+PktTraceStore::AddRx(double time,
+                     uint32_t nodeId,
+                     uint64_t imsi,
+                     uint32_t pktSize,
+                     uint32_t rxIp,
+                     uint32_t txIp,
+                     uint32_t seq)
+{
+    m_rxTime.push_back(time);
+    m_rxSize.push_back(pktSize);
+    m_rxSeq.push_back(seq);
+    m_rxNodeId.push_back(nodeId);
+    m_rxImsi.push_back(imsi);
+    m_rxIp.push_back(rxIp);
+    m_rxTxIp.push_back(txIp);
+}
+
+void
+PktTraceStore::AddTx(double time, uint32_t nodeId, uint64_t imsi, uint32_t ip, uint32_t seq)
+{
+    m_txTime.push_back(time);
+    m_txSeq.push_back(seq);
+    m_txNodeId.push_back(nodeId);
+    m_txImsi.push_back(imsi);
+    m_txIp.push_back(ip);
+}
+
+bool
+PktTraceStore::IpLess(uint32_t a, uint32_t b) const
+{
+    return m_ips[a] < m_ips[b];
+}
+
+void
+PktTraceStore::Index()
+{
+    // Rank the IPs as strings once, so that the rows are sorted by
+    // integer keys.
+    std::vector<uint32_t> byIp(m_ips.size());
+    std::iota(byIp.begin(), byIp.end(), 0);
+    std::sort(byIp.begin(), byIp.end(), [this](uint32_t a, uint32_t b) { return IpLess(a, b); });
+    std::vector<uint32_t> ipRank(m_ips.size());
+    for (uint32_t rank = 0; rank < byIp.size(); ++rank)
+    {
+        ipRank[byIp[rank]] = rank;
+    }
+
+    // RX rows, by (node id, TX IP), in table order within a link
+    std::vector<std::size_t> order(m_rxSeq.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&](std::size_t a, std::size_t b) {
+        if (m_rxNodeId[a] != m_rxNodeId[b])
+        {
+            return m_rxNodeId[a] < m_rxNodeId[b];
+        }
+        return ipRank[m_rxTxIp[a]] < ipRank[m_rxTxIp[b]];
+    });
+    m_rxNodes.clear();
+    m_links.clear();
+    for (std::size_t i = 0; i < order.size(); ++i)
+    {
+        std::size_t row = order[i];
+        if (m_links.empty() || m_links.back().rxNodeId != m_rxNodeId[row] ||
+            m_links.back().txIp != m_rxTxIp[row])
+        {
+            if (m_rxNodes.empty() || m_rxNodes.back().nodeId != m_rxNodeId[row])
+            {
+                m_rxNodes.push_back({m_rxNodeId[row], m_links.size(), m_links.size()});
+            }
+            m_links.push_back({m_rxNodeId[row], m_rxImsi[row], m_rxIp[row], m_rxTxIp[row], i, i});
+            m_rxNodes.back().lastLink++;
+        }
+        m_links.back().last++;
+    }
+    Permute(m_rxTime, order);
+    Permute(m_rxSize, order);
+    Permute(m_rxSeq, order);
+    Release(m_rxNodeId);
+    Release(m_rxImsi);
+    Release(m_rxIp);
+    Release(m_rxTxIp);
+
+    // TX rows, by node id, in table order within a node
+    order.resize(m_txSeq.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [this](std::size_t a, std::size_t b) {
+        return m_txNodeId[a] < m_txNodeId[b];
+    });
+    m_txNodes.clear();
+    for (std::size_t i = 0; i < order.size(); ++i)
+    {
+        std::size_t row = order[i];
+        if (m_txNodes.empty() || m_txNodes.back().nodeId != m_txNodeId[row])
+        {
+            m_txNodes.push_back({m_txNodeId[row], m_txImsi[row], m_txIp[row], i, i});
+        }
+        m_txNodes.back().last++;
+    }
+    Permute(m_txTime, order);
+    Permute(m_txSeq, order);
+    Release(m_txNodeId);
+    Release(m_txImsi);
+    Release(m_txIp);
+}
+
+const std::vector<PktTraceStore::RxNode>&
+PktTraceStore::GetRxNodes() const
+{
+    return m_rxNodes;
+}
+
+const std::vector<PktTraceStore::Link>&
+PktTraceStore::GetLinks() const
+{
+    return m_links;
+}
+
+const std::vector<PktTraceStore::TxNode>&
+PktTraceStore::GetTxNodes() const
+{
+    return m_txNodes;
+}
+
+const PktTraceStore::Link*
+PktTraceStore::FindLink(const RxNode& rxNode, uint32_t txIp) const
+{
+    // the links of a node are sorted by TX IP string
+    auto first = m_links.begin() + rxNode.firstLink;
+    auto last = m_links.begin() + rxNode.lastLink;
+    auto it = std::lower_bound(first, last, txIp, [this](const Link& link, uint32_t ip) {
+        return IpLess(link.txIp, ip);
+    });
+    return (it != last && it->txIp == txIp) ? &*it : nullptr;
+}
+
+const PktTraceStore::TxNode*
+PktTraceStore::FindTxNode(uint32_t nodeId) const
+{
+    auto it = std::lower_bound(m_txNodes.begin(),
+                               m_txNodes.end(),
+                               nodeId,
+                               [](const TxNode& node, uint32_t id) { return node.nodeId < id; });
+    return (it != m_txNodes.end() && it->nodeId == nodeId) ? &*it : nullptr;
+}
+
+std::span<const double>
+PktTraceStore::GetRxTimes(const Link& link) const
+{
+    return std::span<const double>(m_rxTime).subspan(link.first, link.last - link.first);
+}
+
+std::span<const uint32_t>
+PktTraceStore::GetRxSizes(const Link& link) const
+{
+    return std::span<const uint32_t>(m_rxSize).subspan(link.first, link.last - link.first);
+}
+
+std::span<const uint32_t>
+PktTraceStore::GetRxSeqs(const Link& link) const
+{
+    return std::span<const uint32_t>(m_rxSeq).subspan(link.first, link.last - link.first);
+}
+
+std::span<const double>
+PktTraceStore::GetTxTimes(const TxNode& txNode) const
+{
+    return std::span<const double>(m_txTime).subspan(txNode.first, txNode.last - txNode.first);
+}
+
+std::span<const uint32_t>
+PktTraceStore::GetTxSeqs(const TxNode& txNode) const
+{
+    return std::span<const uint32_t>(m_txSeq).subspan(txNode.first, txNode.last - txNode.first);
+}
+
+} // namespace ns3
@@ -0,0 +1,232 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+
+// SPDX-License-Identifier: GPL-2.0-only
+
+#ifndef PKT_TRACE_STORE_H
+#define PKT_TRACE_STORE_H
+
+#include <deque>
+#include <inttypes.h>
+#include <mutex>
+#include <span>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace ns3
+{
+
+/**
+ * \brief In-memory copy of the pktTxRx table used by V2xKpi.
+ *
+ * The rows are kept column by column, and the IP addresses are interned
+ * to dense ids, so a row costs a few fixed size fields instead of a
+ * struct with two strings. Once all the rows are added, Index() groups
+ * them:
+ *
+ * - RX rows by link, i.e., (RX node id, TX IP), ordered by node id and
+ *   then by TX IP string, the order in which the KPI rows are written;
+ * - TX rows by TX node id.
+ *
+ * Within a group the rows keep the order of the table, and the columns a
+ * KPI needs are exposed as spans over the rows of a link or TX node.
+ *
+ * AddRx and AddTx fill separate columns and InternIp is locked, so the
+ * RX and TX rows may be added from two threads.
+ */
+class PktTraceStore
+{
+  public:
+    /**
+     * \brief Packets received by one RX node from one TX IP
+     */
+    struct Link
+    {
+        uint32_t rxNodeId; //!< node id of the receiver
+        uint64_t rxImsi;   //!< IMSI of the receiver, from the first packet
+        uint32_t rxIp;     //!< IP id of the receiver, from the first packet
+        uint32_t txIp;     //!< IP id of the transmitter
+        std::size_t first; //!< index of the first row of the link
+        std::size_t last;  //!< one past the index of the last row
+    };
+
+    /**
+     * \brief Links of one RX node
+     */
+    struct RxNode
+    {
+        uint32_t nodeId;       //!< node id
+        std::size_t firstLink; //!< index of the first link of the node
+        std::size_t lastLink;  //!< one past the index of the last link
+    };
+
+    /**
+     * \brief Packets transmitted by one TX node
+     */
+    struct TxNode
+    {
+        uint32_t nodeId;   //!< node id
+        uint64_t imsi;     //!< IMSI, from the first packet
+        uint32_t ip;       //!< IP id, from the first packet
+        std::size_t first; //!< index of the first row of the node
+        std::size_t last;  //!< one past the index of the last row
+    };
+
+    /**
+     * \brief PktTraceStore constructor
+     */
+    PktTraceStore();
+
+    PktTraceStore(const PktTraceStore&) = delete;
+    PktTraceStore& operator=(const PktTraceStore&) = delete;
+
+    /**
+     * \brief Get the id of an IP address, adding it if new
+     * \param ip The IP address
+     * \return The IP id
+     */
+    uint32_t InternIp(std::string_view ip);
+    /**
+     * \brief Get an IP address
+     *
+     * Not to be called while IPs are interned from another thread.
+     *
+     * \param id The IP id
+     * \return The IP address, valid as long as the store
+     */
+    const std::string& GetIp(uint32_t id) const;
+    /**
+     * \brief Get the number of interned IP addresses
+     * \return The number of IPs, i.e., one past the largest IP id
+     */
+    uint32_t GetNumIps() const;
+
+    /**
+     * \brief Add a row of an RX node
+     * \param time The reception time in seconds
+     * \param nodeId The node id of the receiver
+     * \param imsi The IMSI of the receiver
+     * \param pktSize The packet size
+     * \param rxIp The IP id of the receiver
+     * \param txIp The IP id of the transmitter
+     * \param seq The packet sequence number
+     */
+    void AddRx(double time,
+               uint32_t nodeId,
+               uint64_t imsi,
+               uint32_t pktSize,
+               uint32_t rxIp,
+               uint32_t txIp,
+               uint32_t seq);
+    /**
+     * \brief Add a row of a TX node
+     * \param time The transmission time in seconds
+     * \param nodeId The node id of the transmitter
+     * \param imsi The IMSI of the transmitter
+     * \param ip The IP id of the transmitter
+     * \param seq The packet sequence number
+     */
+    void AddTx(double time, uint32_t nodeId, uint64_t imsi, uint32_t ip, uint32_t seq);
+    /**
+     * \brief Group the rows added so far by link and by TX node
+     *
+     * The per row node ids, IMSIs and IPs are folded into the links and
+     * the TX nodes and released.
+     */
+    void Index();
+
+    /**
+     * \brief Get the RX nodes, by node id
+     * \return The RX nodes
+     */
+    const std::vector<RxNode>& GetRxNodes() const;
+    /**
+     * \brief Get the links, by RX node id and TX IP
+     * \return The links
+     */
+    const std::vector<Link>& GetLinks() const;
+    /**
+     * \brief Get the TX nodes, by node id
+     * \return The TX nodes
+     */
+    const std::vector<TxNode>& GetTxNodes() const;
+    /**
+     * \brief Find the link of an RX node from a TX IP
+     * \param rxNode The RX node
+     * \param txIp The IP id of the transmitter
+     * \return The link, nullptr if the node received nothing from txIp
+     */
+    const Link* FindLink(const RxNode& rxNode, uint32_t txIp) const;
+    /**
+     * \brief Find a TX node
+     * \param nodeId The node id
+     * \return The TX node, nullptr if the node transmitted nothing
+     */
+    const TxNode* FindTxNode(uint32_t nodeId) const;
+
+    /**
+     * \brief Get the reception times of the packets of a link
+     * \param link The link
+     * \return The times in seconds, in table order
+     */
+    std::span<const double> GetRxTimes(const Link& link) const;
+    /**
+     * \brief Get the sizes of the packets of a link
+     * \param link The link
+     * \return The packet sizes, in table order
+     */
+    std::span<const uint32_t> GetRxSizes(const Link& link) const;
+    /**
+     * \brief Get the sequence numbers of the packets of a link
+     * \param link The link
+     * \return The sequence numbers, in table order
+     */
+    std::span<const uint32_t> GetRxSeqs(const Link& link) const;
+    /**
+     * \brief Get the transmission times of the packets of a TX node
+     * \param txNode The TX node
+     * \return The times in seconds, in table order
+     */
+    std::span<const double> GetTxTimes(const TxNode& txNode) const;
+    /**
+     * \brief Get the sequence numbers of the packets of a TX node
+     * \param txNode The TX node
+     * \return The sequence numbers, in table order
+     */
+    std::span<const uint32_t> GetTxSeqs(const TxNode& txNode) const;
+
+  private:
+    /**
+     * \brief Compare two IP addresses as strings
+     * \param a An IP id
+     * \param b Another IP id
+     * \return true if the IP of a sorts before the one of b
+     */
+    bool IpLess(uint32_t a, uint32_t b) const;
+
+    std::deque<std::string> m_ips;                     //!< IP addresses, by id
+    std::unordered_map<std::string, uint32_t> m_ipIds; //!< IP ids, by address
+    std::mutex m_ipMutex;                              //!< guards m_ips and m_ipIds
+
+    std::vector<double> m_rxTime;     //!< reception time of the RX rows
+    std::vector<uint32_t> m_rxSize;   //!< packet size of the RX rows
+    std::vector<uint32_t> m_rxSeq;    //!< sequence number of the RX rows
+    std::vector<uint32_t> m_rxNodeId; //!< node id of the RX rows, until Index()
+    std::vector<uint64_t> m_rxImsi;   //!< IMSI of the RX rows, until Index()
+    std::vector<uint32_t> m_rxIp;     //!< IP id of the RX rows, until Index()
+    std::vector<uint32_t> m_rxTxIp;   //!< TX IP id of the RX rows, until Index()
+    std::vector<double> m_txTime;     //!< transmission time of the TX rows
+    std::vector<uint32_t> m_txSeq;    //!< sequence number of the TX rows
+    std::vector<uint32_t> m_txNodeId; //!< node id of the TX rows, until Index()
+    std::vector<uint64_t> m_txImsi;   //!< IMSI of the TX rows, until Index()
+    std::vector<uint32_t> m_txIp;     //!< IP id of the TX rows, until Index()
+
+    std::vector<RxNode> m_rxNodes; //!< RX nodes, by node id
+    std::vector<Link> m_links;     //!< links, by RX node id and TX IP
+    std::vector<TxNode> m_txNodes; //!< TX nodes, by node id
+};
+
+} // namespace ns3
+
+#endif // PKT_TRACE_STORE_H
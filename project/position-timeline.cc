@@ -0,0 +1,167 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+
+// SPDX-License-Identifier: GPL-2.0-only
+
+#include "position-timeline.h"
+
+#include <ns3/abort.h>
+
+#include <algorithm>
+#include <cmath>
+
+namespace ns3
+{
+
+PositionTimeline::PositionTimeline()
+{
+}
+
+void
+PositionTimeline::Add(double time, uint32_t node, const Vector& pos)
+{
+    NS_ABORT_MSG_IF(!m_snapshots.empty() && time < m_snapshots.back().time,
+                    "Position sample at " << time << " s added after one at "
+                                          << m_snapshots.back().time << " s");
+    if (m_snapshots.empty() || time > m_snapshots.back().time)
+    {
+        // the nodes not sampled at this time keep their last position
+        Snapshot snapshot;
+        if (!m_snapshots.empty())
+        {
+            snapshot.positions = m_snapshots.back().positions;
+            snapshot.located = m_snapshots.back().located;
+        }
+        snapshot.time = time;
+        m_snapshots.push_back(std::move(snapshot));
+    }
+    Snapshot& snapshot = m_snapshots.back();
+    if (node >= snapshot.positions.size())
+    {
+        snapshot.positions.resize(node + 1);
+        snapshot.located.resize(node + 1, false);
+    }
+    snapshot.positions[node] = pos;
+    snapshot.located[node] = true;
+}
+
+bool
+PositionTimeline::IsEmpty() const
+{
+    return m_snapshots.empty();
+}
+
+int64_t
+PositionTimeline::GetCell(double coord) const
+{
+    return static_cast<int64_t>(std::floor(coord / m_cellSize));
+}
+
+uint64_t
+PositionTimeline::CellKey(int64_t x, int64_t y)
+{
+    return (static_cast<uint64_t>(static_cast<uint32_t>(x)) << 32) | static_cast<uint32_t>(y);
+}
+
+void
+PositionTimeline::Index(uint32_t numNodes, double cellSize)
+{
+    NS_ABORT_MSG_IF(cellSize <= 0.0, "The grid cells must have a positive size");
+    m_cellSize = cellSize;
+    std::vector<std::pair<uint64_t, uint32_t>> keys;
+    for (Snapshot& snapshot : m_snapshots)
+    {
+        NS_ABORT_MSG_IF(snapshot.positions.size() > numNodes,
+                        "Position sample of node " << snapshot.positions.size() - 1
+                                                   << " out of " << numNodes << " nodes");
+        snapshot.positions.resize(numNodes);
+        snapshot.located.resize(numNodes, false);
+
+        keys.clear();
+        for (uint32_t node = 0; node < numNodes; ++node)
+        {
+            if (snapshot.located[node])
+            {
+                const Vector& pos = snapshot.positions[node];
+                keys.emplace_back(CellKey(GetCell(pos.x), GetCell(pos.y)), node);
+            }
+        }
+        std::sort(keys.begin(), keys.end());
+
+        snapshot.nodes.clear();
+        snapshot.cells.clear();
+        auto cell = snapshot.cells.end();
+        for (uint32_t i = 0; i < keys.size(); ++i)
+        {
+            if (i == 0 || keys[i].first != keys[i - 1].first)
+            {
+                cell = snapshot.cells.emplace(keys[i].first, std::make_pair(i, i)).first;
+            }
+            cell->second.second++;
+            snapshot.nodes.push_back(keys[i].second);
+        }
+    }
+}
+
+uint32_t
+PositionTimeline::FindSnapshot(double time) const
+{
+    NS_ABORT_MSG_IF(m_snapshots.empty(), "No position sample");
+    auto it = std::upper_bound(m_snapshots.begin(),
+                               m_snapshots.end(),
+                               time,
+                               [](double t, const Snapshot& snapshot) { return t < snapshot.time; });
+    return it == m_snapshots.begin() ? 0 : (it - m_snapshots.begin()) - 1;
+}
+
+bool
+PositionTimeline::HasPosition(uint32_t snapshot, uint32_t node) const
+{
+    const Snapshot& s = m_snapshots[snapshot];
+    return node < s.located.size() && s.located[node];
+}
+
+const Vector&
+PositionTimeline::GetPosition(uint32_t snapshot, uint32_t node) const
+{
+    NS_ABORT_MSG_IF(!HasPosition(snapshot, node),
+                    "No position of node " << node << " at " << m_snapshots[snapshot].time
+                                           << " s");
+    return m_snapshots[snapshot].positions[node];
+}
+
+void
+PositionTimeline::GetNeighbours(uint32_t snapshot,
+                                const Vector& pos,
+                                double range,
+                                std::vector<uint32_t>& nodes) const
+{
+    NS_ABORT_MSG_IF(m_cellSize == 0.0, "The positions are not indexed");
+    NS_ABORT_MSG_IF(range > m_cellSize,
+                    "Range " << range << " m larger than the grid cells of " << m_cellSize
+                             << " m");
+    const Snapshot& s = m_snapshots[snapshot];
+    nodes.clear();
+    int64_t x = GetCell(pos.x);
+    int64_t y = GetCell(pos.y);
+    for (int64_t dx = -1; dx <= 1; ++dx)
+    {
+        for (int64_t dy = -1; dy <= 1; ++dy)
+        {
+            auto cell = s.cells.find(CellKey(x + dx, y + dy));
+            if (cell == s.cells.end())
+            {
+                continue;
+            }
+            for (uint32_t i = cell->second.first; i < cell->second.second; ++i)
+            {
+                uint32_t node = s.nodes[i];
+                if (CalculateDistance(s.positions[node], pos) <= range)
+                {
+                    nodes.push_back(node);
+                }
+            }
+        }
+    }
+}
+
+} // namespace ns3
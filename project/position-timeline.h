@@ -0,0 +1,135 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+
+// SPDX-License-Identifier: GPL-2.0-only
+
+#ifndef POSITION_TIMELINE_H
+#define POSITION_TIMELINE_H
+
+#include <ns3/vector.h>
+
+#include <inttypes.h>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace ns3
+{
+
+/**
+ * \brief Positions of the nodes sampled over the simulation, with a spatial
+ *        index per sample time.
+ *
+ * The samples are grouped in snapshots, one per sample time. A node keeps
+ * its last sampled position in the following snapshots until it is sampled
+ * again, so a snapshot holds the position of every node sampled so far. The
+ * position of a node at a time t is the one of the last snapshot at or
+ * before t, or of the first snapshot if t is before it.
+ *
+ * Once all the samples are added, Index() hashes the nodes of each
+ * snapshot into a uniform grid of square cells on the XY plane. With cells
+ * at least as large as the range, the nodes within range of a position are
+ * in its cell or in the eight around it, so a range query only visits its
+ * neighbours instead of all the nodes.
+ *
+ * The nodes are identified by dense indices, e.g., of a KpiNodeRegistry.
+ */
+class PositionTimeline
+{
+  public:
+    /**
+     * \brief PositionTimeline constructor
+     */
+    PositionTimeline();
+
+    /**
+     * \brief Add a position sample
+     * \param time The sample time in seconds, not before the previous sample
+     * \param node The index of the node
+     * \param pos The position of the node
+     */
+    void Add(double time, uint32_t node, const Vector& pos);
+    /**
+     * \brief Check if no sample was added
+     * \return true if there is no sample
+     */
+    bool IsEmpty() const;
+    /**
+     * \brief Build the spatial index of every snapshot
+     * \param numNodes The number of nodes, at least one past the largest
+     *        index sampled
+     * \param cellSize The side of the grid cells in meters, which bounds
+     *        the range of the queries
+     */
+    void Index(uint32_t numNodes, double cellSize);
+
+    /**
+     * \brief Find the snapshot holding the positions at a time
+     * \param time The time in seconds
+     * \return The index of the snapshot
+     */
+    uint32_t FindSnapshot(double time) const;
+    /**
+     * \brief Check if a node was sampled at or before a snapshot
+     * \param snapshot The index of the snapshot
+     * \param node The index of the node
+     * \return true if the snapshot holds a position of the node
+     */
+    bool HasPosition(uint32_t snapshot, uint32_t node) const;
+    /**
+     * \brief Get the position of a node in a snapshot
+     * \param snapshot The index of the snapshot
+     * \param node The index of the node, which must have a position
+     * \return The position
+     */
+    const Vector& GetPosition(uint32_t snapshot, uint32_t node) const;
+    /**
+     * \brief Get the nodes within range of a position in a snapshot
+     *
+     * Requires Index().
+     *
+     * \param snapshot The index of the snapshot
+     * \param pos The position
+     * \param range The range in meters, not larger than the cell size
+     * \param nodes The indices of the nodes at most range away from pos,
+     *        in no particular order
+     */
+    void GetNeighbours(uint32_t snapshot,
+                       const Vector& pos,
+                       double range,
+                       std::vector<uint32_t>& nodes) const;
+
+  private:
+    /**
+     * \brief Positions of the nodes at one sample time
+     */
+    struct Snapshot
+    {
+        double time;                   //!< sample time in seconds
+        std::vector<Vector> positions; //!< position, by node
+        std::vector<bool> located;     //!< true if the node has a position
+        std::vector<uint32_t> nodes;   //!< located nodes, grouped by cell
+        std::unordered_map<uint64_t, std::pair<uint32_t, uint32_t>>
+            cells; //!< range of each non-empty cell in nodes, by cell key
+    };
+
+    /**
+     * \brief Get the grid coordinate of a position coordinate
+     * \param coord The X or Y coordinate in meters
+     * \return The index of the cell along that axis
+     */
+    int64_t GetCell(double coord) const;
+    /**
+     * \brief Get the key of a grid cell
+     * \param x The index of the cell along X
+     * \param y The index of the cell along Y
+     * \return The key
+     */
+    static uint64_t CellKey(int64_t x, int64_t y);
+
+    std::vector<Snapshot> m_snapshots; //!< snapshots, by sample time
+    double m_cellSize{0.0};            //!< side of the grid cells, 0 until Index()
+};
+
+} // namespace ns3
+
+#endif // POSITION_TIMELINE_H
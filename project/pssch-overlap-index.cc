@@ -0,0 +1,172 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+
+// SPDX-License-Identifier: GPL-2.0-only
+
+#include "pssch-overlap-index.h"
+
+#include <algorithm>
+
+namespace ns3
+{
+
+namespace
+{
+
+/**
+ * \brief Mask of the bits of a row word covered by an RB range
+ * \param word The index of the word in the row
+ * \param rbStart The first RB
+ * \param rbEnd One past the last RB
+ * \return The mask, 0 if the word is outside of the range
+ */
+uint64_t
+RbMask(uint32_t word, uint32_t rbStart, uint32_t rbEnd)
+{
+    uint32_t lo = std::max(rbStart, word * 64);
+    uint32_t hi = std::min(rbEnd, word * 64 + 64);
+    if (lo >= hi)
+    {
+        return 0;
+    }
+    uint32_t n = hi - lo;
+    uint64_t mask = (n == 64) ? ~uint64_t{0} : ((uint64_t{1} << n) - 1);
+    return mask << (lo - word * 64);
+}
+
+} // namespace
+
+PsschOverlapIndex::PsschOverlapIndex()
+{
+}
+
+void
+PsschOverlapIndex::Slot::Fit(const Alloc& alloc)
+{
+    uint16_t newSymbols = std::max<uint16_t>(symbols, alloc.symStart + alloc.symLen);
+    uint16_t newWords = std::max<uint16_t>(words, (alloc.rbStart + alloc.rbLen + 63) / 64);
+    if (newSymbols == symbols && newWords == words)
+    {
+        return;
+    }
+    auto relayout = [&](std::vector<uint64_t>& bits) {
+        std::vector<uint64_t> grown(static_cast<std::size_t>(newSymbols) * newWords, 0);
+        for (uint16_t sym = 0; sym < symbols; ++sym)
+        {
+            std::copy_n(bits.begin() + sym * words, words, grown.begin() + sym * newWords);
+        }
+        bits.swap(grown);
+    };
+    relayout(nonOverlapped);
+    relayout(overlapped);
+    symbols = newSymbols;
+    words = newWords;
+}
+
+bool
+PsschOverlapIndex::Slot::Test(const std::vector<uint64_t>& bits, const Alloc& alloc) const
+{
+    uint32_t firstWord = alloc.rbStart / 64;
+    uint32_t lastWord = (alloc.rbStart + alloc.rbLen - 1) / 64;
+    for (uint32_t sym = alloc.symStart; sym < alloc.symStart + alloc.symLen; ++sym)
+    {
+        for (uint32_t w = firstWord; w <= lastWord; ++w)
+        {
+            if (bits[sym * words + w] & RbMask(w, alloc.rbStart, alloc.rbStart + alloc.rbLen))
+            {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+void
+PsschOverlapIndex::Slot::Mark(std::vector<uint64_t>& bits, const Alloc& alloc, bool value) const
+{
+    uint32_t firstWord = alloc.rbStart / 64;
+    uint32_t lastWord = (alloc.rbStart + alloc.rbLen - 1) / 64;
+    for (uint32_t sym = alloc.symStart; sym < alloc.symStart + alloc.symLen; ++sym)
+    {
+        for (uint32_t w = firstWord; w <= lastWord; ++w)
+        {
+            uint64_t mask = RbMask(w, alloc.rbStart, alloc.rbStart + alloc.rbLen);
+            if (value)
+            {
+                bits[sym * words + w] |= mask;
+            }
+            else
+            {
+                bits[sym * words + w] &= ~mask;
+            }
+        }
+    }
+}
+
+bool
+PsschOverlapIndex::Overlap(const Alloc& a, const Alloc& b)
+{
+    return (a.symStart < b.symStart + b.symLen) && (b.symStart < a.symStart + a.symLen) &&
+           (a.rbStart < b.rbStart + b.rbLen) && (b.rbStart < a.rbStart + a.rbLen);
+}
+
+void
+PsschOverlapIndex::Add(const Alloc& alloc)
+{
+    m_total++;
+    if (alloc.symLen == 0 || alloc.rbLen == 0)
+    {
+        // occupies no cell, so it can not overlap
+        m_nonOverlapping++;
+        return;
+    }
+
+    Slot& slot = m_slots[SlotKey(alloc.frame, alloc.subFrame, alloc.slot)];
+    slot.Fit(alloc);
+
+    if (slot.Test(slot.nonOverlapped, alloc))
+    {
+        // The non-overlapping transmissions are disjoint, so only the one
+        // that arrived first among those hit has to be found, in the few
+        // transmissions of this slot.
+        auto it = std::find_if(slot.nonOverlapping.begin(),
+                               slot.nonOverlapping.end(),
+                               [&alloc](const Alloc& a) { return Overlap(a, alloc); });
+        slot.Mark(slot.nonOverlapped, *it, false);
+        slot.Mark(slot.overlapped, *it, true);
+        slot.Mark(slot.overlapped, alloc, true);
+        slot.nonOverlapping.erase(it);
+        m_nonOverlapping--;
+        m_overlapping += 2;
+    }
+    else if (slot.Test(slot.overlapped, alloc))
+    {
+        slot.Mark(slot.overlapped, alloc, true);
+        m_overlapping++;
+    }
+    else
+    {
+        slot.Mark(slot.nonOverlapped, alloc, true);
+        slot.nonOverlapping.push_back(alloc);
+        m_nonOverlapping++;
+    }
+}
+
+uint32_t
+PsschOverlapIndex::GetTotal() const
+{
+    return m_total;
+}
+
+uint32_t
+PsschOverlapIndex::GetNonOverlapping() const
+{
+    return m_nonOverlapping;
+}
+
+uint32_t
+PsschOverlapIndex::GetOverlapping() const
+{
+    return m_overlapping;
+}
+
+} // namespace ns3
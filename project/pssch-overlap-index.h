@@ -0,0 +1,139 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+
+// SPDX-License-Identifier: GPL-2.0-only
+
+#ifndef PSSCH_OVERLAP_INDEX_H
+#define PSSCH_OVERLAP_INDEX_H
+
+#include <inttypes.h>
+#include <map>
+#include <tuple>
+#include <vector>
+
+namespace ns3
+{
+
+/**
+ * \brief Classifies PSSCH transmissions as overlapping or non-overlapping.
+ *
+ * Two transmissions overlap if they occur on the same frame, subframe and
+ * slot, and share at least one symbol and one RB. Since only transmissions
+ * of the same slot can overlap, they are indexed by (frame, subframe, slot),
+ * and each slot keeps two symbol x RB occupancy bitmaps: one of the
+ * transmissions classified as non-overlapping so far, and one of those
+ * classified as overlapping. A transmission is then classified by testing
+ * its own cells against the bitmaps, independently of the number of
+ * transmissions added before.
+ *
+ * The classification is the one V2xKpi has always reported. When a new
+ * transmission overlaps one or more non-overlapping ones, the first of them
+ * in arrival order becomes overlapping, together with the new one; a new
+ * transmission overlapping only overlapping ones is overlapping; any other
+ * is non-overlapping. The non-overlapping transmissions of a slot are thus
+ * pairwise disjoint, which is what lets them share a bitmap.
+ *
+ * An allocation with no symbol or no RB occupies no cell and is always
+ * non-overlapping. The former closed range test matched such an empty range
+ * when it lay strictly inside another allocation; the PSSCH traces hold at
+ * least one symbol and one RB per transmission, so the counts are the same.
+ */
+class PsschOverlapIndex
+{
+  public:
+    /**
+     * \brief PSSCH allocation of one transmission
+     */
+    struct Alloc
+    {
+        uint32_t frame;    //!< frame number
+        uint32_t subFrame; //!< subframe number
+        uint16_t slot;     //!< slot number
+        uint16_t symStart; //!< starting symbol
+        uint16_t symLen;   //!< number of symbols
+        uint16_t rbStart;  //!< starting resource block
+        uint16_t rbLen;    //!< number of resource blocks
+    };
+
+    /**
+     * \brief PsschOverlapIndex constructor
+     */
+    PsschOverlapIndex();
+
+    /**
+     * \brief Classify a transmission and add it to the index
+     * \param alloc The PSSCH allocation of the transmission
+     */
+    void Add(const Alloc& alloc);
+
+    /**
+     * \brief Get the number of transmissions added
+     * \return The number of transmissions
+     */
+    uint32_t GetTotal() const;
+    /**
+     * \brief Get the number of transmissions overlapping no other
+     * \return The number of non-overlapping transmissions
+     */
+    uint32_t GetNonOverlapping() const;
+    /**
+     * \brief Get the number of transmissions overlapping another
+     * \return The number of overlapping transmissions
+     */
+    uint32_t GetOverlapping() const;
+
+  private:
+    /// (frame, subframe, slot)
+    using SlotKey = std::tuple<uint32_t, uint32_t, uint16_t>;
+
+    /**
+     * \brief Occupancy of one slot
+     *
+     * The bitmaps hold one row per symbol, each of `words` 64-bit words
+     * with one bit per RB, and grow with the allocations of the slot.
+     */
+    struct Slot
+    {
+        uint16_t symbols{0};                 //!< number of symbol rows
+        uint16_t words{0};                   //!< number of words per row
+        std::vector<uint64_t> nonOverlapped; //!< cells of the non-overlapping transmissions
+        std::vector<uint64_t> overlapped;    //!< cells of the overlapping transmissions
+        std::vector<Alloc> nonOverlapping;   //!< non-overlapping transmissions, in arrival order
+
+        /**
+         * \brief Grow the bitmaps to hold an allocation
+         * \param alloc The allocation
+         */
+        void Fit(const Alloc& alloc);
+        /**
+         * \brief Check if an allocation has a cell set in a bitmap
+         * \param bits The bitmap
+         * \param alloc The allocation
+         * \return true if any cell of alloc is set
+         */
+        bool Test(const std::vector<uint64_t>& bits, const Alloc& alloc) const;
+        /**
+         * \brief Set or clear the cells of an allocation in a bitmap
+         * \param bits The bitmap
+         * \param alloc The allocation
+         * \param value True to set the cells, false to clear them
+         */
+        void Mark(std::vector<uint64_t>& bits, const Alloc& alloc, bool value) const;
+    };
+
+    /**
+     * \brief Check if two allocations of the same slot overlap
+     * \param a An allocation
+     * \param b Another allocation
+     * \return true if they share a symbol and an RB
+     */
+    static bool Overlap(const Alloc& a, const Alloc& b);
+
+    std::map<SlotKey, Slot> m_slots; //!< occupancy, by slot
+    uint32_t m_total{0};             //!< transmissions added
+    uint32_t m_nonOverlapping{0};    //!< non-overlapping transmissions
+    uint32_t m_overlapping{0};       //!< overlapping transmissions
+};
+
+} // namespace ns3
+
+#endif // PSSCH_OVERLAP_INDEX_H
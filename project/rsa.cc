@@ -1,7 +1,12 @@
+#include "rsa.h"
+#include "seeded_rng.h"
+
 #include <vector>
 #include <string>
 #include <algorithm>
+#include <cstring>
 #include <optional>
+#include <span>
 
 #include <cryptopp/rsa.h>
 #include <cryptopp/osrng.h>
@@ -14,16 +19,37 @@ using namespace CryptoPP;
 CryptoPP::RSA::PrivateKey private_key;
 CryptoPP::RSA::PublicKey  public_key;
 
+namespace {
+    bool inited = false;
+    std::optional<uint64_t> key_seed; // see rsa_set_key_seed
+}
+
+bool rsa_set_key_seed(uint64_t seed) {
+    if (inited) return false;
+    key_seed = seed;
+    return true;
+}
+
 void init_rsa_keys() {
-    static bool inited = false;
     if (!inited) {
-        CryptoPP::AutoSeededRandomPool rng;
-        private_key.GenerateRandomWithKeySize(rng, 2048);
+        if (key_seed) {
+            SeededRng rng;
+            seed_rng(rng, *key_seed, 2);
+            private_key.GenerateRandomWithKeySize(rng, 2048);
+        } else {
+            CryptoPP::AutoSeededRandomPool rng;
+            private_key.GenerateRandomWithKeySize(rng, 2048);
+        }
         public_key.Initialize(private_key.GetModulus(), private_key.GetPublicExponent());
         inited = true;
     }
 }
 
+std::size_t rsa_chunk_size() {
+    init_rsa_keys();
+    return public_key.GetModulus().ByteCount();
+}
+
 std::vector<std::string> rsa_encrypt_chunks(const std::string& message) {
     init_rsa_keys();
     AutoSeededRandomPool rng;
@@ -77,3 +103,72 @@ std::optional<std::string> rsa_decrypt_chunks(const std::vector<std::string>& ci
 
     return recovered;
 }
+
+namespace {
+    // Largest plaintext one OAEP chunk can carry.
+    size_t max_chunk_plaintext() {
+        init_rsa_keys();
+        static const size_t len = RSAES_OAEP_SHA_Encryptor(public_key).FixedMaxPlaintextLength();
+        return len;
+    }
+}
+
+std::size_t rsa_encrypted_size(std::size_t message_bytes) {
+    const size_t maxLen = max_chunk_plaintext();
+    return (message_bytes + maxLen - 1) / maxLen * rsa_chunk_size();
+}
+
+std::size_t rsa_decrypted_size(std::size_t cipher_bytes) {
+    return cipher_bytes / rsa_chunk_size() * max_chunk_plaintext();
+}
+
+std::optional<std::size_t> rsa_encrypt_into(std::span<const std::byte> message,
+                                            std::span<std::byte> out) {
+    const size_t total = rsa_encrypted_size(message.size());
+    if (out.size() < total) return std::nullopt;
+
+    AutoSeededRandomPool rng;
+    RSAES_OAEP_SHA_Encryptor encryptor(public_key);
+    const size_t maxLen = encryptor.FixedMaxPlaintextLength();
+    const size_t chunkLen = rsa_chunk_size();
+
+    const byte* in = reinterpret_cast<const byte*>(message.data());
+    byte* o = reinterpret_cast<byte*>(out.data());
+    for (size_t offset = 0; offset < message.size(); offset += maxLen, o += chunkLen) {
+        encryptor.Encrypt(rng, in + offset, std::min(maxLen, message.size() - offset), o);
+    }
+    return total;
+}
+
+std::optional<std::size_t> rsa_decrypt_into(std::span<const std::byte> ciphertext,
+                                            std::span<std::byte> out) {
+    const size_t chunkLen = rsa_chunk_size();
+    if (ciphertext.size() % chunkLen != 0) return std::nullopt;
+
+    AutoSeededRandomPool rng;
+    RSAES_OAEP_SHA_Decryptor decryptor(private_key);
+    const size_t maxLen = decryptor.FixedMaxPlaintextLength();
+
+    const byte* in = reinterpret_cast<const byte*>(ciphertext.data());
+    byte* o = reinterpret_cast<byte*>(out.data());
+    size_t written = 0;
+    SecByteBlock tail; // only for a last chunk that may not fit in out
+    try {
+        for (size_t offset = 0; offset < ciphertext.size(); offset += chunkLen) {
+            byte* dst = o + written;
+            if (out.size() - written < maxLen) {
+                tail.resize(maxLen);
+                dst = tail;
+            }
+            DecodingResult result = decryptor.Decrypt(rng, in + offset, chunkLen, dst);
+            if (!result.isValidCoding || out.size() - written < result.messageLength) {
+                return std::nullopt;
+            }
+            if (dst == tail.data()) std::memcpy(o + written, tail, result.messageLength);
+            written += result.messageLength;
+        }
+    } catch (...) {
+        return std::nullopt;
+    }
+    return written;
+}
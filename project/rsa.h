@@ -1,7 +1,10 @@
 #ifndef RSA_CHUNKER_H
 #define RSA_CHUNKER_H
 
+#include <cstddef>
+#include <cstdint>
 #include <vector>
+#include <span>
 #include <string>
 #include <optional>
 
@@ -10,6 +13,11 @@
 // Initializes the RSA keypair exactly once
 void init_rsa_keys();
 
+// Derives the keypair from seed instead of drawing it at random, so
+// ciphertext stored by one process decrypts in another. Returns false if
+// the keypair was already generated.
+bool rsa_set_key_seed(uint64_t seed);
+
 // The RSA keypair (defined in rsa.cpp)
 extern CryptoPP::RSA::PrivateKey private_key;
 extern CryptoPP::RSA::PublicKey  public_key;
@@ -18,8 +26,27 @@ extern CryptoPP::RSA::PublicKey  public_key;
 // Returns an empty vector on failure
 std::vector<std::string> rsa_encrypt_chunks(const std::string& message);
 
+// Size in bytes of one encrypted chunk (the modulus length)
+std::size_t rsa_chunk_size();
+
 // Decrypts the vector of RSA-encrypted chunks and reassembles the original
 // Returns std::nullopt on any failure
 std::optional<std::string> rsa_decrypt_chunks(const std::vector<std::string>& ciphertexts);
 
+// Span API: the chunks are laid out back to back (the wire format of
+// crypto_engine) and written straight into the caller buffer. Both return
+// the bytes written, or std::nullopt on error or when out is too small.
+
+// Exact size of the concatenated chunks of message_bytes of plaintext.
+std::size_t rsa_encrypted_size(std::size_t message_bytes);
+
+// Upper bound of the plaintext size of cipher_bytes of concatenated chunks.
+std::size_t rsa_decrypted_size(std::size_t cipher_bytes);
+
+std::optional<std::size_t> rsa_encrypt_into(std::span<const std::byte> message,
+                                            std::span<std::byte> out);
+
+std::optional<std::size_t> rsa_decrypt_into(std::span<const std::byte> ciphertext,
+                                            std::span<std::byte> out);
+
 #endif // RSA_CHUNKER_H
\ No newline at end of file
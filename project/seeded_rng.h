@@ -0,0 +1,27 @@
+#ifndef SEEDED_RNG_H
+#define SEEDED_RNG_H
+
+// Deterministic Crypto++ random number generator for key generation, shared
+// by aes.cc, rsa.cc and ecc.cc: the AES-128 OFB keystream of a key made of
+// a 64-bit seed, with one stream per engine. It only makes the keys
+// reproducible (see engine_set_key_seed); the per message randomness (IVs,
+// ephemeral keys, OAEP padding) still comes from AutoSeededRandomPool.
+
+#include <cryptopp/aes.h>
+#include <cryptopp/modes.h>
+
+#include <cstdint>
+
+using SeededRng = CryptoPP::OFB_Mode<CryptoPP::AES>::Encryption;
+
+// Keys rng with seed; stream tells the engines apart (their CryptoEngine
+// number), so they don't draw the same bytes from the same seed.
+inline void seed_rng(SeededRng& rng, uint64_t seed, uint8_t stream) {
+    CryptoPP::byte key[CryptoPP::AES::DEFAULT_KEYLENGTH] = {};
+    for (int i = 0; i < 8; ++i) key[i] = static_cast<CryptoPP::byte>(seed >> (56 - 8 * i));
+    CryptoPP::byte iv[CryptoPP::AES::BLOCKSIZE] = {};
+    iv[0] = stream;
+    rng.SetKeyWithIV(key, sizeof(key), iv, sizeof(iv));
+}
+
+#endif // SEEDED_RNG_H
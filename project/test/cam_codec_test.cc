@@ -0,0 +1,40 @@
+#include "../cam_generation.h"
+#include <cassert>
+#include <cmath>
+#include <iostream>
+#include <string>
+
+int main() {
+    auto cams = generate_cams(50);
+    assert(cams.size() == 50);
+
+    // Binary bundle is a fixed size per CAM and decodes back within the
+    // fixed-point resolution of each field
+    std::string bytes = encode_cams(cams);
+    assert(bytes.size() == cams.size() * CAM_BINARY_SIZE);
+    auto decoded = decode_cams(bytes);
+    assert(decoded.has_value());
+    for (size_t i = 0; i < cams.size(); ++i) {
+        const Cam& a = cams[i];
+        const Cam& b = (*decoded)[i];
+        assert(a.station_id == b.station_id && a.time == b.time);
+        assert(std::fabs(a.lat - b.lat) <= 0.5e-7 && std::fabs(a.lon - b.lon) <= 0.5e-7);
+        assert(std::fabs(a.alt - b.alt) <= 0.005 && std::fabs(a.speed - b.speed) <= 0.005);
+        assert(std::fabs(a.heading - b.heading) <= 0.05 && std::fabs(a.acc - b.acc) <= 0.05);
+    }
+    std::cout << "Binary round trip passed (" << CAM_BINARY_SIZE << " bytes per CAM).\n";
+
+    // Truncated or text bundles are rejected
+    assert(validate_binary_messages(bytes));
+    assert(!validate_binary_messages(bytes.substr(0, bytes.size() - 1)));
+    assert(!validate_binary_messages(generate_messages(2)));
+    std::cout << "Malformed bundles rejected.\n";
+
+    // Out of range values saturate instead of wrapping
+    Cam fast = cams[0];
+    fast.speed = 1000.0;
+    auto saturated = decode_cams(encode_cams({fast}));
+    assert(saturated && (*saturated)[0].speed == 655.35);
+    std::cout << "Saturation passed.\n";
+    return 0;
+}
@@ -0,0 +1,61 @@
+#include "../cam_corpus_file.h"
+#include "../cam_generation.h"
+#include <cassert>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+
+int main() {
+    const std::string path =
+        (std::filesystem::temp_directory_path() / "cam_corpus_file_test.bin").string();
+
+    // Round trip of plaintext and wire bytes, including empty records
+    std::vector<std::string> plain = {generate_messages(1), generate_messages(10), ""};
+    {
+        CamCorpusWriter writer;
+        [[maybe_unused]] bool ok = writer.open(path, {true, CryptoEngine::Aes, 42});
+        assert(ok);
+        for (const auto& p : plain) {
+            ok = writer.append(p, "wire:" + p);
+            assert(ok);
+        }
+        ok = writer.close();
+        assert(ok);
+    }
+    CamCorpusFile corpus;
+    [[maybe_unused]] bool opened = corpus.open(path);
+    assert(opened);
+    assert(corpus.size() == plain.size());
+    assert(corpus.info().binary_cams && corpus.encrypted());
+    assert(corpus.info().key_seed == 42);
+    for (std::size_t i = 0; i < plain.size(); ++i) {
+        assert(corpus[i].plain == plain[i]);
+        assert(corpus[i].wire == "wire:" + plain[i]);
+    }
+    CamCorpusFile moved = std::move(corpus);
+    assert(moved.size() == plain.size() && corpus.size() == 0);
+    assert(moved[1].plain == plain[1]);
+    std::cout << "Corpus round trip passed.\n";
+
+    // Truncated files are rejected instead of mapped
+    const auto size = std::filesystem::file_size(path);
+    std::filesystem::resize_file(path, size - 1);
+    CamCorpusFile truncated;
+    opened = truncated.open(path);
+    assert(!opened);
+    std::cout << "Truncated corpus rejected: " << truncated.error() << "\n";
+
+    {
+        std::ofstream text(path, std::ios::trunc);
+        text << generate_messages(3);
+    }
+    CamCorpusFile notCorpus;
+    opened = notCorpus.open(path);
+    assert(!opened);
+    std::cout << "Text file rejected: " << notCorpus.error() << "\n";
+
+    std::remove(path.c_str());
+    return 0;
+}
@@ -0,0 +1,40 @@
+#include "../cam_generation.h"
+#include "../philox.h"
+#include <cassert>
+#include <iostream>
+#include <string>
+
+int main() {
+    // Known-answer vectors of the Philox4x32-10 reference implementation
+    constexpr auto zeros = Philox4x32::generate({0, 0, 0, 0}, {0, 0});
+    static_assert(zeros == Philox4x32::Counter{0x6627e8d5, 0xe169c58d, 0xbc57ac4c, 0x9b00dbd8});
+    auto pi = Philox4x32::generate({0x243f6a88, 0x85a308d3, 0x13198a2e, 0x03707344},
+                                   {0xa4093822, 0x299f31d0});
+    assert((pi == Philox4x32::Counter{0xd16cfe09, 0x94fdcceb, 0x5001e420, 0x24126ea1}));
+    std::cout << "Philox known answers passed.\n";
+
+    // A CAM only depends on (seed, station, step)
+    Cam a = deterministic_cam(42, 7, 3);
+    Cam b = deterministic_cam(42, 7, 3);
+    assert(format_cam(a) == format_cam(b));
+    assert(format_cam(a) != format_cam(deterministic_cam(43, 7, 3)));
+    assert(a.heading >= 0.0 && a.heading < 360.0);
+
+    // The corpus is the same for every thread count
+    CamCorpusSpec spec{42, 1000, 7};
+    auto cams = generate_cam_corpus(spec, 1);
+    assert(cams.size() == 7000);
+    assert(cams[3 * 1000 + 7].station_id == 7);
+    assert(format_cam(cams[3 * 1000 + 7]) == format_cam(a));
+
+    const std::string text = generate_cam_corpus_text(spec, 1);
+    const std::string binary = generate_cam_corpus_binary(spec, 1);
+    assert(binary == encode_cams(cams));
+    for (unsigned threads : {2u, 3u, 8u, 0u}) {
+        assert(encode_cams(generate_cam_corpus(spec, threads)) == binary);
+        assert(generate_cam_corpus_text(spec, threads) == text);
+        assert(generate_cam_corpus_binary(spec, threads) == binary);
+    }
+    std::cout << "Corpus identical across thread counts.\n";
+    return 0;
+}
@@ -0,0 +1,104 @@
+#include "../cam_delta.h"
+#include "../cam_generation.h"
+#include <cassert>
+#include <iostream>
+#include <string>
+
+namespace {
+
+    // steps bundles of one CAM per station, each station moving smoothly
+    std::vector<std::vector<Cam>> make_stream(uint32_t stations, uint32_t steps) {
+        std::vector<std::vector<Cam>> stream(steps);
+        for (uint32_t s = 0; s < stations; ++s) {
+            Cam cam = deterministic_cam(1, s, 0);
+            for (uint32_t t = 0; t < steps; ++t) {
+                stream[t].push_back(cam);
+                cam = next_cam(cam);
+            }
+        }
+        return stream;
+    }
+
+    bool same_as_binary(const std::vector<Cam>& decoded, const std::vector<Cam>& sent) {
+        auto expected = decode_cams(encode_cams(sent));
+        if (!expected || expected->size() != decoded.size()) return false;
+        for (std::size_t i = 0; i < decoded.size(); ++i) {
+            if (format_cam(decoded[i]) != format_cam((*expected)[i])) return false;
+        }
+        return true;
+    }
+
+} // namespace
+
+int main() {
+    auto stream = make_stream(10, 40);
+
+    // Lossless round trip, to the binary schema resolution, and smaller
+    // than binary CAMs once past the first keyframes
+    CamDeltaEncoder encoder(10);
+    CamDeltaDecoder decoder;
+    std::size_t deltaBytes = 0, binaryBytes = 0;
+    for (const auto& bundle : stream) {
+        std::string bytes = encoder.encode(bundle);
+        std::vector<Cam> decoded;
+        [[maybe_unused]] bool ok = decoder.decode(bytes, decoded);
+        assert(ok);
+        assert(same_as_binary(decoded, bundle));
+        deltaBytes += bytes.size();
+        binaryBytes += encode_cams(bundle).size();
+    }
+    assert(deltaBytes * 2 < binaryBytes);
+    std::cout << "Delta round trip passed (" << deltaBytes << " vs " << binaryBytes
+              << " binary bytes).\n";
+
+    // Without feedback a lost bundle breaks the deltas of its stations until
+    // their next keyframe; the other stations of the same bundles decode
+    CamDeltaEncoder lossy(10);
+    CamDeltaDecoder lossyDecoder;
+    std::vector<std::size_t> decodedCams;
+    for (std::size_t t = 0; t < 20; ++t) {
+        std::vector<Cam> decoded;
+        if (t == 3) {
+            // stations 0-4 and 5-9 in two packets, the second one lost
+            std::vector<Cam> first(stream[t].begin(), stream[t].begin() + 5);
+            std::vector<Cam> second(stream[t].begin() + 5, stream[t].end());
+            [[maybe_unused]] bool ok = lossyDecoder.decode(lossy.encode(first), decoded);
+            assert(ok);
+            lossy.encode(second);
+        } else {
+            [[maybe_unused]] bool ok = lossyDecoder.decode(lossy.encode(stream[t]), decoded);
+            assert(ok);
+        }
+        decodedCams.push_back(decoded.size());
+    }
+    assert(decodedCams[3] == 5);
+    for (std::size_t t = 4; t < 10; ++t) assert(decodedCams[t] == 5); // stations 0-4 only
+    assert(decodedCams[10] == 10 && decodedCams.back() == 10);      // keyframes
+    assert(lossyDecoder.missing_references() == 6 * 5);
+    std::cout << "Loss recovery at keyframes passed.\n";
+
+    // With acknowledgements deltas only refer to CAMs the receiver holds
+    CamDeltaEncoder acked(10, false);
+    CamDeltaDecoder ackedDecoder;
+    for (std::size_t t = 0; t < stream.size(); ++t) {
+        std::string bytes = acked.encode(stream[t]);
+        if (t % 4 == 1) continue; // lost
+        std::vector<Cam> decoded;
+        std::vector<CamDeltaAck> acks;
+        [[maybe_unused]] bool ok = ackedDecoder.decode(bytes, decoded, &acks);
+        assert(ok);
+        assert(same_as_binary(decoded, stream[t]));
+        for (const auto& ack : acks) acked.acknowledge(ack);
+    }
+    std::cout << "Acknowledged deltas survive losses.\n";
+
+    // Malformed bundles are rejected
+    std::vector<Cam> decoded;
+    CamDeltaDecoder fresh;
+    assert(!fresh.decode("", decoded));
+    assert(!fresh.decode(encode_cams(stream[0]), decoded));
+    std::string bytes = CamDeltaEncoder().encode(stream[0]);
+    assert(!fresh.decode(bytes.substr(0, bytes.size() - 1), decoded));
+    std::cout << "Malformed bundles rejected.\n";
+    return 0;
+}
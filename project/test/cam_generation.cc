@@ -20,8 +20,18 @@ int main(int argc, char* argv[]) {
         }
     }
 
-    std::string output = generate_messages(count);
-    std::fputs(output.c_str(), stdout);
+    if (count <= 1000) {
+        std::string output = generate_messages(count);
+        std::fputs(output.c_str(), stdout);
+        return 0;
+    }
+
+    // Past the 1000 CAM cap of generate_messages, stream from a generator
+    // with one station per CAM.
+    CamGenerator generator(static_cast<uint32_t>(count));
+    generator.generate_text(static_cast<uint32_t>(count), [](std::string_view chunk) {
+        std::fwrite(chunk.data(), 1, chunk.size(), stdout);
+    });
 
     return 0;
 }
@@ -0,0 +1,60 @@
+#include "../alloc_tracker.h"
+#include "../cam_generation.h"
+#include "../cam_parser.h"
+#include <array>
+#include <cassert>
+#include <iostream>
+#include <string>
+
+int main() {
+    std::vector<Cam> cams;
+    std::string text;
+    for (uint32_t s = 0; s < 10; ++s) {
+        cams.push_back(deterministic_cam(7, s, 0));
+        text += format_cam(cams.back());
+    }
+    const std::string binary = encode_cams(cams);
+
+    // Text CAMs parse back to the values they were printed from
+    std::array<Cam, 16> out;
+    auto n = parse_cams(text, false, out);
+    assert(n && *n == cams.size());
+    for (std::size_t i = 0; i < cams.size(); ++i) {
+        assert(format_cam(out[i]) == format_cam(cams[i]));
+    }
+    assert(count_cams(generate_messages(10), false) == 10u);
+
+    // Binary CAMs parse like decode_cams
+    n = parse_cams(binary, true, out);
+    assert(n && *n == cams.size());
+    auto decoded = decode_cams(binary);
+    for (std::size_t i = 0; i < cams.size(); ++i) {
+        assert(format_cam(out[i]) == format_cam((*decoded)[i]));
+    }
+    std::cout << "Text and binary parse passed.\n";
+
+    // Malformed bundles are rejected
+    assert(!count_cams("", false));
+    assert(!count_cams(text.substr(0, text.size() - 1), false));        // no final newline
+    assert(!count_cams(text.substr(0, text.size() - 20) + "\n", false)); // cut line
+    assert(!count_cams("CAM,StationID=1,Time=2,Lat=x,Lon=0,Alt=0,Speed=0,Heading=0,Acc=0\n", false));
+    assert(!count_cams("CAM,StationID=1,Time=2,Lat=1,Lon=0,Alt=0,Speed=0,Heading=0,Acc=0,\n", false));
+    assert(!count_cams(binary.substr(1), true));
+    assert(!count_cams(text, true));
+    assert(!parse_cams(text, false, std::span(out).first(3)));
+    std::cout << "Malformed bundles rejected.\n";
+
+    // Parsing does not touch the heap
+    assert(alloc_tracking_available());
+    alloc_tracking_enable(true);
+    AllocSnapshot before = alloc_snapshot();
+    std::size_t parsed = 0;
+    for (int i = 0; i < 100; ++i) {
+        parsed += count_cams(text, false).value_or(0) + count_cams(binary, true).value_or(0);
+    }
+    AllocSnapshot delta = alloc_delta(before, alloc_snapshot());
+    alloc_tracking_enable(false);
+    assert(parsed == 2000 && delta.count == 0);
+    std::cout << "No allocations while parsing.\n";
+    return 0;
+}
@@ -0,0 +1,220 @@
+#include "../kpi-table-writer.h"
+#include <cassert>
+#include <csignal>
+#include <cstdio>
+#include <functional>
+#include <iostream>
+#include <sqlite3.h>
+#include <string>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <vector>
+
+using ns3::KpiTableWriter;
+
+namespace {
+
+    const std::string DB = "kpi_table_writer_test.db";
+    const std::vector<std::string> COLUMNS = {"nodeId INTEGER NOT NULL", "ip TEXT NOT NULL",
+                                              "value DOUBLE"};
+
+    sqlite3* open_db(const std::string& path) {
+        sqlite3* db = nullptr;
+        [[maybe_unused]] int rc = sqlite3_open(path.c_str(), &db);
+        assert(rc == SQLITE_OK);
+        return db;
+    }
+
+    // Rows of a query, one string per row with its columns separated by '|'
+    std::vector<std::string> query(sqlite3* db, const std::string& sql) {
+        sqlite3_stmt* stmt = nullptr;
+        [[maybe_unused]] int rc = sqlite3_prepare_v2(db, sql.c_str(), -1, &stmt, nullptr);
+        assert(rc == SQLITE_OK);
+        std::vector<std::string> rows;
+        while (sqlite3_step(stmt) == SQLITE_ROW) {
+            std::string row;
+            for (int c = 0; c < sqlite3_column_count(stmt); ++c) {
+                const unsigned char* text = sqlite3_column_text(stmt, c);
+                row += (c > 0 ? "|" : "") + std::string(text ? reinterpret_cast<const char*>(text) : "NULL");
+            }
+            rows.push_back(row);
+        }
+        sqlite3_finalize(stmt);
+        return rows;
+    }
+
+    void write_rows(sqlite3* db, uint32_t seed, uint64_t run, int rows, uint32_t batchSize = 0) {
+        KpiTableWriter writer(db, "kpi", COLUMNS, seed, run, batchSize);
+        const std::string ip = "10.0.0.1";
+        for (int i = 0; i < rows; ++i) writer.BindInt(i).BindText(ip).BindDouble(0.5 * i).EndRow();
+        assert(writer.GetRows() == static_cast<uint64_t>(rows));
+    }
+
+    // true if body aborts, run in a child process so the abort doesn't end
+    // the test; the child opens a connection of its own, since SQLite
+    // connections must not be used across a fork
+    bool aborts(const std::function<void(sqlite3*)>& body) {
+        std::cout.flush();
+        pid_t pid = fork();
+        if (pid == 0) {
+            // the abort message is expected, keep it off the test output
+            std::freopen("/dev/null", "w", stderr);
+            body(open_db(DB));
+            _exit(0);
+        }
+        int status = 0;
+        waitpid(pid, &status, 0);
+        return WIFSIGNALED(status) && WTERMSIG(status) == SIGABRT;
+    }
+
+} // namespace
+
+int main() {
+    std::remove(DB.c_str());
+    sqlite3* db = open_db(DB);
+
+    // Rewriting a seed and run replaces its rows only
+    write_rows(db, 1, 1, 3);
+    write_rows(db, 1, 2, 2);
+    write_rows(db, 2, 1, 1);
+    write_rows(db, 1, 1, 1);
+    std::vector<std::string> rows = query(db, "SELECT SEED, RUN, COUNT(*) FROM kpi GROUP BY SEED, RUN");
+    assert((rows == std::vector<std::string>{"1|1|1", "1|2|2", "2|1|1"}));
+    rows = query(db, "SELECT * FROM kpi WHERE SEED = 1 AND RUN = 2 ORDER BY rowid");
+    assert((rows == std::vector<std::string>{"0|10.0.0.1|0.0|1|2", "1|10.0.0.1|0.5|1|2"}));
+    std::cout << "Rows replaced per seed and run.\n";
+
+    // BindNull leaves a nullable column NULL
+    {
+        KpiTableWriter writer(db, "kpi", COLUMNS, 3, 1);
+        const std::string ip = "10.0.0.2";
+        writer.BindInt(7).BindText(ip).BindNull().EndRow();
+    }
+    rows = query(db, "SELECT nodeId, value IS NULL FROM kpi WHERE SEED = 3");
+    assert((rows == std::vector<std::string>{"7|1"}));
+    std::cout << "NULL bound.\n";
+
+    // With a batch size, a second connection sees the rows every batchSize
+    // rows, and all of them after Finish
+    sqlite3* reader = open_db(DB);
+    auto committed = [&] { return query(reader, "SELECT COUNT(*) FROM kpi WHERE SEED = 4").front(); };
+    {
+        KpiTableWriter writer(db, "kpi", COLUMNS, 4, 1, 3);
+        const std::string ip = "10.0.0.3";
+        std::vector<std::string> seen;
+        for (int i = 0; i < 7; ++i) {
+            writer.BindInt(i).BindText(ip).BindDouble(i).EndRow();
+            seen.push_back(committed());
+        }
+        assert((seen == std::vector<std::string>{"0", "0", "3", "3", "3", "6", "6"}));
+        writer.Finish();
+        assert(committed() == "7");
+        writer.Finish(); // no effect
+    }
+    assert(committed() == "7");
+    sqlite3_close(reader);
+    std::cout << "Batches committed every batchSize rows.\n";
+
+    // Rows with too many or too few columns bound abort
+    const std::string ip = "10.0.0.4";
+    [[maybe_unused]] bool aborted = aborts([&](sqlite3* child) {
+        KpiTableWriter writer(child, "kpi", COLUMNS, 5, 1);
+        writer.BindInt(1).BindText(ip).BindDouble(1.0).BindInt(2);
+    });
+    assert(aborted);
+    aborted = aborts([&](sqlite3* child) {
+        KpiTableWriter writer(child, "kpi", COLUMNS, 5, 1);
+        writer.BindInt(1).BindText(ip).EndRow();
+    });
+    assert(aborted);
+    aborted = aborts([&](sqlite3* child) {
+        KpiTableWriter writer(child, "kpi", COLUMNS, 5, 1);
+        writer.Finish();
+        writer.BindInt(1).BindText(ip).BindDouble(1.0).EndRow();
+    });
+    assert(aborted);
+    aborted = aborts([&](sqlite3* child) {
+        KpiTableWriter writer(child, "kpi", COLUMNS, 5, 1);
+        writer.BindInt(1).BindText(ip).BindDouble(1.0).EndRow();
+    });
+    assert(!aborted);
+    std::cout << "Rows with the wrong column count aborted.\n";
+
+    // A cryptoOverhead table of the 7 columns of older versions is moved to
+    // cryptoOverhead_old1 and a new one created; the next outdated one goes
+    // to cryptoOverhead_old2
+    const std::vector<std::string> cryptoColumns = {
+        "nodeId INTEGER NOT NULL",        "encryptionTime REAL NOT NULL",
+        "decryptionTime REAL NOT NULL",   "length INTEGER NOT NULL",
+        "declength INTEGER NOT NULL",     "encryptionMin REAL NOT NULL",
+        "encryptionP99 REAL NOT NULL",    "encryptionStddev REAL NOT NULL",
+        "decryptionMin REAL NOT NULL",    "decryptionP99 REAL NOT NULL",
+        "decryptionStddev REAL NOT NULL", "iterations INTEGER NOT NULL"};
+    const char* oldTable =
+        "CREATE TABLE cryptoOverhead (nodeId INTEGER NOT NULL, encryptionTime REAL NOT NULL,"
+        " decryptionTime REAL NOT NULL, length INTEGER NOT NULL, declength INTEGER NOT NULL,"
+        " SEED INTEGER NOT NULL, RUN INTEGER NOT NULL);";
+    auto write_crypto = [&](int node) {
+        KpiTableWriter writer(db, "cryptoOverhead", cryptoColumns, 1, 1);
+        writer.BindInt(node);
+        for (int c = 1; c < 11; ++c) writer.BindDouble(c);
+        writer.BindInt(20).EndRow();
+    };
+    [[maybe_unused]] auto columns_of = [&](const std::string& table) {
+        return query(db, "SELECT name || ' ' || type || (CASE WHEN \"notnull\" THEN ' NOT NULL' ELSE '' END)"
+                         " FROM pragma_table_info('" + table + "')");
+    };
+    std::vector<std::string> newSchema = cryptoColumns;
+    newSchema.push_back("SEED INTEGER NOT NULL");
+    newSchema.push_back("RUN INTEGER NOT NULL");
+
+    [[maybe_unused]] int rc = sqlite3_exec(db, oldTable, nullptr, nullptr, nullptr);
+    assert(rc == SQLITE_OK);
+    rc = sqlite3_exec(db, "INSERT INTO cryptoOverhead VALUES (1, 0.1, 0.2, 100, 90, 1, 1);", nullptr,
+                      nullptr, nullptr);
+    assert(rc == SQLITE_OK);
+    write_crypto(2);
+    assert(columns_of("cryptoOverhead") == newSchema);
+    rows = query(db, "SELECT nodeId, iterations FROM cryptoOverhead");
+    assert((rows == std::vector<std::string>{"2|20"}));
+    assert(columns_of("cryptoOverhead_old1").size() == 7);
+    rows = query(db, "SELECT * FROM cryptoOverhead_old1");
+    assert((rows == std::vector<std::string>{"1|0.1|0.2|100|90|1|1"}));
+
+    // the same schema again is written in place
+    write_crypto(3);
+    rows = query(db, "SELECT name FROM sqlite_master WHERE name LIKE 'cryptoOverhead%' ORDER BY name");
+    assert((rows == std::vector<std::string>{"cryptoOverhead", "cryptoOverhead_old1"}));
+
+    rc = sqlite3_exec(db, "DROP TABLE cryptoOverhead;", nullptr, nullptr, nullptr);
+    assert(rc == SQLITE_OK);
+    rc = sqlite3_exec(db, oldTable, nullptr, nullptr, nullptr);
+    assert(rc == SQLITE_OK);
+    rc = sqlite3_exec(db, "INSERT INTO cryptoOverhead VALUES (4, 0.1, 0.2, 100, 90, 1, 1);", nullptr,
+                      nullptr, nullptr);
+    assert(rc == SQLITE_OK);
+    write_crypto(5);
+    rows = query(db, "SELECT name FROM sqlite_master WHERE name LIKE 'cryptoOverhead%' ORDER BY name");
+    assert((rows ==
+            std::vector<std::string>{"cryptoOverhead", "cryptoOverhead_old1", "cryptoOverhead_old2"}));
+    assert(columns_of("cryptoOverhead") == newSchema);
+    assert(query(db, "SELECT nodeId FROM cryptoOverhead_old1").front() == "1");
+    assert(query(db, "SELECT nodeId FROM cryptoOverhead_old2").front() == "4");
+    assert(query(db, "SELECT nodeId FROM cryptoOverhead").front() == "5");
+
+    // a column that only differs in its NOT NULL constraint is outdated too
+    write_rows(db, 1, 1, 1);
+    rc = sqlite3_exec(db, "ALTER TABLE kpi RENAME TO kpiSaved;"
+                          "CREATE TABLE kpi (nodeId INTEGER NOT NULL, ip TEXT NOT NULL,"
+                          " value DOUBLE NOT NULL, SEED INTEGER NOT NULL, RUN INTEGER NOT NULL);",
+                      nullptr, nullptr, nullptr);
+    assert(rc == SQLITE_OK);
+    write_rows(db, 1, 1, 1);
+    rows = query(db, "SELECT name FROM sqlite_master WHERE name = 'kpi_old1'");
+    assert(rows.size() == 1);
+    std::cout << "Outdated tables moved out of the way.\n";
+
+    sqlite3_close(db);
+    std::remove(DB.c_str());
+    return 0;
+}
@@ -0,0 +1,47 @@
+#include "../cam_generation.h"
+#include "../payload_compressor.h"
+#include <cassert>
+#include <iostream>
+#include <string>
+
+int main() {
+    const std::string bundle = generate_messages(5);
+
+    // Round trip with and without a dictionary
+    PayloadCompressor plain;
+    PayloadCompressor trained(train_cam_dictionary(false));
+    for (const PayloadCompressor* c : {&plain, &trained}) {
+        CompressionResult r;
+        std::string out = c->compress(bundle, &r);
+        assert(r.in_bytes == bundle.size() && r.out_bytes == out.size());
+        assert(c->decompress(out) == bundle);
+    }
+    assert(!trained.decompress(""));
+
+    if (!PayloadCompressor::available()) {
+        std::cout << "zstd not available, payloads are bypassed.\n";
+        return 0;
+    }
+
+    // The dictionary makes single bundles compress well
+    CompressionResult r;
+    trained.compress(bundle, &r);
+    assert(trained.dictionary_size() > 0 && !r.bypassed && r.ratio() > 2.0);
+    std::cout << "Trained dictionary ratio " << r.ratio() << ".\n";
+
+    // Incompressible or tiny payloads are sent as they are
+    std::string random;
+    for (uint32_t i = 0; i < 256; ++i) random.push_back(static_cast<char>(i * 2654435761u >> 24));
+    std::string out = trained.compress(random, &r);
+    assert(r.bypassed && out.size() == random.size() + 1 && trained.decompress(out) == random);
+    trained.compress("x", &r);
+    assert(r.bypassed);
+
+    // Corrupt frames are rejected
+    out = trained.compress(bundle);
+    out[out.size() / 2] ^= 0x55;
+    auto broken = trained.decompress(out);
+    assert(!broken || *broken != bundle);
+    std::cout << "Bypass and corruption checks passed.\n";
+    return 0;
+}
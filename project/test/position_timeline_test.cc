@@ -0,0 +1,98 @@
+#include "../position-timeline.h"
+#include <algorithm>
+#include <cassert>
+#include <iostream>
+#include <random>
+#include <vector>
+
+using ns3::PositionTimeline;
+using ns3::Vector;
+
+namespace {
+
+    // Nodes within range of pos in a snapshot, checking every node
+    std::vector<uint32_t> brute_force(const PositionTimeline& timeline, uint32_t snapshot, uint32_t nodes,
+                                      const Vector& pos, double range) {
+        std::vector<uint32_t> found;
+        for (uint32_t node = 0; node < nodes; ++node) {
+            if (timeline.HasPosition(snapshot, node) &&
+                ns3::CalculateDistance(timeline.GetPosition(snapshot, node), pos) <= range) {
+                found.push_back(node);
+            }
+        }
+        return found;
+    }
+
+} // namespace
+
+int main() {
+    // Snapshots at 1, 2 and 3 s; node 2 is only sampled from 2 s on
+    PositionTimeline timeline;
+    assert(timeline.IsEmpty());
+    timeline.Add(1.0, 0, Vector(0, 0, 0));
+    timeline.Add(1.0, 1, Vector(10, 0, 0));
+    timeline.Add(2.0, 0, Vector(5, 0, 0));
+    timeline.Add(2.0, 2, Vector(20, 0, 0));
+    timeline.Add(3.0, 1, Vector(30, 0, 0));
+    timeline.Index(4, 50.0);
+    assert(!timeline.IsEmpty());
+
+    assert(timeline.FindSnapshot(0.5) == 0); // before the first sample
+    assert(timeline.FindSnapshot(1.0) == 0);
+    assert(timeline.FindSnapshot(1.5) == 0);
+    assert(timeline.FindSnapshot(2.0) == 1);
+    assert(timeline.FindSnapshot(2.999) == 1);
+    assert(timeline.FindSnapshot(3.0) == 2);
+    assert(timeline.FindSnapshot(100.0) == 2);
+    std::cout << "Snapshot lookup passed.\n";
+
+    // Unsampled nodes keep their last position
+    assert(timeline.GetPosition(1, 1).x == 10.0);
+    assert(timeline.GetPosition(2, 0).x == 5.0 && timeline.GetPosition(2, 2).x == 20.0);
+    assert(timeline.GetPosition(2, 1).x == 30.0);
+    assert(!timeline.HasPosition(0, 2) && timeline.HasPosition(1, 2));
+    assert(!timeline.HasPosition(2, 3)); // never sampled
+    std::cout << "Carried forward positions passed.\n";
+
+    // Random nodes around the origin, so cells on both sides of the axes,
+    // moving between snapshots; some nodes are sampled late or not at all
+    std::mt19937 rng(5);
+    std::uniform_real_distribution<double> coord(-500.0, 500.0);
+    std::uniform_real_distribution<double> step(-30.0, 30.0);
+    const uint32_t nodes = 300;
+    const double cell = 100.0;
+    PositionTimeline moving;
+    std::vector<Vector> pos(nodes);
+    for (auto& p : pos) p = Vector(coord(rng), coord(rng), 1.5);
+    for (int t = 0; t < 10; ++t) {
+        for (uint32_t node = 0; node < nodes; ++node) {
+            if (node % 10 == 9 || (node % 10 == 8 && t < 5) || rng() % 4 == 0) continue;
+            pos[node].x += step(rng);
+            pos[node].y += step(rng);
+            moving.Add(0.1 * t, node, pos[node]);
+        }
+    }
+    moving.Index(nodes, cell);
+
+    std::vector<uint32_t> found;
+    for (uint32_t snapshot = 0; snapshot < 10; ++snapshot) {
+        for (int q = 0; q < 50; ++q) {
+            Vector at(coord(rng), coord(rng), 1.5);
+            for (double range : {0.0, 25.0, 80.0, cell}) {
+                moving.GetNeighbours(snapshot, at, range, found);
+                std::sort(found.begin(), found.end());
+                assert(found == brute_force(moving, snapshot, nodes, at, range));
+            }
+        }
+        // a query from a node finds at least that node
+        for (uint32_t node = 0; node < nodes; ++node) {
+            if (!moving.HasPosition(snapshot, node)) continue;
+            moving.GetNeighbours(snapshot, moving.GetPosition(snapshot, node), cell, found);
+            std::sort(found.begin(), found.end());
+            assert(std::binary_search(found.begin(), found.end(), node));
+            assert(found == brute_force(moving, snapshot, nodes, moving.GetPosition(snapshot, node), cell));
+        }
+    }
+    std::cout << "Grid neighbours match the brute force passed.\n";
+    return 0;
+}
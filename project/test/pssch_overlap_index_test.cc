@@ -0,0 +1,107 @@
+#include "../pssch-overlap-index.h"
+#include <algorithm>
+#include <cassert>
+#include <iostream>
+#include <random>
+#include <vector>
+
+using ns3::PsschOverlapIndex;
+
+namespace {
+
+    // The allocation and overlap test V2xKpi classified transmissions with
+    // before PsschOverlapIndex: std::find through the lists of
+    // non-overlapping and overlapping transmissions.
+    struct ReferenceTx {
+        uint32_t frame, subFrame;
+        uint16_t slot, symStart, symLen, rbStart, rbLen;
+
+        bool operator==(const ReferenceTx& r) const {
+            return frame == r.frame && subFrame == r.subFrame && slot == r.slot &&
+                   symStart <= r.symStart + r.symLen - 1 && r.symStart <= symStart + symLen - 1 &&
+                   rbStart <= r.rbStart + r.rbLen - 1 && r.rbStart <= rbStart + rbLen - 1;
+        }
+    };
+
+    struct Counts {
+        std::size_t nonOverlapping = 0;
+        std::size_t overlapping = 0;
+    };
+
+    Counts reference_counts(const std::vector<ReferenceTx>& txs) {
+        std::vector<ReferenceTx> non, over;
+        for (const auto& tx : txs) {
+            auto it = std::find(non.begin(), non.end(), tx);
+            if (it != non.end()) {
+                over.push_back(tx);
+                over.push_back(*it);
+                non.erase(it);
+            } else if (std::find(over.begin(), over.end(), tx) != over.end()) {
+                over.push_back(tx);
+            } else {
+                non.push_back(tx);
+            }
+        }
+        return {non.size(), over.size()};
+    }
+
+    PsschOverlapIndex::Alloc to_alloc(const ReferenceTx& tx) {
+        return {tx.frame, tx.subFrame, tx.slot, tx.symStart, tx.symLen, tx.rbStart, tx.rbLen};
+    }
+
+} // namespace
+
+int main() {
+    // Random slots, from a few crowded narrow ones to many wide ones, so
+    // that allocations span several bitmap words and grow the slots
+    std::mt19937 rng(1);
+    for (int trial = 0; trial < 300; ++trial) {
+        const uint16_t maxRb = trial % 3 == 0 ? 40 : 275;
+        const int n = 200 + rng() % 3000;
+        const uint32_t frames = 1 + rng() % 20;
+        std::vector<ReferenceTx> txs;
+        PsschOverlapIndex index;
+        for (int i = 0; i < n; ++i) {
+            ReferenceTx tx;
+            tx.frame = rng() % frames;
+            tx.subFrame = rng() % 2;
+            tx.slot = rng() % 2;
+            tx.symStart = rng() % 14;
+            tx.symLen = 1 + rng() % (14 - tx.symStart);
+            tx.rbStart = rng() % maxRb;
+            tx.rbLen = 1 + rng() % std::min<uint16_t>(60, maxRb - tx.rbStart);
+            txs.push_back(tx);
+            index.Add(to_alloc(tx));
+        }
+        Counts expected = reference_counts(txs);
+        assert(index.GetTotal() == static_cast<uint32_t>(n));
+        assert(index.GetNonOverlapping() == expected.nonOverlapping);
+        assert(index.GetOverlapping() == expected.overlapping);
+    }
+    std::cout << "Classification matches the std::find reference.\n";
+
+    // The first non-overlapping transmission hit turns overlapping, later
+    // ones stay as they are
+    PsschOverlapIndex chain;
+    chain.Add({0, 0, 0, 0, 2, 0, 10});  // a
+    chain.Add({0, 0, 0, 0, 2, 20, 10}); // b, disjoint from a
+    chain.Add({0, 0, 0, 1, 1, 5, 20});  // hits a (first) and b
+    assert(chain.GetNonOverlapping() == 1 && chain.GetOverlapping() == 2);
+    chain.Add({0, 0, 0, 0, 1, 8, 1});   // hits only the overlapping a
+    chain.Add({0, 0, 1, 0, 2, 0, 10});  // other slot
+    assert(chain.GetNonOverlapping() == 2 && chain.GetOverlapping() == 3);
+    std::cout << "First hit turns overlapping passed.\n";
+
+    // Zero-length allocations occupy no cell and are non-overlapping. The
+    // reference compares closed ranges, so it matched an empty range lying
+    // strictly inside another allocation; the traces carry none of them.
+    PsschOverlapIndex empty;
+    empty.Add({0, 0, 0, 0, 14, 0, 50});
+    empty.Add({0, 0, 0, 5, 0, 10, 5});
+    empty.Add({0, 0, 0, 5, 2, 10, 0});
+    assert(empty.GetTotal() == 3 && empty.GetNonOverlapping() == 3 && empty.GetOverlapping() == 0);
+    Counts reference = reference_counts({{0, 0, 0, 0, 14, 0, 50}, {0, 0, 0, 5, 0, 10, 5}});
+    assert(reference.overlapping == 2);
+    std::cout << "Zero-length allocations passed.\n";
+    return 0;
+}
@@ -0,0 +1,447 @@
+#include "../v2x-kpi.h"
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstdio>
+#include <iostream>
+#include <random>
+#include <sqlite3.h>
+#include <string>
+#include <vector>
+
+// Computes the KPIs of synthetic traces through the different V2xKpi paths
+// and checks their tables: serially and with a few thread counts, from the
+// trace tables and from an OnlineKpiEngine fed the same events, and with
+// position samples for the range based PIR and PRR.
+
+using ns3::OnlineKpiEngine;
+using ns3::PsschOverlapIndex;
+
+namespace {
+
+    const char* KPI_TABLES[] = {"avrgPir", "avrgPrr", "thput", "simulPsschTx", "PsschTbRx"};
+
+    std::string node_ip(int node) { return "10.0.0." + std::to_string(node + 1); }
+
+    // One pktTxRx row; the IMSI of a node is its id + 1
+    struct PktRow {
+        double time;
+        bool tx;
+        int node;   // transmitter or receiver
+        int txNode; // transmitter of the packet
+        int size;
+        uint32_t seq;
+    };
+
+    struct Trace {
+        std::vector<PktRow> pkts;
+        std::vector<PsschOverlapIndex::Alloc> psschTx;
+        std::vector<std::pair<bool, bool>> psschRx; // PSSCH and SCI 2 corrupted
+    };
+
+    struct PositionSample {
+        double time;
+        int node;
+        ns3::Vector pos;
+    };
+
+    struct Scenario {
+        Trace trace;
+        std::vector<ns3::Vector> positions; // initial position, by node
+        std::vector<PositionSample> samples; // in time order
+        uint16_t range = 0;
+        double duration = 1.0;
+    };
+
+    // Every third node only receives; the others lose about one packet in
+    // five, so that PIR and PRR differ from node to node
+    Scenario random_scenario(int nodes, int packets) {
+        Scenario scenario;
+        std::mt19937 rng(3);
+        uint32_t seq = 0;
+        for (int p = 0; p < packets; ++p) {
+            for (int tx = 0; tx < nodes; ++tx) {
+                if (tx % 3 == 2) continue;
+                double time = 0.1 * p + 1e-4 * tx;
+                int size = 150 + rng() % 100;
+                scenario.trace.pkts.push_back({time, true, tx, tx, size, seq});
+                for (int rx = 0; rx < nodes; ++rx) {
+                    if (rx != tx && rng() % 5 != 0) {
+                        scenario.trace.pkts.push_back({time + 0.002 + 1e-5 * rx, false, rx, tx, size, seq});
+                    }
+                }
+                ++seq;
+            }
+        }
+        for (int i = 0; i < packets * nodes / 2; ++i) {
+            PsschOverlapIndex::Alloc alloc;
+            alloc.frame = i / 40;
+            alloc.subFrame = (i / 4) % 10;
+            alloc.slot = i % 2;
+            alloc.symStart = rng() % 4;
+            alloc.symLen = 1 + rng() % 10;
+            alloc.rbStart = rng() % 40;
+            alloc.rbLen = 1 + rng() % 10;
+            scenario.trace.psschTx.push_back(alloc);
+        }
+        for (int i = 0; i < packets * nodes; ++i) {
+            scenario.trace.psschRx.emplace_back(rng() % 7 == 0, rng() % 11 == 0);
+        }
+        // Nodes along a line, 10 m apart, so some pairs are out of range
+        for (int node = 0; node < nodes; ++node) scenario.positions.emplace_back(10.0 * node, 0.0, 0.0);
+        scenario.range = 50;
+        scenario.duration = 0.1 * packets;
+        return scenario;
+    }
+
+    void exec(sqlite3* db, const char* sql) {
+        [[maybe_unused]] int rc = sqlite3_exec(db, sql, nullptr, nullptr, nullptr);
+        assert(rc == SQLITE_OK);
+    }
+
+    sqlite3_stmt* prepare(sqlite3* db, const char* sql) {
+        sqlite3_stmt* stmt = nullptr;
+        [[maybe_unused]] int rc = sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr);
+        assert(rc == SQLITE_OK);
+        return stmt;
+    }
+
+    void step(sqlite3_stmt* stmt) {
+        [[maybe_unused]] int rc = sqlite3_step(stmt);
+        assert(rc == SQLITE_DONE);
+        sqlite3_reset(stmt);
+    }
+
+    void write_traces(const std::string& path, const Trace& trace) {
+        std::remove(path.c_str());
+        sqlite3* db = nullptr;
+        [[maybe_unused]] int rc = sqlite3_open(path.c_str(), &db);
+        assert(rc == SQLITE_OK);
+        exec(db,
+             "CREATE TABLE pktTxRx(timeSec DOUBLE NOT NULL, txRx TEXT NOT NULL, nodeId INTEGER NOT NULL,"
+             " imsi INTEGER NOT NULL, pktSizeBytes INTEGER NOT NULL, srcIp TEXT NOT NULL,"
+             " srcPort INTEGER NOT NULL, dstIp TEXT NOT NULL, dstPort INTEGER NOT NULL,"
+             " pktSeqNum INTEGER NOT NULL, SEED INTEGER NOT NULL, RUN INTEGER NOT NULL);"
+             "CREATE TABLE psschTxUeMac(c0, c1, c2, c3, c4, frame, subFrame, slot, symStart, symLen,"
+             " c10, rbStart, rbLen, SEED, RUN);"
+             "CREATE TABLE psschRxUePhy(c0, c1, c2, c3, c4, c5, c6, c7, c8, c9, c10, c11, c12, c13,"
+             " c14, c15, c16, c17, c18, c19, c20, psschCorrupt, c22, sci2Corrupt, SEED, RUN);");
+        const int seed = ns3::RngSeedManager::GetSeed();
+        const int64_t run = ns3::RngSeedManager::GetRun();
+        exec(db, "BEGIN");
+
+        sqlite3_stmt* stmt = prepare(db, "INSERT INTO pktTxRx VALUES(?, ?, ?, ?, ?, ?, 8000, ?, 8000, ?, ?, ?)");
+        for (const auto& row : trace.pkts) {
+            const std::string srcIp = node_ip(row.txNode);
+            const std::string dstIp = row.tx ? "225.0.0.0" : node_ip(row.node);
+            sqlite3_bind_double(stmt, 1, row.time);
+            sqlite3_bind_text(stmt, 2, row.tx ? "tx" : "rx", -1, SQLITE_STATIC);
+            sqlite3_bind_int(stmt, 3, row.node);
+            sqlite3_bind_int(stmt, 4, row.node + 1);
+            sqlite3_bind_int(stmt, 5, row.size);
+            sqlite3_bind_text(stmt, 6, srcIp.c_str(), -1, SQLITE_TRANSIENT);
+            sqlite3_bind_text(stmt, 7, dstIp.c_str(), -1, SQLITE_TRANSIENT);
+            sqlite3_bind_int64(stmt, 8, row.seq);
+            sqlite3_bind_int(stmt, 9, seed);
+            sqlite3_bind_int64(stmt, 10, run);
+            step(stmt);
+        }
+        sqlite3_finalize(stmt);
+
+        stmt = prepare(db, "INSERT INTO psschTxUeMac VALUES(0, 0, 0, 0, 0, ?, ?, ?, ?, ?, 0, ?, ?, ?, ?)");
+        for (const auto& alloc : trace.psschTx) {
+            const int values[] = {static_cast<int>(alloc.frame), static_cast<int>(alloc.subFrame),
+                                  alloc.slot, alloc.symStart, alloc.symLen, alloc.rbStart, alloc.rbLen};
+            for (int c = 0; c < 7; ++c) sqlite3_bind_int(stmt, c + 1, values[c]);
+            sqlite3_bind_int(stmt, 8, seed);
+            sqlite3_bind_int64(stmt, 9, run);
+            step(stmt);
+        }
+        sqlite3_finalize(stmt);
+
+        stmt = prepare(db, "INSERT INTO psschRxUePhy(psschCorrupt, sci2Corrupt, SEED, RUN) VALUES(?, ?, ?, ?)");
+        for (const auto& [psschCorrupt, sci2Corrupt] : trace.psschRx) {
+            sqlite3_bind_int(stmt, 1, psschCorrupt);
+            sqlite3_bind_int(stmt, 2, sci2Corrupt);
+            sqlite3_bind_int(stmt, 3, seed);
+            sqlite3_bind_int64(stmt, 4, run);
+            step(stmt);
+        }
+        sqlite3_finalize(stmt);
+
+        exec(db, "COMMIT");
+        sqlite3_close(db);
+    }
+
+    // The trace events in the order the trace sinks see them
+    void feed(OnlineKpiEngine& engine, const Trace& trace) {
+        for (const auto& row : trace.pkts) {
+            if (row.tx) {
+                engine.NotifyPktTx(row.node, row.node + 1, node_ip(row.node), row.seq);
+            } else {
+                engine.NotifyPktRx(row.time, row.node, row.node + 1, node_ip(row.node), node_ip(row.txNode),
+                                   row.size, row.seq);
+            }
+        }
+        for (const auto& alloc : trace.psschTx) engine.NotifyPsschTx(alloc);
+        for (const auto& [psschCorrupt, sci2Corrupt] : trace.psschRx) engine.NotifyPsschRx(psschCorrupt, sci2Corrupt);
+    }
+
+    // All the rows of table, in rowid order, one string per row
+    std::vector<std::string> dump(const std::string& path, const char* table) {
+        sqlite3* db = nullptr;
+        [[maybe_unused]] int rc = sqlite3_open(path.c_str(), &db);
+        assert(rc == SQLITE_OK);
+        std::string sql = std::string("SELECT * FROM ") + table + " ORDER BY rowid";
+        sqlite3_stmt* stmt = prepare(db, sql.c_str());
+        std::vector<std::string> rows;
+        while (sqlite3_step(stmt) == SQLITE_ROW) {
+            std::string row;
+            for (int c = 0; c < sqlite3_column_count(stmt); ++c) {
+                const unsigned char* text = sqlite3_column_text(stmt, c);
+                row += text ? reinterpret_cast<const char*>(text) : "NULL";
+                row += '|';
+            }
+            rows.push_back(row);
+        }
+        sqlite3_finalize(stmt);
+        sqlite3_close(db);
+        return rows;
+    }
+
+    // Writes the traces of scenario to base.db and the KPIs computed from
+    // them, or from engine if given, on the given number of threads.
+    // Returns the path of the DB.
+    std::string write_kpis(const std::string& base, const Scenario& scenario, uint32_t threads,
+                           const OnlineKpiEngine* engine = nullptr) {
+        write_traces(base + ".db", scenario.trace);
+        ns3::V2xKpi kpi;
+        kpi.SetDbPath(base);
+        kpi.SetTxAppDuration(scenario.duration);
+        kpi.SetRangeForV2xKpis(scenario.range);
+        kpi.SetDbReadOnlyReaders(true);
+        kpi.SetKpiThreads(threads);
+        for (std::size_t node = 0; node < scenario.positions.size(); ++node) {
+            kpi.FillPosPerIpMap(node_ip(node), scenario.positions[node]);
+        }
+        for (const auto& sample : scenario.samples) {
+            kpi.AddPositionSample(node_ip(sample.node), sample.time, sample.pos);
+        }
+        if (engine) {
+            kpi.WriteKpis(*engine);
+        } else {
+            kpi.WriteKpis();
+        }
+        return base + ".db";
+    }
+
+    // The values of one column of a query, as doubles
+    std::vector<double> query_doubles(const std::string& path, const std::string& sql) {
+        sqlite3* db = nullptr;
+        [[maybe_unused]] int rc = sqlite3_open(path.c_str(), &db);
+        assert(rc == SQLITE_OK);
+        sqlite3_stmt* stmt = prepare(db, sql.c_str());
+        std::vector<double> values;
+        while (sqlite3_step(stmt) == SQLITE_ROW) values.push_back(sqlite3_column_double(stmt, 0));
+        sqlite3_finalize(stmt);
+        sqlite3_close(db);
+        return values;
+    }
+
+    [[maybe_unused]] bool near(const std::vector<double>& values, const std::vector<double>& expected) {
+        if (values.size() != expected.size()) return false;
+        for (std::size_t i = 0; i < values.size(); ++i) {
+            if (std::abs(values[i] - expected[i]) > 1e-9) return false;
+        }
+        return true;
+    }
+
+    // Nodes that drift along both axes, sampled every 0.5 s
+    void add_drift(Scenario& scenario) {
+        for (int k = 0; k * 0.5 <= scenario.duration; ++k) {
+            for (std::size_t node = 0; node < scenario.positions.size(); ++node) {
+                const ns3::Vector& start = scenario.positions[node];
+                const double drift = (node % 2 ? 1.0 : -1.0) * 4.0 * k;
+                scenario.samples.push_back({0.5 * k, static_cast<int>(node),
+                                            ns3::Vector(start.x + drift, start.y + 0.5 * drift * (node % 3), 0.0)});
+            }
+        }
+    }
+
+    // avrgPrr rows of a DB, without SEED and RUN
+    std::vector<std::string> prr_rows(const std::string& path) {
+        std::vector<std::string> rows = dump(path, "avrgPrr");
+        for (auto& row : rows) row.erase(row.rfind('|', row.rfind('|', row.size() - 2) - 1) + 1);
+        return rows;
+    }
+
+    // Four nodes on a line, with a range of 50 m:
+    // - node 0 at 0 m sends seqs 0-3 and receives seq 11 of node 1;
+    // - node 1 at 10 m sends seqs 10 and 11 and receives seqs 0-2 of node
+    //   0, seq 1 twice;
+    // - node 2 at 30 m, in range of both, only receives seq 10 of node 1,
+    //   so it heard nothing of node 0;
+    // - node 3 at 100 m, out of range of both, receives all of node 0.
+    Scenario prr_scenario(uint16_t range) {
+        Scenario scenario;
+        auto& pkts = scenario.trace.pkts;
+        for (uint32_t seq = 0; seq < 4; ++seq) {
+            const double time = 0.1 * seq;
+            pkts.push_back({time, true, 0, 0, 200, seq});
+            if (seq < 3) pkts.push_back({time + 0.001, false, 1, 0, 200, seq});
+            if (seq == 1) pkts.push_back({time + 0.002, false, 1, 0, 200, seq});
+            pkts.push_back({time + 0.003, false, 3, 0, 200, seq});
+        }
+        pkts.push_back({0.05, true, 1, 1, 200, 10});
+        pkts.push_back({0.051, false, 2, 1, 200, 10});
+        pkts.push_back({0.15, true, 1, 1, 200, 11});
+        pkts.push_back({0.151, false, 0, 1, 200, 11});
+        scenario.positions = {{0, 0, 0}, {10, 0, 0}, {30, 0, 0}, {100, 0, 0}};
+        scenario.range = range;
+        scenario.duration = 0.4;
+        return scenario;
+    }
+
+    // Node 0 sends seq k at k + 0.5 s, for k = 0..7, while moving along X;
+    // its position is sampled every second at k s. The receivers, with a
+    // range of 50 m, are only sampled at 0 s and keep that position:
+    // - node 1 at (0, 0) has node 0 in range but for k = 2..4, and gets
+    //   packets 0, 1, 3 (out of range), 5 and 7;
+    // - node 2 at (0, 45) has it in range for k = 0, 1 and 7 and gets
+    //   those packets;
+    // - node 3 at (90, 0) has it in range for k = 2, 3, 4 and 6 and gets
+    //   packets 2-4.
+    const double MOBILE_X[] = {10, 20, 100, 100, 100, 30, 40, 20};
+
+    Scenario mobile_scenario() {
+        Scenario scenario;
+        scenario.positions = {{10, 0, 0}, {0, 0, 0}, {0, 45, 0}, {90, 0, 0}};
+        for (int node = 0; node < 4; ++node) scenario.samples.push_back({0.0, node, scenario.positions[node]});
+        for (int k = 1; k < 8; ++k) scenario.samples.push_back({1.0 * k, 0, ns3::Vector(MOBILE_X[k], 0, 0)});
+
+        const std::vector<std::vector<uint32_t>> received = {{0, 1, 3, 5, 7}, {0, 1, 7}, {2, 3, 4}};
+        auto& pkts = scenario.trace.pkts;
+        for (uint32_t k = 0; k < 8; ++k) {
+            pkts.push_back({k + 0.5, true, 0, 0, 200, k});
+            for (int rx = 1; rx < 4; ++rx) {
+                const auto& seqs = received[rx - 1];
+                if (std::find(seqs.begin(), seqs.end(), k) != seqs.end()) {
+                    pkts.push_back({k + 0.5 + 0.001 * rx, false, rx, 0, 200, k});
+                }
+            }
+        }
+        scenario.range = 50;
+        scenario.duration = 8.0;
+        return scenario;
+    }
+
+} // namespace
+
+int main() {
+    // A node count that is not a multiple of the thread counts below
+    const Scenario scenario = random_scenario(11, 30);
+    const std::string serial = write_kpis("v2x_kpi_test_serial", scenario, 1);
+    for (const char* table : KPI_TABLES) {
+        std::vector<std::string> rows = dump(serial, table);
+        assert(!rows.empty());
+    }
+
+    for (uint32_t threads : {2u, 3u, 4u, 16u}) {
+        const std::string sliced = write_kpis("v2x_kpi_test_" + std::to_string(threads), scenario, threads);
+        for (const char* table : KPI_TABLES) {
+            std::vector<std::string> rows = dump(sliced, table);
+            assert(rows == dump(serial, table));
+        }
+        std::remove(sliced.c_str());
+        std::cout << threads << " threads match the serial KPIs.\n";
+    }
+
+    OnlineKpiEngine engine;
+    feed(engine, scenario.trace);
+    const std::string online = write_kpis("v2x_kpi_test_online", scenario, 1, &engine);
+    for (const char* table : KPI_TABLES) {
+        std::vector<std::string> rows = dump(online, table);
+        assert(rows == dump(serial, table));
+    }
+    std::remove(online.c_str());
+    std::cout << "Online KPIs match the ones of the trace tables.\n";
+
+    // The same with position samples, which take the sliced KPIs through
+    // the per-slice RX nodes of the mobility-aware PRR
+    Scenario drifting = scenario;
+    add_drift(drifting);
+    const std::string drifted = write_kpis("v2x_kpi_test_drift_1", drifting, 1);
+    for (const char* table : {"avrgPir", "avrgPrr"}) {
+        std::vector<std::string> rows = dump(drifted, table);
+        assert(!rows.empty());
+        assert(rows != dump(serial, table)); // the samples do change them
+    }
+    for (uint32_t threads : {2u, 3u, 4u}) {
+        const std::string sliced = write_kpis("v2x_kpi_test_drift_" + std::to_string(threads), drifting, threads);
+        for (const char* table : KPI_TABLES) {
+            std::vector<std::string> rows = dump(sliced, table);
+            assert(rows == dump(drifted, table));
+        }
+        std::remove(sliced.c_str());
+    }
+    std::remove(drifted.c_str());
+    std::cout << "Threads match the serial KPIs with position samples.\n";
+
+    std::remove(serial.c_str());
+
+    // PRR by hand. The neighbours of a transmitter are the receiving nodes
+    // in range, including one that heard nothing of it and the transmitter
+    // itself when it receives from others; a packet received twice counts
+    // once. Node 0: node 1 got 3 of 4 packets, nodes 0 and 2 none, so
+    // 3 / (4 * 3). Node 1: nodes 2 and 0 got one of 2 each, so 2 / (2 * 3).
+    const std::vector<std::string> expected = {"tx|0|1|10.0.0.1|50.0|3|0.25|",
+                                               "tx|1|2|10.0.0.2|50.0|3|0.333333333333333|"};
+    for (uint32_t threads : {1u, 3u}) {
+        const std::string path = write_kpis("v2x_kpi_test_prr", prr_scenario(50), threads);
+        std::vector<std::string> rows = prr_rows(path);
+        assert(rows == expected);
+        std::remove(path.c_str());
+    }
+    OnlineKpiEngine prrEngine;
+    feed(prrEngine, prr_scenario(50).trace);
+    const std::string onlinePrr = write_kpis("v2x_kpi_test_prr", prr_scenario(50), 1, &prrEngine);
+    std::vector<std::string> onlineRows = prr_rows(onlinePrr);
+    assert(onlineRows == expected);
+    std::remove(onlinePrr.c_str());
+    // Without range every receiving node is a neighbour, node 3 included:
+    // (3 + 4) / (4 * 4) and 2 / (2 * 4)
+    const std::string unranged = write_kpis("v2x_kpi_test_prr", prr_scenario(0), 1);
+    std::vector<std::string> rows = prr_rows(unranged);
+    assert((rows == std::vector<std::string>{"tx|0|1|10.0.0.1|0.0|4|0.4375|", "tx|1|2|10.0.0.2|0.0|4|0.25|"}));
+    std::remove(unranged.c_str());
+    std::cout << "PRR of hand-computed traces passed.\n";
+
+    // Range based KPIs with position samples. PIR only counts the intervals
+    // between two packets received in range: node 1 has (0, 1) and (5, 7),
+    // so 3 / 2 instead of the 7 / 4 of all its intervals, and the distance
+    // is the average over packets 0, 1, 5 and 7. PRR counts each packet for
+    // the receivers in range at its time: 2, 2, 1, 1, 1, 1, 2 and 2
+    // neighbours for packets 0-7, i.e., 12 / 8 = 1.5 per packet, rounded
+    // to 2, which received 10 of the 12.
+    for (uint32_t threads : {1u, 3u}) {
+        const std::string path = write_kpis("v2x_kpi_test_mobile", mobile_scenario(), threads);
+        std::vector<double> pir = query_doubles(path, "SELECT avrgPirSec FROM avrgPir ORDER BY nodeId");
+        assert(near(pir, {1.5, 3.5, 1.0}));
+        [[maybe_unused]] const double node2 = (std::hypot(10, 45) + 2 * std::hypot(20, 45)) / 3;
+        std::vector<double> distance = query_doubles(path, "SELECT TxRxDistance FROM avrgPir ORDER BY nodeId");
+        assert(near(distance, {(10 + 20 + 30 + 20) / 4.0, node2, 10.0}));
+        std::vector<double> numNieb = query_doubles(path, "SELECT numNieb FROM avrgPrr");
+        assert(near(numNieb, {2.0}));
+        std::vector<double> prr = query_doubles(path, "SELECT avrgPrr FROM avrgPrr");
+        assert(near(prr, {10.0 / 12.0}));
+        std::remove(path.c_str());
+    }
+    Scenario initial = mobile_scenario();
+    initial.samples.clear();
+    const std::string initialPath = write_kpis("v2x_kpi_test_mobile", initial, 1);
+    std::vector<double> initialPir = query_doubles(initialPath, "SELECT avrgPirSec FROM avrgPir WHERE nodeId = 1");
+    assert(near(initialPir, {7.0 / 4.0}));
+    std::remove(initialPath.c_str());
+    std::cout << "Range based KPIs with position samples passed.\n";
+    return 0;
+}
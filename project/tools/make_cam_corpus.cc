@@ -0,0 +1,167 @@
+/*
+    Writes a CAM corpus file (see cam_corpus_file.h) for replay with
+    eris --camCorpus or crypto_bench --corpus.
+
+    Record r is a bundle of k CAMs, k drawn in [min-cams, max-cams], from
+    stations 0..k-1 at time step r of a deterministic corpus (see
+    deterministic_cam), so the same arguments always give the same file.
+    With --engine the ciphertext of every bundle is stored as well, under
+    keys derived from --key-seed (default: --seed, see engine_set_key_seed);
+    the seed goes in the header so replays can derive the same keys.
+
+    Usage:
+        make_cam_corpus --out FILE [--records 1000] [--min-cams 1]
+                        [--max-cams 10] [--seed 5489] [--format text|binary]
+                        [--engine none|aes|rsa|ecc|he] [--key-seed N]
+        make_cam_corpus --info FILE
+*/
+#include "../cam_corpus_file.h"
+#include "../cam_generation.h"
+#include "../crypto_engine.h"
+#include "../philox.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+namespace {
+
+    bool parse_uint(const char* text, uint64_t& out) {
+        char* end = nullptr;
+        unsigned long long v = std::strtoull(text, &end, 10);
+        if (!end || *end != '\0' || text[0] == '-') return false;
+        out = v;
+        return true;
+    }
+
+    bool parse_engine(const char* text, CryptoEngine& out) {
+        for (auto e : {CryptoEngine::None, CryptoEngine::Aes, CryptoEngine::Rsa,
+                       CryptoEngine::Ecc, CryptoEngine::He}) {
+            if (std::strcmp(text, engine_name(e)) == 0) {
+                out = e;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    int print_info(const std::string& path) {
+        CamCorpusFile corpus;
+        if (!corpus.open(path)) {
+            std::fprintf(stderr, "Error: %s\n", corpus.error().c_str());
+            return 1;
+        }
+        uint64_t plain = 0, wire = 0;
+        for (std::size_t i = 0; i < corpus.size(); ++i) {
+            plain += corpus[i].plain.size();
+            wire += corpus[i].wire.size();
+        }
+        std::printf("records: %zu\nformat: %s\nengine: %s\nkey seed: %llu\nplain bytes: %llu\n"
+                    "wire bytes: %llu\n",
+                    corpus.size(), corpus.info().binary_cams ? "binary" : "text",
+                    engine_name(corpus.info().engine),
+                    static_cast<unsigned long long>(corpus.info().key_seed),
+                    static_cast<unsigned long long>(plain), static_cast<unsigned long long>(wire));
+        return 0;
+    }
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    std::string out;
+    uint64_t records = 1000, min_cams = 1, max_cams = 10, seed = 5489u;
+    bool key_seed_set = false;
+    CamCorpusInfo info;
+
+    for (int i = 1; i < argc; ++i) {
+        const bool has_value = i + 1 < argc;
+        bool ok = true;
+        if (std::strcmp(argv[i], "--help") == 0) {
+            std::printf("Usage: %s --out FILE [--records 1000] [--min-cams 1] [--max-cams 10] "
+                        "[--seed 5489] [--format text|binary] [--engine none|aes|rsa|ecc|he] "
+                        "[--key-seed N]\n"
+                        "       %s --info FILE\n",
+                        argv[0], argv[0]);
+            return 0;
+        } else if (std::strcmp(argv[i], "--info") == 0 && has_value) {
+            return print_info(argv[++i]);
+        } else if (std::strcmp(argv[i], "--out") == 0 && has_value) {
+            out = argv[++i];
+        } else if (std::strcmp(argv[i], "--records") == 0 && has_value) {
+            ok = parse_uint(argv[++i], records);
+        } else if (std::strcmp(argv[i], "--min-cams") == 0 && has_value) {
+            ok = parse_uint(argv[++i], min_cams);
+        } else if (std::strcmp(argv[i], "--max-cams") == 0 && has_value) {
+            ok = parse_uint(argv[++i], max_cams);
+        } else if (std::strcmp(argv[i], "--seed") == 0 && has_value) {
+            ok = parse_uint(argv[++i], seed);
+        } else if (std::strcmp(argv[i], "--format") == 0 && has_value) {
+            ++i;
+            ok = std::strcmp(argv[i], "text") == 0 || std::strcmp(argv[i], "binary") == 0;
+            info.binary_cams = std::strcmp(argv[i], "binary") == 0;
+        } else if (std::strcmp(argv[i], "--engine") == 0 && has_value) {
+            ok = parse_engine(argv[++i], info.engine);
+        } else if (std::strcmp(argv[i], "--key-seed") == 0 && has_value) {
+            ok = parse_uint(argv[++i], info.key_seed);
+            key_seed_set = true;
+        } else {
+            ok = false;
+        }
+        if (!ok) {
+            std::fprintf(stderr, "Error: invalid argument %s (see --help)\n", argv[i]);
+            return 1;
+        }
+    }
+    if (out.empty() || min_cams == 0 || min_cams > max_cams || max_cams > UINT32_MAX ||
+        records > UINT32_MAX) {
+        std::fprintf(stderr, "Error: need --out and 0 < min-cams <= max-cams (see --help)\n");
+        return 1;
+    }
+
+    if (!key_seed_set) info.key_seed = seed;
+    if (info.engine != CryptoEngine::None && !engine_set_key_seed(info.key_seed)) {
+        std::fprintf(stderr, "Error: the engine keys were generated before the key seed was set\n");
+        return 1;
+    }
+
+    CamCorpusWriter writer;
+    if (!writer.open(out, info)) {
+        std::fprintf(stderr, "Error: can't write %s\n", out.c_str());
+        return 1;
+    }
+
+    const Philox4x32::Key key{static_cast<uint32_t>(seed), static_cast<uint32_t>(seed >> 32)};
+    std::vector<Cam> bundle;
+    std::string plain;
+    for (uint32_t r = 0; r < records; ++r) {
+        // Counter word 3 set to 1 keeps the bundle sizes apart from the CAM
+        // fields drawn by deterministic_cam.
+        const uint32_t draw = Philox4x32::generate({r, 0, 0, 1}, key)[0];
+        const uint64_t k = min_cams + (uint64_t{draw} * (max_cams - min_cams + 1) >> 32);
+
+        bundle.clear();
+        for (uint32_t s = 0; s < k; ++s) bundle.push_back(deterministic_cam(seed, s, r));
+        if (info.binary_cams) {
+            plain = encode_cams(bundle);
+        } else {
+            plain.clear();
+            for (const Cam& cam : bundle) plain += format_cam(cam);
+        }
+
+        std::string wire;
+        if (info.engine != CryptoEngine::None) {
+            wire = engine_encrypt(info.engine, plain);
+            if (engine_decrypt(info.engine, wire) != plain) {
+                std::fprintf(stderr, "Error: record %u does not decrypt back\n", r);
+                return 1;
+            }
+        }
+        if (!writer.append(plain, wire)) break;
+    }
+    if (!writer.close()) {
+        std::fprintf(stderr, "Error: writing %s failed\n", out.c_str());
+        return 1;
+    }
+    return print_info(out);
+}
@@ -6,53 +6,173 @@
 
 #include "v2x-kpi.h"
 
+#include "kpi-table-writer.h"
+#include "pssch-overlap-index.h"
+
 #include <algorithm>
+#include <cmath>
+#include <thread>
+#include <unordered_map>
 
 namespace ns3
 {
 
 NS_LOG_COMPONENT_DEFINE("V2xKpi");
 
+namespace
+{
+
+// Columns of the KPI tables written both from the trace tables and from
+// an OnlineKpiEngine, SEED and RUN excluded. See SaveAvrgPir and
+// SaveAvrgPrr for what TxRxDistance and numNieb hold with position samples.
+const std::vector<std::string> AVRG_PIR_COLUMNS = {"txRx TEXT NOT NULL",
+                                                   "nodeId INTEGER NOT NULL",
+                                                   "imsi INTEGER NOT NULL",
+                                                   "srcIp TEXT NOT NULL",
+                                                   "dstIp TEXT NOT NULL",
+                                                   "avrgPirSec DOUBLE NOT NULL",
+                                                   "TxRxDistance DOUBLE NOT NULL"};
+
+const std::vector<std::string> AVRG_PRR_COLUMNS = {"txRx TEXT NOT NULL",
+                                                   "nodeId INTEGER NOT NULL",
+                                                   "imsi INTEGER NOT NULL",
+                                                   "Ip TEXT NOT NULL",
+                                                   "range DOUBLE NOT NULL",
+                                                   "numNieb INTEGER NOT NULL",
+                                                   "avrgPrr DOUBLE NOT NULL"};
+
+const std::vector<std::string> THPUT_COLUMNS = {"txRx TEXT NOT NULL",
+                                                "nodeId INTEGER NOT NULL",
+                                                "imsi INTEGER NOT NULL",
+                                                "srcIp TEXT NOT NULL",
+                                                "totalPktTxed int NOT NULL",
+                                                "dstIp TEXT NOT NULL",
+                                                "totalPktRxed int NOT NULL",
+                                                "thputKbps DOUBLE NOT NULL"};
+
+// txRx column of the rows
+const std::string TX = "tx";
+const std::string RX = "rx";
+
+/**
+ * \brief Get a text column of a row without copying it
+ * \param stmt The statement stepped to the row
+ * \param col The column index
+ * \return The text, valid until the next step
+ */
+std::string_view
+ColumnText(sqlite3_stmt* stmt, int col)
+{
+    return std::string_view(reinterpret_cast<const char*>(sqlite3_column_text(stmt, col)),
+                            sqlite3_column_bytes(stmt, col));
+}
+
+/**
+ * \brief Run work(first, last, slice) over [0, total) split in contiguous
+ *        slices, one per thread
+ *
+ * The slices only depend on total and the number of threads, so callers
+ * get the same result as a serial loop by combining them in slice order.
+ *
+ * \param total The number of items
+ * \param threads The number of threads
+ * \param work The work on a slice of items
+ */
+template <typename Work>
+void
+ForSlices(std::size_t total, uint32_t threads, Work work)
+{
+    threads = static_cast<uint32_t>(std::min<std::size_t>(threads, std::max<std::size_t>(total, 1)));
+    std::vector<std::thread> workers;
+    const std::size_t per = total / threads;
+    const std::size_t extra = total % threads;
+    std::size_t first = 0;
+    for (uint32_t t = 0; t < threads; ++t)
+    {
+        std::size_t last = first + per + (t < extra ? 1 : 0);
+        workers.emplace_back(work, first, last, t);
+        first = last;
+    }
+    for (auto& worker : workers)
+    {
+        worker.join();
+    }
+}
+
+/**
+ * \brief Join the rows of the slices in slice order
+ * \param slices The rows of each slice
+ * \return All the rows
+ */
+template <typename Row>
+std::vector<Row>
+Concat(std::vector<std::vector<Row>>&& slices)
+{
+    std::vector<Row> rows;
+    for (auto& slice : slices)
+    {
+        rows.insert(rows.end(), slice.begin(), slice.end());
+    }
+    return rows;
+}
+
+} // namespace
+
 V2xKpi::V2xKpi()
 {
 }
 
 V2xKpi::~V2xKpi()
 {
-    sqlite3_close(m_db);
-    m_db = nullptr;
 }
 
 void
-V2xKpi::DeleteWhere(uint32_t seed, uint32_t run, const std::string& table)
+V2xKpi::SetDbPath(std::string dbPath)
 {
-    int rc;
-    sqlite3_stmt* stmt;
-    std::string cmd = "DELETE FROM \"" + table + "\" WHERE SEED = ? AND RUN = ?;";
-    rc = sqlite3_prepare_v2(m_db, cmd.c_str(), static_cast<int>(cmd.size()), &stmt, nullptr);
-    NS_ABORT_MSG_UNLESS(
-        rc == SQLITE_OK,
-        "Could not prepare correctly the delete statement. Db error: " << sqlite3_errmsg(m_db));
+    m_dbPath = dbPath + ".db";
+    m_connections.SetPath(m_dbPath);
+}
 
-    NS_ABORT_UNLESS(sqlite3_bind_int(stmt, 1, seed) == SQLITE_OK);
-    NS_ABORT_UNLESS(sqlite3_bind_int(stmt, 2, run) == SQLITE_OK);
+void
+V2xKpi::SetDbWal(bool wal)
+{
+    m_connections.SetWal(wal);
+}
 
-    rc = sqlite3_step(stmt);
+void
+V2xKpi::SetDbMmapSize(uint64_t bytes)
+{
+    m_connections.SetMmapSize(bytes);
+}
 
-    NS_ABORT_MSG_UNLESS(
-        rc == SQLITE_OK || rc == SQLITE_DONE,
-        "Could not correctly execute the statement. Db error: " << sqlite3_errmsg(m_db));
+void
+V2xKpi::SetDbCacheSize(uint64_t kib)
+{
+    m_connections.SetCacheSize(kib);
+}
 
-    rc = sqlite3_finalize(stmt);
-    NS_ABORT_MSG_UNLESS(
-        rc == SQLITE_OK || rc == SQLITE_DONE,
-        "Could not correctly execute the finalize statement. Db error: " << sqlite3_errmsg(m_db));
+void
+V2xKpi::SetDbTempStoreMemory(bool memory)
+{
+    m_connections.SetTempStoreMemory(memory);
 }
 
 void
-V2xKpi::SetDbPath(std::string dbPath)
+V2xKpi::SetDbSynchronous(std::string level)
 {
-    m_dbPath = dbPath + ".db";
+    m_connections.SetSynchronous(level);
+}
+
+void
+V2xKpi::SetDbReadOnlyReaders(bool readOnly)
+{
+    m_connections.SetReadOnlyReaders(readOnly);
+}
+
+void
+V2xKpi::OpenDb()
+{
+    m_db = m_connections.GetWriter();
 }
 
 void
@@ -64,8 +184,20 @@ V2xKpi::SetTxAppDuration(double duration)
 void
 V2xKpi::WriteKpis()
 {
+    OpenDb();
+    if (m_kpiThreads > 1)
+    {
+        if (m_connections.GetReader() != m_db)
+        {
+            WriteKpisParallel();
+            return;
+        }
+        NS_LOG_WARN("The KPIs are computed on one thread, parallel KPIs need read-only readers");
+    }
     SavePktTxData();
     SavePktRxData();
+    m_pkts.Index();
+    IndexNodes();
     SaveAvrgPir();
     SaveThput();
     ComputePsschTxStats();
@@ -73,6 +205,88 @@ V2xKpi::WriteKpis()
     SaveAvrgPrr();
 }
 
+void
+V2xKpi::WriteKpisParallel()
+{
+    // Each worker scans through its own read-only connection, opened here
+    // since KpiDbConnections is not thread safe.
+    uint32_t threads = std::min<uint32_t>(m_kpiThreads, 4);
+    for (uint32_t t = 0; t < threads; ++t)
+    {
+        m_connections.GetReader(t);
+    }
+
+    // The four trace scans are independent of each other.
+    PsschOverlapIndex psschTx;
+    uint32_t totalTbRx = 0;
+    uint32_t psschSuccessCount = 0;
+    uint32_t sci2SuccessCount = 0;
+    ForSlices(4, threads, [&](std::size_t first, std::size_t last, uint32_t slice) {
+        for (std::size_t task = first; task < last; ++task)
+        {
+            switch (task)
+            {
+            case 0:
+                SavePktRxData(slice);
+                break;
+            case 1:
+                SavePktTxData(slice);
+                break;
+            case 2:
+                ScanPsschTx(slice, psschTx);
+                break;
+            default:
+                ScanPsschTbRx(slice, totalTbRx, psschSuccessCount, sci2SuccessCount);
+                break;
+            }
+        }
+    });
+
+    m_pkts.Index();
+    IndexNodes();
+
+    // PIR, throughput and the PRR index are computed per RX node, the PRR
+    // per TX node; each slice fills its own rows, which are then written
+    // in slice order, i.e., in the order of the serial path.
+    std::vector<std::vector<AvrgPirRow>> pirRows(m_kpiThreads);
+    std::vector<std::vector<ThputRow>> thputRows(m_kpiThreads);
+    std::vector<PrrRxNode> prrRxNodes(m_pkts.GetRxNodes().size());
+    ForSlices(m_pkts.GetRxNodes().size(),
+              m_kpiThreads,
+              [&](std::size_t first, std::size_t last, uint32_t slice) {
+                  ComputeAvrgPirRows(first, last, pirRows[slice]);
+                  ComputeThputRows(first, last, thputRows[slice]);
+                  IndexPrrRxNodes(first, last, prrRxNodes);
+              });
+    std::vector<std::vector<AvrgPrrRow>> prrRows(m_kpiThreads);
+    ForSlices(m_pkts.GetTxNodes().size(),
+              m_kpiThreads,
+              [&](std::size_t first, std::size_t last, uint32_t slice) {
+                  ComputeAvrgPrrRows(prrRxNodes, first, last, prrRows[slice]);
+              });
+
+    // The writer connection is only used from this thread.
+    WriteAvrgPirRows(Concat(std::move(pirRows)));
+    WriteThputRows(Concat(std::move(thputRows)));
+    SaveSimultPsschTxStats(psschTx.GetTotal(),
+                           psschTx.GetNonOverlapping(),
+                           psschTx.GetOverlapping());
+    SavePsschTbCorruptionStats(totalTbRx, psschSuccessCount, sci2SuccessCount);
+    WriteAvrgPrrRows(Concat(std::move(prrRows)));
+}
+
+void
+V2xKpi::SetKpiThreads(uint32_t threads)
+{
+    m_kpiThreads = threads;
+}
+
+void
+V2xKpi::SetKpiBatchSize(uint32_t batchSize)
+{
+    m_kpiBatchSize = batchSize;
+}
+
 void
 V2xKpi::ConsiderAllTx(bool allTx)
 {
@@ -88,122 +302,95 @@ V2xKpi::SetRangeForV2xKpis(uint16_t range)
 void
 V2xKpi::FillPosPerIpMap(std::string ip, Vector pos)
 {
-    bool insertStatus = m_posPerIp.insert(std::make_pair(ip, pos)).second;
-    NS_ABORT_MSG_IF(insertStatus == false,
-                    "Insert Error: Pos of the ip " << ip << " already exist in the map");
+    m_nodes.Add(ip, pos);
+}
+
+void
+V2xKpi::AddPositionSample(const std::string& ip, double time, Vector pos)
+{
+    uint32_t node = m_nodes.Find(ip);
+    NS_ABORT_MSG_IF(node == KpiNodeRegistry::NONE,
+                    "Position sample of IP " << ip << " which has no initial position");
+    m_timeline.Add(time, node, pos);
 }
 
 void
-V2xKpi::SavePktRxData()
+V2xKpi::SavePktRxData(uint32_t reader)
 {
+    // The trace tables are scanned through the reader, which is the writer
+    // unless read-only connections are enabled.
+    sqlite3* db = m_connections.GetReader(reader);
     int rc;
-    rc = sqlite3_open(m_dbPath.c_str(), &m_db);
-    NS_ABORT_MSG_UNLESS(rc == SQLITE_OK, "Error open DB. Db error: " << sqlite3_errmsg(m_db));
 
     sqlite3_stmt* stmt;
     std::string sql(
         "SELECT * FROM pktTxRx WHERE txRx = 'rx' AND txRx IS NOT NULL AND SEED = ? AND RUN = ?;");
-    rc = sqlite3_prepare_v2(m_db, sql.c_str(), static_cast<int>(sql.size()), &stmt, nullptr);
-    NS_ABORT_MSG_UNLESS(rc == SQLITE_OK, "Error SELECT. Db error: " << sqlite3_errmsg(m_db));
+    rc = sqlite3_prepare_v2(db, sql.c_str(), static_cast<int>(sql.size()), &stmt, nullptr);
+    NS_ABORT_MSG_UNLESS(rc == SQLITE_OK, "Error SELECT. Db error: " << sqlite3_errmsg(db));
     NS_ABORT_UNLESS(sqlite3_bind_int(stmt, 1, RngSeedManager::GetSeed()) == SQLITE_OK);
     NS_ABORT_UNLESS(sqlite3_bind_int(stmt, 2, RngSeedManager::GetRun()) == SQLITE_OK);
 
     while ((rc = sqlite3_step(stmt)) == SQLITE_ROW)
     {
-        uint32_t nodeId = sqlite3_column_int(stmt, 2);
-        auto nodeIt = m_rxDataMap.find(nodeId);
-        if (nodeIt == m_rxDataMap.end())
-        {
-            // NS_LOG_UNCOND ("nodeId = " << nodeId << " not found creating new entry");
-            std::map<std::string, std::vector<PktTxRxData>> secondMap;
-            std::string srcIp =
-                std::string(reinterpret_cast<const char*>(sqlite3_column_text(stmt, 5)));
-            std::vector<PktTxRxData> data;
-            PktTxRxData result(
-                sqlite3_column_double(stmt, 0),
-                std::string(reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1))),
-                sqlite3_column_int(stmt, 2),
-                sqlite3_column_int(stmt, 3),
-                sqlite3_column_int(stmt, 4),
-                std::string(reinterpret_cast<const char*>(sqlite3_column_text(stmt, 7))),
-                sqlite3_column_int(stmt, 9));
-            data.push_back(result);
-            secondMap.insert(std::make_pair(srcIp, data));
-            m_rxDataMap.insert(std::make_pair(nodeId, secondMap));
-        }
-        else
-        {
-            // NS_LOG_UNCOND ("nodeId = " << nodeId << " found");
-            std::string srcIp =
-                std::string(reinterpret_cast<const char*>(sqlite3_column_text(stmt, 5)));
-            auto txIt = nodeIt->second.find(srcIp);
-            if (txIt == nodeIt->second.end())
-            {
-                // NS_LOG_UNCOND ("srcIp = " << srcIp << " not found creating new entry");
-                std::vector<PktTxRxData> data;
-                PktTxRxData result(
-                    sqlite3_column_double(stmt, 0),
-                    std::string(reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1))),
-                    sqlite3_column_int(stmt, 2),
-                    sqlite3_column_int(stmt, 3),
-                    sqlite3_column_int(stmt, 4),
-                    std::string(reinterpret_cast<const char*>(sqlite3_column_text(stmt, 7))),
-                    sqlite3_column_int(stmt, 9));
-                data.push_back(result);
-                nodeIt->second.insert(std::make_pair(srcIp, data));
-            }
-            else
-            {
-                // NS_LOG_UNCOND ("srcIp = " << srcIp << " found");
-                PktTxRxData result(
-                    sqlite3_column_double(stmt, 0),
-                    std::string(reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1))),
-                    sqlite3_column_int(stmt, 2),
-                    sqlite3_column_int(stmt, 3),
-                    sqlite3_column_int(stmt, 4),
-                    std::string(reinterpret_cast<const char*>(sqlite3_column_text(stmt, 7))),
-                    sqlite3_column_int(stmt, 9));
-                txIt->second.push_back(result);
-            }
-        }
+        // srcIp is the IP of the transmitter, dstIp the one of this receiver
+        uint32_t txIp = m_pkts.InternIp(ColumnText(stmt, 5));
+        uint32_t rxIp = m_pkts.InternIp(ColumnText(stmt, 7));
+        m_pkts.AddRx(sqlite3_column_double(stmt, 0),
+                     sqlite3_column_int(stmt, 2),
+                     sqlite3_column_int(stmt, 3),
+                     sqlite3_column_int(stmt, 4),
+                     rxIp,
+                     txIp,
+                     sqlite3_column_int(stmt, 9));
     }
 
-    NS_ABORT_MSG_UNLESS(rc == SQLITE_DONE, "Error not DONE. Db error: " << sqlite3_errmsg(m_db));
+    NS_ABORT_MSG_UNLESS(rc == SQLITE_DONE, "Error not DONE. Db error: " << sqlite3_errmsg(db));
 
     rc = sqlite3_finalize(stmt);
     NS_ABORT_MSG_UNLESS(
         rc == SQLITE_OK || rc == SQLITE_DONE,
-        "Could not correctly finalize the statement. Db error: " << sqlite3_errmsg(m_db));
+        "Could not correctly finalize the statement. Db error: " << sqlite3_errmsg(db));
 }
 
 void
 V2xKpi::SaveAvrgPir()
 {
-    std::string tableName = "avrgPir";
-    std::string cmd = ("CREATE TABLE IF NOT EXISTS " + tableName +
-                       " ("
-                       "txRx TEXT NOT NULL,"
-                       "nodeId INTEGER NOT NULL,"
-                       "imsi INTEGER NOT NULL,"
-                       "srcIp TEXT NOT NULL,"
-                       "dstIp TEXT NOT NULL,"
-                       "avrgPirSec DOUBLE NOT NULL,"
-                       "TxRxDistance DOUBLE NOT NULL,"
-                       "SEED INTEGER NOT NULL,"
-                       "RUN INTEGER NOT NULL"
-                       ");");
-    int rc = sqlite3_exec(m_db, cmd.c_str(), nullptr, nullptr, nullptr);
-
-    NS_ABORT_MSG_UNLESS(rc == SQLITE_OK,
-                        "Error creating table. Db error: " << sqlite3_errmsg(m_db));
-
-    DeleteWhere(RngSeedManager::GetSeed(), RngSeedManager::GetRun(), tableName);
-
-    for (const auto& it : m_rxDataMap)
-    {
-        for (const auto& it2 : it.second)
+    std::vector<AvrgPirRow> rows;
+    ComputeAvrgPirRows(0, m_pkts.GetRxNodes().size(), rows);
+    WriteAvrgPirRows(rows);
+}
+
+void
+V2xKpi::ComputeAvrgPirRows(std::size_t first,
+                           std::size_t last,
+                           std::vector<AvrgPirRow>& rows) const
+{
+    const auto& rxNodes = m_pkts.GetRxNodes();
+    const auto& links = m_pkts.GetLinks();
+    for (std::size_t i = first; i < last; ++i)
+    {
+        for (std::size_t l = rxNodes[i].firstLink; l < rxNodes[i].lastLink; ++l)
         {
-            double avrgPir = ComputeAvrgPir(it2.first, it2.second);
+            const PktTraceStore::Link& link = links[l];
+            double distance = 0.0;
+            double avrgPir = 0.0;
+            if (IsMobilityAware())
+            {
+                avrgPir = ComputeAvrgPirInRange(link, distance);
+            }
+            else
+            {
+                if (m_range > 0)
+                {
+                    distance = CalculateDistance(m_nodes.GetPosition(m_nodeOfIp[link.rxIp]),
+                                                 m_nodes.GetPosition(m_nodeOfIp[link.txIp]));
+                    if (distance > m_range)
+                    {
+                        continue;
+                    }
+                }
+                avrgPir = ComputeAvrgPir(m_pkts.GetRxTimes(link));
+            }
             if (avrgPir == -1.0)
             {
                 // It may happen that a node would rxed only one pkt from a
@@ -212,79 +399,53 @@ V2xKpi::SaveAvrgPir()
                 continue;
             }
             // NS_LOG_UNCOND ("Avrg PIR " << avrgPir);
-            PktTxRxData data = it2.second.at(0);
-            sqlite3_stmt* stmt;
-            std::string cmd = "INSERT INTO " + tableName + " VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?);";
-            rc =
-                sqlite3_prepare_v2(m_db, cmd.c_str(), static_cast<int>(cmd.size()), &stmt, nullptr);
-            NS_ABORT_MSG_UNLESS(rc == SQLITE_OK,
-                                "Error INSERT. Db error: " << sqlite3_errmsg(m_db));
-
-            NS_ABORT_UNLESS(sqlite3_bind_text(stmt, 1, data.txRx.c_str(), -1, SQLITE_STATIC) ==
-                            SQLITE_OK);
-            NS_ABORT_UNLESS(sqlite3_bind_int(stmt, 2, data.nodeId) == SQLITE_OK);
-            NS_ABORT_UNLESS(sqlite3_bind_int(stmt, 3, data.imsi) == SQLITE_OK);
-            NS_ABORT_UNLESS(sqlite3_bind_text(stmt, 4, it2.first.c_str(), -1, SQLITE_STATIC) ==
-                            SQLITE_OK);
-            NS_ABORT_UNLESS(sqlite3_bind_text(stmt, 5, data.ipAddrs.c_str(), -1, SQLITE_STATIC) ==
-                            SQLITE_OK);
-            NS_ABORT_UNLESS(sqlite3_bind_double(stmt, 6, avrgPir) == SQLITE_OK);
-            NS_ABORT_UNLESS(sqlite3_bind_double(stmt, 7, m_interTxRxDistance) == SQLITE_OK);
-            m_interTxRxDistance = 0.0;
-            NS_ABORT_UNLESS(sqlite3_bind_int(stmt, 8, RngSeedManager::GetSeed()) == SQLITE_OK);
-            NS_ABORT_UNLESS(sqlite3_bind_int(stmt, 9, RngSeedManager::GetRun()) == SQLITE_OK);
-
-            rc = sqlite3_step(stmt);
-            NS_ABORT_MSG_UNLESS(
-                rc == SQLITE_OK || rc == SQLITE_DONE,
-                "Could not correctly execute the statement. Db error: " << sqlite3_errmsg(m_db));
-            rc = sqlite3_finalize(stmt);
-            NS_ABORT_MSG_UNLESS(
-                rc == SQLITE_OK || rc == SQLITE_DONE,
-                "Could not correctly finalize the statement. Db error: " << sqlite3_errmsg(m_db));
+            rows.push_back({&link, avrgPir, distance});
         }
     }
 }
 
+void
+V2xKpi::WriteAvrgPirRows(const std::vector<AvrgPirRow>& rows)
+{
+    KpiTableWriter writer(m_db,
+                          "avrgPir",
+                          AVRG_PIR_COLUMNS,
+                          RngSeedManager::GetSeed(),
+                          RngSeedManager::GetRun(),
+                          m_kpiBatchSize);
+
+    for (const auto& row : rows)
+    {
+        writer.BindText(RX)
+            .BindInt(row.link->rxNodeId)
+            .BindInt(row.link->rxImsi)
+            .BindText(m_pkts.GetIp(row.link->txIp))
+            .BindText(m_pkts.GetIp(row.link->rxIp))
+            .BindDouble(row.avrgPir)
+            .BindDouble(row.distance)
+            .EndRow();
+    }
+}
+
 double
-V2xKpi::ComputeAvrgPir(std::string ipTx, std::vector<PktTxRxData> data)
+V2xKpi::ComputeAvrgPir(std::span<const double> rxTimes) const
 {
     uint64_t pirCounter = 0;
     double lastPktRxTime = 0.0;
     double pir = 0.0;
 
-    // NS_LOG_UNCOND ("Packet Vector size " << data.size () << " to compute average PIR");
-    if (m_range > 0)
-    {
-        PktTxRxData dataIpRx = data.at(0);
-        auto itRxIpPos = m_posPerIp.find(dataIpRx.ipAddrs);
-        NS_ABORT_MSG_IF(itRxIpPos == m_posPerIp.end(),
-                        "Unable to find the position of RX IP " << dataIpRx.ipAddrs);
-        Vector rxIpPos = itRxIpPos->second;
-        auto itTxIpPos = m_posPerIp.find(ipTx);
-        NS_ABORT_MSG_IF(itTxIpPos == m_posPerIp.end(),
-                        "Unable to find the position of TX IP " << ipTx);
-        Vector txIpPos = itTxIpPos->second;
-        double distance = CalculateDistance(rxIpPos, txIpPos);
-        m_interTxRxDistance = distance;
-        if (distance > m_range)
-        {
-            return -1.0;
-        }
-    }
-
-    for (const auto& it : data)
+    for (double time : rxTimes)
     {
         if (pirCounter == 0 && lastPktRxTime == 0.0)
         {
             // this is the first packet, just store the time and get out
-            lastPktRxTime = it.time;
+            lastPktRxTime = time;
             continue;
         }
 
-        // NS_LOG_UNCOND ("it.time - lastPktRxTime " << it.time - lastPktRxTime);
-        pir = pir + (it.time - lastPktRxTime);
-        lastPktRxTime = it.time;
+        // NS_LOG_UNCOND ("time - lastPktRxTime " << time - lastPktRxTime);
+        pir = pir + (time - lastPktRxTime);
+        lastPktRxTime = time;
         pirCounter++;
     }
     double avrgPir = 0.0;
@@ -302,147 +463,201 @@ V2xKpi::ComputeAvrgPir(std::string ipTx, std::vector<PktTxRxData> data)
     return avrgPir;
 }
 
+double
+V2xKpi::ComputeAvrgPirInRange(const PktTraceStore::Link& link, double& distance) const
+{
+    // An interval counts if both of its packets were received with the
+    // transmitter in range, so that the time out of range is not taken for
+    // a reception gap.
+    uint32_t rxNode = m_nodeOfIp[link.rxIp];
+    uint32_t txNode = m_nodeOfIp[link.txIp];
+    uint64_t pirCounter = 0;
+    double pir = 0.0;
+    uint64_t inRangeCounter = 0;
+    double distanceSum = 0.0;
+    bool lastPktInRange = false;
+    double lastPktRxTime = 0.0;
+
+    for (double time : m_pkts.GetRxTimes(link))
+    {
+        uint32_t snapshot = m_timeline.FindSnapshot(time);
+        double txRxDist = CalculateDistance(GetSampledPosition(rxNode, snapshot),
+                                            GetSampledPosition(txNode, snapshot));
+        bool inRange = txRxDist <= m_range;
+        if (inRange)
+        {
+            inRangeCounter++;
+            distanceSum += txRxDist;
+            if (lastPktInRange)
+            {
+                pir = pir + (time - lastPktRxTime);
+                pirCounter++;
+            }
+        }
+        lastPktInRange = inRange;
+        lastPktRxTime = time;
+    }
+
+    if (pirCounter == 0)
+    {
+        return -1.0;
+    }
+    distance = distanceSum / inRangeCounter;
+    return pir / pirCounter;
+}
+
 void
 V2xKpi::SaveAvrgPrr()
 {
-    std::string tableName = "avrgPrr";
-    std::string cmd = ("CREATE TABLE IF NOT EXISTS " + tableName +
-                       " ("
-                       "txRx TEXT NOT NULL,"
-                       "nodeId INTEGER NOT NULL,"
-                       "imsi INTEGER NOT NULL,"
-                       "Ip TEXT NOT NULL,"
-                       "range DOUBLE NOT NULL,"
-                       "numNieb INTEGER NOT NULL,"
-                       "avrgPrr DOUBLE NOT NULL,"
-                       "SEED INTEGER NOT NULL,"
-                       "RUN INTEGER NOT NULL"
-                       ");");
-    int rc = sqlite3_exec(m_db, cmd.c_str(), nullptr, nullptr, nullptr);
-
-    NS_ABORT_MSG_UNLESS(rc == SQLITE_OK,
-                        "Error creating table. Db error: " << sqlite3_errmsg(m_db));
-
-    DeleteWhere(RngSeedManager::GetSeed(), RngSeedManager::GetRun(), tableName);
-
-    std::map<uint32_t, std::vector<PktTxRxData>>::const_iterator it;
-    for (it = m_txDataMap.cbegin(); it != m_txDataMap.cend(); it++)
+    std::vector<PrrRxNode> rxNodes(m_pkts.GetRxNodes().size());
+    IndexPrrRxNodes(0, rxNodes.size(), rxNodes);
+    std::vector<AvrgPrrRow> rows;
+    ComputeAvrgPrrRows(rxNodes, 0, m_pkts.GetTxNodes().size(), rows);
+    WriteAvrgPrrRows(rows);
+}
+
+void
+V2xKpi::IndexPrrRxNodes(std::size_t first, std::size_t last, std::vector<PrrRxNode>& rxNodes) const
+{
+    // Index the sequence numbers received per (TX IP, RX node), sorted and
+    // without duplicates, so that the packets of every transmitter are
+    // matched against each receiver by one merge instead of a search per
+    // packet.
+    const auto& links = m_pkts.GetLinks();
+    for (std::size_t i = first; i < last; ++i)
     {
-        uint32_t numNeib = 0;
-        double avrgPrr = ComputeAvrgPrr(it, numNeib);
-        if (avrgPrr == -1.0)
+        const PktTraceStore::RxNode& node = m_pkts.GetRxNodes()[i];
+        // we can read the RX IP from any link of the node
+        PrrRxNode& rxNode = rxNodes[i];
+        rxNode.node = m_nodeOfIp[links[node.firstLink].rxIp];
+        rxNode.pos = m_nodes.GetPosition(rxNode.node);
+        for (std::size_t l = node.firstLink; l < node.lastLink; ++l)
         {
-            continue;
+            std::span<const uint32_t> rxSeqs = m_pkts.GetRxSeqs(links[l]);
+            std::vector<uint32_t>& seqs = rxNode.seqsPerTxIp[links[l].txIp];
+            seqs.assign(rxSeqs.begin(), rxSeqs.end());
+            std::sort(seqs.begin(), seqs.end());
+            seqs.erase(std::unique(seqs.begin(), seqs.end()), seqs.end());
         }
-        sqlite3_stmt* stmt;
-        std::string cmd = "INSERT INTO " + tableName + " VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?);";
-        rc = sqlite3_prepare_v2(m_db, cmd.c_str(), static_cast<int>(cmd.size()), &stmt, nullptr);
-        NS_ABORT_MSG_UNLESS(rc == SQLITE_OK, "Error INSERT. Db error: " << sqlite3_errmsg(m_db));
-
-        NS_ABORT_UNLESS(
-            sqlite3_bind_text(stmt, 1, it->second.at(0).txRx.c_str(), -1, SQLITE_STATIC) ==
-            SQLITE_OK);
-        NS_ABORT_UNLESS(sqlite3_bind_int(stmt, 2, it->second.at(0).nodeId) == SQLITE_OK);
-        NS_ABORT_UNLESS(sqlite3_bind_int(stmt, 3, it->second.at(0).imsi) == SQLITE_OK);
-        NS_ABORT_UNLESS(
-            sqlite3_bind_text(stmt, 4, it->second.at(0).ipAddrs.c_str(), -1, SQLITE_STATIC) ==
-            SQLITE_OK);
-        NS_ABORT_UNLESS(sqlite3_bind_int(stmt, 5, m_range) == SQLITE_OK);
-        NS_ABORT_UNLESS(sqlite3_bind_int(stmt, 6, numNeib) == SQLITE_OK);
-        NS_ABORT_UNLESS(sqlite3_bind_double(stmt, 7, avrgPrr) == SQLITE_OK);
-        NS_ABORT_UNLESS(sqlite3_bind_int(stmt, 8, RngSeedManager::GetSeed()) == SQLITE_OK);
-        NS_ABORT_UNLESS(sqlite3_bind_int(stmt, 9, RngSeedManager::GetRun()) == SQLITE_OK);
-
-        rc = sqlite3_step(stmt);
-        NS_ABORT_MSG_UNLESS(
-            rc == SQLITE_OK || rc == SQLITE_DONE,
-            "Could not correctly execute the statement. Db error: " << sqlite3_errmsg(m_db));
-        rc = sqlite3_finalize(stmt);
-        NS_ABORT_MSG_UNLESS(
-            rc == SQLITE_OK || rc == SQLITE_DONE,
-            "Could not correctly finalize the statement. Db error: " << sqlite3_errmsg(m_db));
     }
 }
 
-double
-V2xKpi::ComputeAvrgPrr(std::map<uint32_t, std::vector<PktTxRxData>>::const_iterator& txIt,
-                       uint32_t& numNeib)
-{
-    std::string txIp = txIt->second.at(0).ipAddrs;
-    auto txIpPosIt = m_posPerIp.find(txIp);
-    Vector txIpPos = txIpPosIt->second;
-    // std::cout << "Tx IP " << txIp << " pos " << txIpPos << std::endl;
-
-    std::map<std::string, std::vector<uint32_t>> pktSeqPerRx;
-
-    for (const auto& it : m_rxDataMap)
-    {
-        // we can read the RX IP from any PktTxRxData of any TX
-        std::string rxIp = it.second.begin()->second.at(0).ipAddrs;
-        auto rxIpPosIt = m_posPerIp.find(rxIp);
-        Vector rxIpPos = rxIpPosIt->second;
-        double txRxDist = CalculateDistance(rxIpPos, txIpPos);
-        // go to the next RX IP if the current RX IP is out of range AND m_range is non-zero
-        // the condition m_range > 0.0 is to ignore range based PRR and consider
-        // all rx nodes as potential receivers.
-        if (txRxDist > m_range && m_range > 0.0)
+void
+V2xKpi::ComputeAvrgPrrRows(const std::vector<PrrRxNode>& rxNodes,
+                           std::size_t first,
+                           std::size_t last,
+                           std::vector<AvrgPrrRow>& rows) const
+{
+    if (IsMobilityAware())
+    {
+        std::vector<uint32_t> rxNodeOf(m_nodes.GetN(), KpiNodeRegistry::NONE);
+        for (uint32_t r = 0; r < rxNodes.size(); ++r)
         {
-            // std::cout << "Rx IP " << rxIp << " at " <<  rxIpPos << " is out of range" <<
-            // std::endl;
-            continue;
+            rxNodeOf[rxNodes[r].node] = r;
         }
-        else
+        for (std::size_t i = first; i < last; ++i)
         {
-            std::vector<uint32_t> seqVec;
-            // RX IP is in range. Lets find out if this RX IP rexed any pkt from
-            // Tx IP
-            auto txIt = it.second.find(txIp);
-            if (txIt == it.second.end())
+            const PktTraceStore::TxNode& txNode = m_pkts.GetTxNodes()[i];
+            uint32_t numNeib = 0;
+            double avrgPrr = ComputeAvrgPrrInRange(rxNodes, rxNodeOf, txNode, numNeib);
+            if (avrgPrr == -1.0)
             {
-                // if with in range Rx IP did not rxed any packet from Tx IP
-                // we still need to consider it as valid neighbor. Therefore,
-                // I am inserting it in the neighbor vector which received
-                // a bit unrealistic packet seq of 2^32
-                seqVec.push_back(std::numeric_limits<uint32_t>::max());
-                bool insertStatus = pktSeqPerRx.emplace(rxIp, seqVec).second;
-                NS_ASSERT_MSG(insertStatus == true,
-                              "Rx IP " << rxIp << " already present in pktSeqPerRx map");
-                // now continue to next RX IP
                 continue;
             }
-            for (const auto& pktVectIt : txIt->second)
+            rows.push_back({&txNode, numNeib, avrgPrr});
+        }
+        return;
+    }
+
+    const std::vector<uint32_t> noSeqs;
+    std::vector<uint32_t> txSeqs;
+    std::vector<const std::vector<uint32_t>*> rxSeqs;
+    for (std::size_t i = first; i < last; ++i)
+    {
+        const PktTraceStore::TxNode& txNode = m_pkts.GetTxNodes()[i];
+        Vector txPos = m_nodes.GetPosition(m_nodeOfIp[txNode.ip]);
+
+        std::span<const uint32_t> seqs = m_pkts.GetTxSeqs(txNode);
+        txSeqs.assign(seqs.begin(), seqs.end());
+        std::sort(txSeqs.begin(), txSeqs.end());
+
+        rxSeqs.clear();
+        for (const auto& rxNode : rxNodes)
+        {
+            // the condition m_range > 0.0 is to ignore range based PRR and
+            // consider all rx nodes as potential receivers.
+            if (CalculateDistance(rxNode.pos, txPos) > m_range && m_range > 0.0)
             {
-                // push all the pkt seq number this receiver received from the TX IP
-                seqVec.push_back(pktVectIt.pktSeq);
+                continue;
             }
-            bool insertStatus = pktSeqPerRx.emplace(rxIp, seqVec).second;
-            NS_ASSERT_MSG(insertStatus == true,
-                          "Rx IP " << rxIp << " already present in pktSeqPerRx map");
+            // an RX node in range is a neighbor even if it received nothing
+            // from this transmitter
+            auto seqsIt = rxNode.seqsPerTxIp.find(txNode.ip);
+            rxSeqs.push_back(seqsIt == rxNode.seqsPerTxIp.end() ? &noSeqs : &seqsIt->second);
         }
-    }
 
-    numNeib = pktSeqPerRx.size();
+        double avrgPrr = ComputeAvrgPrr(txSeqs, rxSeqs);
+        if (avrgPrr == -1.0)
+        {
+            continue;
+        }
+        rows.push_back({&txNode, static_cast<uint32_t>(rxSeqs.size()), avrgPrr});
+    }
+}
 
-    // std::cout << "IP " << txIp << " has " << pktSeqPerRx.size () << " neighbors" << std::endl;
-    // std::cout << "IP " << txIp << " has txed " << txIt->second.size ()<< " packets" << std::endl;
+void
+V2xKpi::WriteAvrgPrrRows(const std::vector<AvrgPrrRow>& rows)
+{
+    KpiTableWriter writer(m_db,
+                          "avrgPrr",
+                          AVRG_PRR_COLUMNS,
+                          RngSeedManager::GetSeed(),
+                          RngSeedManager::GetRun(),
+                          m_kpiBatchSize);
+
+    for (const auto& row : rows)
+    {
+        writer.BindText(TX)
+            .BindInt(row.tx->nodeId)
+            .BindInt(row.tx->imsi)
+            .BindText(m_pkts.GetIp(row.tx->ip))
+            .BindInt(m_range)
+            .BindInt(row.numNeib)
+            .BindDouble(row.avrgPrr)
+            .EndRow();
+    }
+}
 
+double
+V2xKpi::ComputeAvrgPrr(const std::vector<uint32_t>& txSeqs,
+                       const std::vector<const std::vector<uint32_t>*>& rxSeqs) const
+{
     // if none of the rx nodes is in range do not log such PRR
-    if (pktSeqPerRx.empty())
+    if (rxSeqs.empty())
     {
         return -1.0;
     }
 
-    double pktRxCount = 0;
-
-    for (const auto& itPktData : txIt->second)
+    // Each TX packet counts once for every neighbor that received it.
+    uint64_t pktRxCount = 0;
+    for (const auto* seqs : rxSeqs)
     {
-        // iterating over each pkt tx by the transmitter
-        for (const auto& itRx : pktSeqPerRx)
+        auto txIt = txSeqs.cbegin();
+        auto rxIt = seqs->cbegin();
+        while (txIt != txSeqs.cend() && rxIt != seqs->cend())
         {
-            if (std::find(itRx.second.begin(), itRx.second.end(), itPktData.pktSeq) !=
-                itRx.second.end())
+            if (*txIt < *rxIt)
             {
-                pktRxCount++;
+                ++txIt;
+            }
+            else if (*rxIt < *txIt)
+            {
+                ++rxIt;
+            }
+            else
+            {
+                ++pktRxCount;
+                ++txIt;
             }
         }
     }
@@ -453,317 +668,282 @@ V2xKpi::ComputeAvrgPrr(std::map<uint32_t, std::vector<PktTxRxData>>::const_itera
         return 0.0;
     }
 
-    double avrgPrr = pktRxCount / (txIt->second.size() * pktSeqPerRx.size());
+    return static_cast<double>(pktRxCount) / (txSeqs.size() * rxSeqs.size());
+}
 
-    // std::cout << "Tx IP " << txIp << " has average PRR of " << avrgPrr << std::endl;
+double
+V2xKpi::ComputeAvrgPrrInRange(const std::vector<PrrRxNode>& rxNodes,
+                              const std::vector<uint32_t>& rxNodeOf,
+                              const PktTraceStore::TxNode& txNode,
+                              uint32_t& numNeib) const
+{
+    // Each TX packet counts once for every RX node in range at its
+    // transmission time, which the grid of the snapshot finds without
+    // visiting the nodes out of range.
+    uint32_t tx = m_nodeOfIp[txNode.ip];
+    std::span<const double> txTimes = m_pkts.GetTxTimes(txNode);
+    std::span<const uint32_t> txSeqs = m_pkts.GetTxSeqs(txNode);
+    std::vector<uint32_t> neighbours;
+    uint64_t neibCount = 0;
+    uint64_t pktRxCount = 0;
+    for (std::size_t k = 0; k < txSeqs.size(); ++k)
+    {
+        uint32_t snapshot = m_timeline.FindSnapshot(txTimes[k]);
+        m_timeline.GetNeighbours(snapshot, GetSampledPosition(tx, snapshot), m_range, neighbours);
+        for (uint32_t node : neighbours)
+        {
+            uint32_t r = rxNodeOf[node];
+            if (r == KpiNodeRegistry::NONE)
+            {
+                continue;
+            }
+            neibCount++;
+            auto seqsIt = rxNodes[r].seqsPerTxIp.find(txNode.ip);
+            if (seqsIt != rxNodes[r].seqsPerTxIp.end() &&
+                std::binary_search(seqsIt->second.begin(), seqsIt->second.end(), txSeqs[k]))
+            {
+                pktRxCount++;
+            }
+        }
+    }
 
-    return avrgPrr;
+    // if none of the rx nodes was ever in range do not log such PRR
+    if (neibCount == 0)
+    {
+        return -1.0;
+    }
+    numNeib = static_cast<uint32_t>(std::lround(static_cast<double>(neibCount) / txSeqs.size()));
+    return static_cast<double>(pktRxCount) / neibCount;
 }
 
 void
 V2xKpi::SaveThput()
 {
-    std::string tableName = "thput";
-    std::string cmd = ("CREATE TABLE IF NOT EXISTS " + tableName +
-                       " ("
-                       "txRx TEXT NOT NULL,"
-                       "nodeId INTEGER NOT NULL,"
-                       "imsi INTEGER NOT NULL,"
-                       "srcIp TEXT NOT NULL,"
-                       "totalPktTxed int NOT NULL,"
-                       "dstIp TEXT NOT NULL,"
-                       "totalPktRxed int NOT NULL,"
-                       "thputKbps DOUBLE NOT NULL,"
-                       "SEED INTEGER NOT NULL,"
-                       "RUN INTEGER NOT NULL"
-                       ");");
-    int rc = sqlite3_exec(m_db, cmd.c_str(), nullptr, nullptr, nullptr);
-
-    NS_ABORT_MSG_UNLESS(rc == SQLITE_OK,
-                        "Error creating table. Db error: " << sqlite3_errmsg(m_db));
-
-    DeleteWhere(RngSeedManager::GetSeed(), RngSeedManager::GetRun(), tableName);
-
-    for (const auto& it : m_rxDataMap)
-    {
-        for (const auto& it2 : it.second)
+    std::vector<ThputRow> rows;
+    ComputeThputRows(0, m_pkts.GetRxNodes().size(), rows);
+    WriteThputRows(rows);
+}
+
+void
+V2xKpi::ComputeThputRows(std::size_t first, std::size_t last, std::vector<ThputRow>& rows) const
+{
+    const auto& links = m_pkts.GetLinks();
+    const auto& txNodes = m_pkts.GetTxNodes();
+    for (std::size_t i = first; i < last; ++i)
+    {
+        const PktTraceStore::RxNode& rxNode = m_pkts.GetRxNodes()[i];
+        for (std::size_t l = rxNode.firstLink; l < rxNode.lastLink; ++l)
         {
-            double thput = ComputeThput(it2.second);
+            const PktTraceStore::Link& link = links[l];
+            double thput = ComputeThput(m_pkts.GetRxSizes(link));
             // NS_LOG_UNCOND ("thput " << thput << " kbps");
-            PktTxRxData data = it2.second.at(0);
-            sqlite3_stmt* stmt;
-            std::string cmd =
-                "INSERT INTO " + tableName + " VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?);";
-            rc =
-                sqlite3_prepare_v2(m_db, cmd.c_str(), static_cast<int>(cmd.size()), &stmt, nullptr);
-            NS_ABORT_MSG_UNLESS(rc == SQLITE_OK,
-                                "Error INSERT. Db error: " << sqlite3_errmsg(m_db));
-
-            NS_ABORT_UNLESS(sqlite3_bind_text(stmt, 1, data.txRx.c_str(), -1, SQLITE_STATIC) ==
-                            SQLITE_OK);
-            NS_ABORT_UNLESS(sqlite3_bind_int(stmt, 2, data.nodeId) == SQLITE_OK);
-            NS_ABORT_UNLESS(sqlite3_bind_int(stmt, 3, data.imsi) == SQLITE_OK);
-            NS_ABORT_UNLESS(sqlite3_bind_text(stmt, 4, it2.first.c_str(), -1, SQLITE_STATIC) ==
-                            SQLITE_OK);
-            NS_ABORT_UNLESS(sqlite3_bind_int(stmt, 5, GetTotalTxPkts(it2.first)) == SQLITE_OK);
-            NS_ABORT_UNLESS(sqlite3_bind_text(stmt, 6, data.ipAddrs.c_str(), -1, SQLITE_STATIC) ==
-                            SQLITE_OK);
-            NS_ABORT_UNLESS(sqlite3_bind_int(stmt, 7, static_cast<uint64_t>(it2.second.size())) ==
-                            SQLITE_OK);
-            NS_ABORT_UNLESS(sqlite3_bind_double(stmt, 8, thput) == SQLITE_OK);
-            NS_ABORT_UNLESS(sqlite3_bind_int(stmt, 9, RngSeedManager::GetSeed()) == SQLITE_OK);
-            NS_ABORT_UNLESS(sqlite3_bind_int(stmt, 10, RngSeedManager::GetRun()) == SQLITE_OK);
-
-            rc = sqlite3_step(stmt);
-            NS_ABORT_MSG_UNLESS(
-                rc == SQLITE_OK || rc == SQLITE_DONE,
-                "Could not correctly execute the statement. Db error: " << sqlite3_errmsg(m_db));
-            rc = sqlite3_finalize(stmt);
-            NS_ABORT_MSG_UNLESS(
-                rc == SQLITE_OK || rc == SQLITE_DONE,
-                "Could not correctly finalize the statement. Db error: " << sqlite3_errmsg(m_db));
+            rows.push_back({&link,
+                            link.txIp,
+                            GetTotalTxPkts(link.txIp),
+                            link.last - link.first,
+                            thput});
         }
 
         // Now put zero thput for the transmitters nodes from
         // whom this RX node didn't receive any packet.
-        NS_LOG_DEBUG("m_considerAllTx flag value" << m_considerAllTx);
-        NS_LOG_DEBUG("Num of transmitters this receiver able to rxed data " << it.second.size());
-        NS_LOG_DEBUG("Total number of transmitters " << m_txDataMap.size());
-        // Lets read the first entry of our m_rxDataMap just to read some info of
-        // the RX node.
-        PktTxRxData data = it.second.begin()->second.at(0);
+        // Lets read the first link of the RX node just to read some info
+        // of the RX node.
+        const PktTraceStore::Link& data = links[rxNode.firstLink];
         uint32_t numTx = 0;
-        auto itToRxNode = m_txDataMap.find(data.nodeId);
-        if (itToRxNode != m_txDataMap.end())
+        if (m_pkts.FindTxNode(rxNode.nodeId) != nullptr)
         {
             // if this receiver is one of the transmitter, the number of
             // transmitters for which we need to compute thput is:
-            numTx = m_txDataMap.size() - 1;
+            numTx = txNodes.size() - 1;
         }
         else
         {
             // consider all the transmitters
-            numTx = m_txDataMap.size();
+            numTx = txNodes.size();
         }
         // if (report stats for all TX nodes AND total number of tx nodes from whom
         // this receiver node rxed the packets is less the number of actual
         // transmitters)
-        if (m_considerAllTx && (it.second.size() < numTx))
+        if (m_considerAllTx && (rxNode.lastLink - rxNode.firstLink < numTx))
         {
-            for (const auto& itTx : m_txDataMap)
+            for (const auto& txNode : txNodes)
             {
-                if (it.second.find(itTx.second.at(0).ipAddrs) == it.second.end())
+                // we didn't find the TX in the links of this RX node.
+                // avoid my own IP
+                if (m_pkts.FindLink(rxNode, txNode.ip) == nullptr && txNode.ip != data.rxIp)
                 {
-                    // we didn't find the TX in our m_rxDataMap.
-                    // avoid my own IP
-                    if (itTx.second.at(0).ipAddrs != data.ipAddrs)
-                    {
-                        sqlite3_stmt* stmt;
-                        std::string cmd =
-                            "INSERT INTO " + tableName + " VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?);";
-                        rc = sqlite3_prepare_v2(m_db,
-                                                cmd.c_str(),
-                                                static_cast<int>(cmd.size()),
-                                                &stmt,
-                                                nullptr);
-                        NS_ABORT_MSG_UNLESS(rc == SQLITE_OK,
-                                            "Error INSERT. Db error: " << sqlite3_errmsg(m_db));
-
-                        NS_ABORT_UNLESS(
-                            sqlite3_bind_text(stmt, 1, data.txRx.c_str(), -1, SQLITE_STATIC) ==
-                            SQLITE_OK);
-                        NS_ABORT_UNLESS(sqlite3_bind_int(stmt, 2, data.nodeId) == SQLITE_OK);
-                        NS_ABORT_UNLESS(sqlite3_bind_int(stmt, 3, data.imsi) == SQLITE_OK);
-                        NS_ABORT_UNLESS(sqlite3_bind_text(stmt,
-                                                          4,
-                                                          itTx.second.at(0).ipAddrs.c_str(),
-                                                          -1,
-                                                          SQLITE_STATIC) == SQLITE_OK);
-                        NS_ABORT_UNLESS(
-                            sqlite3_bind_int(stmt, 5, GetTotalTxPkts(itTx.second.at(0).ipAddrs)) ==
-                            SQLITE_OK);
-                        NS_ABORT_UNLESS(
-                            sqlite3_bind_text(stmt, 6, data.ipAddrs.c_str(), -1, SQLITE_STATIC) ==
-                            SQLITE_OK);
-                        NS_ABORT_UNLESS(sqlite3_bind_int(stmt, 7, 0) ==
-                                        SQLITE_OK); // zero rxed pkets
-                        NS_ABORT_UNLESS(sqlite3_bind_double(stmt, 8, 0) == SQLITE_OK); // zero thput
-                        NS_ABORT_UNLESS(sqlite3_bind_int(stmt, 9, RngSeedManager::GetSeed()) ==
-                                        SQLITE_OK);
-                        NS_ABORT_UNLESS(sqlite3_bind_int(stmt, 10, RngSeedManager::GetRun()) ==
-                                        SQLITE_OK);
-
-                        rc = sqlite3_step(stmt);
-                        NS_ABORT_MSG_UNLESS(rc == SQLITE_OK || rc == SQLITE_DONE,
-                                            "Could not correctly execute the statement. Db error: "
-                                                << sqlite3_errmsg(m_db));
-                        rc = sqlite3_finalize(stmt);
-                        NS_ABORT_MSG_UNLESS(rc == SQLITE_OK || rc == SQLITE_DONE,
-                                            "Could not correctly finalize the statement. Db error: "
-                                                << sqlite3_errmsg(m_db));
-                    }
+                    // zero rxed packets, zero thput
+                    rows.push_back({&data, txNode.ip, GetTotalTxPkts(txNode.ip), 0, 0.0});
                 }
             }
         }
     }
 }
 
+void
+V2xKpi::WriteThputRows(const std::vector<ThputRow>& rows)
+{
+    KpiTableWriter writer(m_db,
+                          "thput",
+                          THPUT_COLUMNS,
+                          RngSeedManager::GetSeed(),
+                          RngSeedManager::GetRun(),
+                          m_kpiBatchSize);
+
+    for (const auto& row : rows)
+    {
+        writer.BindText(RX)
+            .BindInt(row.rx->rxNodeId)
+            .BindInt(row.rx->rxImsi)
+            .BindText(m_pkts.GetIp(row.txIp))
+            .BindInt(row.txPkts)
+            .BindText(m_pkts.GetIp(row.rx->rxIp))
+            .BindInt(row.rxPkts)
+            .BindDouble(row.thput)
+            .EndRow();
+    }
+}
+
 double
-V2xKpi::ComputeThput(std::vector<PktTxRxData> data) const
+V2xKpi::ComputeThput(std::span<const uint32_t> pktSizes) const
 {
-    NS_ABORT_MSG_IF(m_txAppDuration == 0.0,
-                    "Can not compute throughput with " << m_txAppDuration << " duration");
     uint64_t rxByteCounter = 0;
 
-    // NS_LOG_UNCOND ("Packet Vector size " << data.size () << " to throughput");
-    for (const auto& it : data)
+    // NS_LOG_UNCOND ("Packet Vector size " << pktSizes.size () << " to throughput");
+    for (uint32_t pktSize : pktSizes)
     {
-        rxByteCounter += it.pktSize;
+        rxByteCounter += pktSize;
     }
 
+    return ComputeThput(rxByteCounter);
+}
+
+double
+V2xKpi::ComputeThput(uint64_t rxBytes) const
+{
+    NS_ABORT_MSG_IF(m_txAppDuration == 0.0,
+                    "Can not compute throughput with " << m_txAppDuration << " duration");
     // thput in kpbs
-    double thput = (rxByteCounter * 8) / m_txAppDuration / 1000.0;
+    double thput = (rxBytes * 8) / m_txAppDuration / 1000.0;
     return thput;
 }
 
 void
-V2xKpi::SavePktTxData()
+V2xKpi::SavePktTxData(uint32_t reader)
 {
+    sqlite3* db = m_connections.GetReader(reader);
     int rc;
-    rc = sqlite3_open(m_dbPath.c_str(), &m_db);
-    NS_ABORT_MSG_UNLESS(rc == SQLITE_OK, "Error open DB. Db error: " << sqlite3_errmsg(m_db));
 
     sqlite3_stmt* stmt;
     std::string sql(
         "SELECT * FROM pktTxRx WHERE txRx = 'tx' AND txRx IS NOT NULL AND SEED = ? AND RUN = ?;");
-    rc = sqlite3_prepare_v2(m_db, sql.c_str(), static_cast<int>(sql.size()), &stmt, nullptr);
-    NS_ABORT_MSG_UNLESS(rc == SQLITE_OK, "Error SELECT. Db error: " << sqlite3_errmsg(m_db));
+    rc = sqlite3_prepare_v2(db, sql.c_str(), static_cast<int>(sql.size()), &stmt, nullptr);
+    NS_ABORT_MSG_UNLESS(rc == SQLITE_OK, "Error SELECT. Db error: " << sqlite3_errmsg(db));
     NS_ABORT_UNLESS(sqlite3_bind_int(stmt, 1, RngSeedManager::GetSeed()) == SQLITE_OK);
     NS_ABORT_UNLESS(sqlite3_bind_int(stmt, 2, RngSeedManager::GetRun()) == SQLITE_OK);
 
     while ((rc = sqlite3_step(stmt)) == SQLITE_ROW)
     {
-        uint32_t nodeId = sqlite3_column_int(stmt, 2);
-        auto nodeIt = m_txDataMap.find(nodeId);
-        if (nodeIt == m_txDataMap.end())
-        {
-            // NS_LOG_UNCOND ("nodeId = " << nodeId << " not found creating new entry");
-            PktTxRxData result(
-                sqlite3_column_double(stmt, 0),
-                std::string(reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1))),
-                sqlite3_column_int(stmt, 2),
-                sqlite3_column_int(stmt, 3),
-                sqlite3_column_int(stmt, 4),
-                std::string(reinterpret_cast<const char*>(sqlite3_column_text(stmt, 5))),
-                sqlite3_column_int(stmt, 9));
-            std::vector<PktTxRxData> data;
-            data.push_back(result);
-            m_txDataMap.insert(std::make_pair(nodeId, data));
-        }
-        else
-        {
-            PktTxRxData result(
-                sqlite3_column_double(stmt, 0),
-                std::string(reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1))),
-                sqlite3_column_int(stmt, 2),
-                sqlite3_column_int(stmt, 3),
-                sqlite3_column_int(stmt, 4),
-                std::string(reinterpret_cast<const char*>(sqlite3_column_text(stmt, 5))),
-                sqlite3_column_int(stmt, 9));
-            nodeIt->second.push_back(result);
-        }
+        m_pkts.AddTx(sqlite3_column_double(stmt, 0),
+                     sqlite3_column_int(stmt, 2),
+                     sqlite3_column_int(stmt, 3),
+                     m_pkts.InternIp(ColumnText(stmt, 5)),
+                     sqlite3_column_int(stmt, 9));
     }
 
-    NS_ABORT_MSG_UNLESS(rc == SQLITE_DONE, "Error not DONE. Db error: " << sqlite3_errmsg(m_db));
+    NS_ABORT_MSG_UNLESS(rc == SQLITE_DONE, "Error not DONE. Db error: " << sqlite3_errmsg(db));
 
     rc = sqlite3_finalize(stmt);
     NS_ABORT_MSG_UNLESS(
         rc == SQLITE_OK || rc == SQLITE_DONE,
-        "Could not correctly finalize the statement. Db error: " << sqlite3_errmsg(m_db));
+        "Could not correctly finalize the statement. Db error: " << sqlite3_errmsg(db));
 }
 
-uint64_t
-V2xKpi::GetTotalTxPkts(std::string srcIpAddrs)
+void
+V2xKpi::IndexNodes()
 {
-    uint64_t totalTxPkts = 0;
-    for (const auto& it : m_txDataMap)
+    // Resolve every IP of the traces to its node once, and count the
+    // packets of each transmitter, so that the KPI loops only index arrays.
+    // As the IP of a TX node, the first in node id order counts.
+    m_nodeOfIp.resize(m_pkts.GetNumIps());
+    for (uint32_t ip = 0; ip < m_nodeOfIp.size(); ++ip)
+    {
+        m_nodeOfIp[ip] = m_nodes.Intern(m_pkts.GetIp(ip));
+    }
+    m_nodes.ClearTxPkts();
+    for (const auto& txNode : m_pkts.GetTxNodes())
     {
-        if (it.second.at(0).ipAddrs == srcIpAddrs)
+        uint32_t node = m_nodeOfIp[txNode.ip];
+        if (m_nodes.GetTxPkts(node) == 0)
         {
-            totalTxPkts = it.second.size();
-            break;
+            m_nodes.SetTxPkts(node, txNode.last - txNode.first);
         }
     }
+    if (IsMobilityAware())
+    {
+        m_timeline.Index(m_nodes.GetN(), m_range);
+    }
+}
+
+bool
+V2xKpi::IsMobilityAware() const
+{
+    return m_range > 0 && !m_timeline.IsEmpty();
+}
+
+const Vector&
+V2xKpi::GetSampledPosition(uint32_t node, uint32_t snapshot) const
+{
+    NS_ABORT_MSG_IF(!m_timeline.HasPosition(snapshot, node),
+                    "Unable to find a sampled position of IP " << m_nodes.GetIp(node));
+    return m_timeline.GetPosition(snapshot, node);
+}
 
-    return totalTxPkts;
+uint64_t
+V2xKpi::GetTotalTxPkts(uint32_t srcIp) const
+{
+    return m_nodes.GetTxPkts(m_nodeOfIp[srcIp]);
 }
 
 void
 V2xKpi::ComputePsschTxStats()
 {
+    PsschOverlapIndex psschTx;
+    ScanPsschTx(0, psschTx);
+    SaveSimultPsschTxStats(psschTx.GetTotal(),
+                           psschTx.GetNonOverlapping(),
+                           psschTx.GetOverlapping());
+}
+
+void
+V2xKpi::ScanPsschTx(uint32_t reader, PsschOverlapIndex& psschTx)
+{
+    sqlite3* db = m_connections.GetReader(reader);
     int rc;
-    rc = sqlite3_open(m_dbPath.c_str(), &m_db);
-    NS_ABORT_MSG_UNLESS(rc == SQLITE_OK, "Error open DB. Db error: " << sqlite3_errmsg(m_db));
 
     sqlite3_stmt* stmt;
     std::string sql("SELECT * FROM psschTxUeMac WHERE SEED = ? AND RUN = ?;");
-    rc = sqlite3_prepare_v2(m_db, sql.c_str(), static_cast<int>(sql.size()), &stmt, nullptr);
-    NS_ABORT_MSG_UNLESS(rc == SQLITE_OK, "Error SELECT. Db error: " << sqlite3_errmsg(m_db));
+    rc = sqlite3_prepare_v2(db, sql.c_str(), static_cast<int>(sql.size()), &stmt, nullptr);
+    NS_ABORT_MSG_UNLESS(rc == SQLITE_OK, "Error SELECT. Db error: " << sqlite3_errmsg(db));
     NS_ABORT_UNLESS(sqlite3_bind_int(stmt, 1, RngSeedManager::GetSeed()) == SQLITE_OK);
     NS_ABORT_UNLESS(sqlite3_bind_int(stmt, 2, RngSeedManager::GetRun()) == SQLITE_OK);
-    uint32_t rowCount = 0;
-    std::vector<PsschTxData> nonOverLapPsschTx;
-    std::vector<PsschTxData> overLapPsschTx;
     while ((rc = sqlite3_step(stmt)) == SQLITE_ROW)
     {
-        rowCount++;
-        PsschTxData result(sqlite3_column_int(stmt, 5),
-                           sqlite3_column_int(stmt, 6),
-                           sqlite3_column_int(stmt, 7),
-                           sqlite3_column_int(stmt, 8),
-                           sqlite3_column_int(stmt, 9),
-                           sqlite3_column_int(stmt, 11),
-                           sqlite3_column_int(stmt, 12));
-
-        if (nonOverLapPsschTx.empty() && nonOverLapPsschTx.empty())
-        {
-            nonOverLapPsschTx.push_back(result);
-        }
-        else
-        {
-            auto it = std::find(nonOverLapPsschTx.begin(), nonOverLapPsschTx.end(), result);
-            if (it != nonOverLapPsschTx.end())
-            {
-                overLapPsschTx.push_back(result);
-                overLapPsschTx.push_back(*it);
-                nonOverLapPsschTx.erase(it);
-            }
-            else
-            {
-                auto it = std::find(overLapPsschTx.begin(), overLapPsschTx.end(), result);
-                if (it != overLapPsschTx.end())
-                {
-                    overLapPsschTx.push_back(result);
-                }
-                else
-                {
-                    nonOverLapPsschTx.push_back(result);
-                }
-            }
-        }
+        psschTx.Add({static_cast<uint32_t>(sqlite3_column_int(stmt, 5)),
+                     static_cast<uint32_t>(sqlite3_column_int(stmt, 6)),
+                     static_cast<uint16_t>(sqlite3_column_int(stmt, 7)),
+                     static_cast<uint16_t>(sqlite3_column_int(stmt, 8)),
+                     static_cast<uint16_t>(sqlite3_column_int(stmt, 9)),
+                     static_cast<uint16_t>(sqlite3_column_int(stmt, 11)),
+                     static_cast<uint16_t>(sqlite3_column_int(stmt, 12))});
     }
 
-    NS_ABORT_MSG_UNLESS(rc == SQLITE_DONE, "Error not DONE. Db error: " << sqlite3_errmsg(m_db));
+    NS_ABORT_MSG_UNLESS(rc == SQLITE_DONE, "Error not DONE. Db error: " << sqlite3_errmsg(db));
 
     rc = sqlite3_finalize(stmt);
     NS_ABORT_MSG_UNLESS(
         rc == SQLITE_OK || rc == SQLITE_DONE,
-        "Could not correctly finalize the statement. Db error: " << sqlite3_errmsg(m_db));
-
-    // NS_LOG_UNCOND ("Non-overlapping Tx " << nonOverLapPsschTx.size ());
-    // NS_LOG_UNCOND ("overlapping Tx " << overLapPsschTx.size ());
-    // NS_LOG_UNCOND ("Total rows " << rowCount);
-    SaveSimultPsschTxStats(rowCount, nonOverLapPsschTx.size(), overLapPsschTx.size());
+        "Could not correctly finalize the statement. Db error: " << sqlite3_errmsg(db));
 }
 
 void
@@ -771,64 +951,46 @@ V2xKpi::SaveSimultPsschTxStats(uint32_t totalPsschTx,
                                uint32_t numNonOverLapPsschTx,
                                uint32_t numOverLapPsschTx)
 {
-    std::string tableName = "simulPsschTx";
-    std::string cmd = ("CREATE TABLE IF NOT EXISTS " + tableName +
-                       " ("
-                       "totalTx INTEGER NOT NULL,"
-                       "numNonOverlapping INTEGER NOT NULL,"
-                       "numOverlapping INTEGER NOT NULL,"
-                       "SEED INTEGER NOT NULL,"
-                       "RUN INTEGER NOT NULL"
-                       ");");
-    int rc = sqlite3_exec(m_db, cmd.c_str(), nullptr, nullptr, nullptr);
-
-    NS_ABORT_MSG_UNLESS(rc == SQLITE_OK,
-                        "Error creating table. Db error: " << sqlite3_errmsg(m_db));
-
-    DeleteWhere(RngSeedManager::GetSeed(), RngSeedManager::GetRun(), tableName);
-
-    sqlite3_stmt* stmt;
-    std::string sql = "INSERT INTO " + tableName + " VALUES (?, ?, ?, ?, ?);";
-    rc = sqlite3_prepare_v2(m_db, sql.c_str(), static_cast<int>(sql.size()), &stmt, nullptr);
-    NS_ABORT_MSG_UNLESS(rc == SQLITE_OK, "Error INSERT. Db error: " << sqlite3_errmsg(m_db));
-
-    NS_ABORT_MSG_UNLESS(sqlite3_bind_int(stmt, 1, totalPsschTx) == SQLITE_OK,
-                        "Db error: " << sqlite3_errmsg(m_db));
-    NS_ABORT_MSG_UNLESS(sqlite3_bind_int(stmt, 2, numNonOverLapPsschTx) == SQLITE_OK,
-                        "Db error: " << sqlite3_errmsg(m_db));
-    NS_ABORT_MSG_UNLESS(sqlite3_bind_int(stmt, 3, numOverLapPsschTx) == SQLITE_OK,
-                        "Db error: " << sqlite3_errmsg(m_db));
-    NS_ABORT_MSG_UNLESS(sqlite3_bind_int(stmt, 4, RngSeedManager::GetSeed()) == SQLITE_OK,
-                        "Db error: " << sqlite3_errmsg(m_db));
-    NS_ABORT_MSG_UNLESS(sqlite3_bind_int(stmt, 5, RngSeedManager::GetRun()) == SQLITE_OK,
-                        "Db error: " << sqlite3_errmsg(m_db));
-
-    rc = sqlite3_step(stmt);
-    NS_ABORT_MSG_UNLESS(
-        rc == SQLITE_OK || rc == SQLITE_DONE,
-        "Could not correctly execute the statement. Db error: " << sqlite3_errmsg(m_db));
-    rc = sqlite3_finalize(stmt);
-    NS_ABORT_MSG_UNLESS(
-        rc == SQLITE_OK || rc == SQLITE_DONE,
-        "Could not correctly finalize the statement. Db error: " << sqlite3_errmsg(m_db));
+    KpiTableWriter writer(m_db,
+                          "simulPsschTx",
+                          {"totalTx INTEGER NOT NULL",
+                           "numNonOverlapping INTEGER NOT NULL",
+                           "numOverlapping INTEGER NOT NULL"},
+                          RngSeedManager::GetSeed(),
+                          RngSeedManager::GetRun(),
+                          m_kpiBatchSize);
+
+    writer.BindInt(totalPsschTx).BindInt(numNonOverLapPsschTx).BindInt(numOverLapPsschTx).EndRow();
 }
 
 void
 V2xKpi::ComputePsschTbCorruptionStats()
 {
+    uint32_t rowCount = 0;
+    uint32_t psschSuccessCount = 0;
+    uint32_t sci2SuccessCount = 0;
+    ScanPsschTbRx(0, rowCount, psschSuccessCount, sci2SuccessCount);
+    SavePsschTbCorruptionStats(rowCount, psschSuccessCount, sci2SuccessCount);
+}
+
+void
+V2xKpi::ScanPsschTbRx(uint32_t reader,
+                      uint32_t& rowCount,
+                      uint32_t& psschSuccessCount,
+                      uint32_t& sci2SuccessCount)
+{
+    sqlite3* db = m_connections.GetReader(reader);
     int rc;
-    rc = sqlite3_open(m_dbPath.c_str(), &m_db);
-    NS_ABORT_MSG_UNLESS(rc == SQLITE_OK, "Error open DB. Db error: " << sqlite3_errmsg(m_db));
 
     sqlite3_stmt* stmt;
     std::string sql("SELECT * FROM psschRxUePhy WHERE SEED = ? AND RUN = ?;");
-    rc = sqlite3_prepare_v2(m_db, sql.c_str(), static_cast<int>(sql.size()), &stmt, nullptr);
-    NS_ABORT_MSG_UNLESS(rc == SQLITE_OK, "Error SELECT. Db error: " << sqlite3_errmsg(m_db));
+    rc = sqlite3_prepare_v2(db, sql.c_str(), static_cast<int>(sql.size()), &stmt, nullptr);
+    NS_ABORT_MSG_UNLESS(rc == SQLITE_OK, "Error SELECT. Db error: " << sqlite3_errmsg(db));
     NS_ABORT_UNLESS(sqlite3_bind_int(stmt, 1, RngSeedManager::GetSeed()) == SQLITE_OK);
     NS_ABORT_UNLESS(sqlite3_bind_int(stmt, 2, RngSeedManager::GetRun()) == SQLITE_OK);
-    uint32_t rowCount = 0;
-    uint32_t psschSuccessCount = 0;
-    uint32_t sci2SuccessCount = 0;
+    rowCount = 0;
+    psschSuccessCount = 0;
+    sci2SuccessCount = 0;
 
     while ((rc = sqlite3_step(stmt)) == SQLITE_ROW)
     {
@@ -847,17 +1009,12 @@ V2xKpi::ComputePsschTbCorruptionStats()
         }
     }
 
-    NS_ABORT_MSG_UNLESS(rc == SQLITE_DONE, "Error not DONE. Db error: " << sqlite3_errmsg(m_db));
+    NS_ABORT_MSG_UNLESS(rc == SQLITE_DONE, "Error not DONE. Db error: " << sqlite3_errmsg(db));
 
     rc = sqlite3_finalize(stmt);
     NS_ABORT_MSG_UNLESS(
         rc == SQLITE_OK || rc == SQLITE_DONE,
-        "Could not correctly finalize the statement. Db error: " << sqlite3_errmsg(m_db));
-
-    // NS_LOG_UNCOND ("psschSuccessCount " << psschSuccessCount);
-    // NS_LOG_UNCOND ("sci2SuccessCount " << sci2SuccessCount);
-    // NS_LOG_UNCOND ("Total rows " << rowCount);
-    SavePsschTbCorruptionStats(rowCount, psschSuccessCount, sci2SuccessCount);
+        "Could not correctly finalize the statement. Db error: " << sqlite3_errmsg(db));
 }
 
 void
@@ -865,98 +1022,432 @@ V2xKpi::SavePsschTbCorruptionStats(uint32_t totalTbRx,
                                    uint32_t psschSuccessCount,
                                    uint32_t sci2SuccessCount)
 {
-    std::string tableName = "PsschTbRx";
-    std::string cmd = ("CREATE TABLE IF NOT EXISTS " + tableName +
-                       " ("
-                       "totalRx INTEGER NOT NULL,"
-                       "psschSuccessCount INTEGER NOT NULL,"
-                       "psschFailCount INTEGER NOT NULL,"
-                       "sci2SuccessCount INTEGER NOT NULL,"
-                       "sci2FailCount INTEGER NOT NULL,"
-                       "SEED INTEGER NOT NULL,"
-                       "RUN INTEGER NOT NULL"
-                       ");");
-    int rc = sqlite3_exec(m_db, cmd.c_str(), nullptr, nullptr, nullptr);
+    KpiTableWriter writer(m_db,
+                          "PsschTbRx",
+                          {"totalRx INTEGER NOT NULL",
+                           "psschSuccessCount INTEGER NOT NULL",
+                           "psschFailCount INTEGER NOT NULL",
+                           "sci2SuccessCount INTEGER NOT NULL",
+                           "sci2FailCount INTEGER NOT NULL"},
+                          RngSeedManager::GetSeed(),
+                          RngSeedManager::GetRun(),
+                          m_kpiBatchSize);
+
+    writer.BindInt(totalTbRx)
+        .BindInt(psschSuccessCount)
+        .BindInt(totalTbRx - psschSuccessCount)
+        .BindInt(sci2SuccessCount)
+        .BindInt(totalTbRx - sci2SuccessCount)
+        .EndRow();
+}
 
-    NS_ABORT_MSG_UNLESS(rc == SQLITE_OK,
-                        "Error creating table. Db error: " << sqlite3_errmsg(m_db));
+void
+V2xKpi::WriteKpis(const OnlineKpiEngine& engine)
+{
+    OpenDb();
+    SaveAvrgPir(engine);
+    SaveThput(engine);
+
+    uint32_t total = 0;
+    uint32_t nonOverlapping = 0;
+    uint32_t overlapping = 0;
+    engine.GetPsschTxStats(total, nonOverlapping, overlapping);
+    SaveSimultPsschTxStats(total, nonOverlapping, overlapping);
+
+    uint32_t psschSuccess = 0;
+    uint32_t sci2Success = 0;
+    engine.GetPsschRxStats(total, psschSuccess, sci2Success);
+    SavePsschTbCorruptionStats(total, psschSuccess, sci2Success);
+
+    SaveAvrgPrr(engine);
+}
 
-    DeleteWhere(RngSeedManager::GetSeed(), RngSeedManager::GetRun(), tableName);
+Vector
+V2xKpi::GetPosition(const std::string& ip) const
+{
+    uint32_t node = m_nodes.Find(ip);
+    NS_ABORT_MSG_IF(node == KpiNodeRegistry::NONE, "Unable to find the position of IP " << ip);
+    return m_nodes.GetPosition(node);
+}
 
-    sqlite3_stmt* stmt;
-    std::string sql = "INSERT INTO " + tableName + " VALUES (?, ?, ?, ?, ?, ?, ?);";
-    rc = sqlite3_prepare_v2(m_db, sql.c_str(), static_cast<int>(sql.size()), &stmt, nullptr);
-    NS_ABORT_MSG_UNLESS(rc == SQLITE_OK, "Error INSERT. Db error: " << sqlite3_errmsg(m_db));
-
-    NS_ABORT_MSG_UNLESS(sqlite3_bind_int(stmt, 1, totalTbRx) == SQLITE_OK,
-                        "Db error: " << sqlite3_errmsg(m_db));
-    NS_ABORT_MSG_UNLESS(sqlite3_bind_int(stmt, 2, psschSuccessCount) == SQLITE_OK,
-                        "Db error: " << sqlite3_errmsg(m_db));
-    NS_ABORT_MSG_UNLESS(sqlite3_bind_int(stmt, 3, (totalTbRx - psschSuccessCount)) == SQLITE_OK,
-                        "Db error: " << sqlite3_errmsg(m_db));
-    NS_ABORT_MSG_UNLESS(sqlite3_bind_int(stmt, 4, sci2SuccessCount) == SQLITE_OK,
-                        "Db error: " << sqlite3_errmsg(m_db));
-    NS_ABORT_MSG_UNLESS(sqlite3_bind_int(stmt, 5, (totalTbRx - sci2SuccessCount)) == SQLITE_OK,
-                        "Db error: " << sqlite3_errmsg(m_db));
-    NS_ABORT_MSG_UNLESS(sqlite3_bind_int(stmt, 6, RngSeedManager::GetSeed()) == SQLITE_OK,
-                        "Db error: " << sqlite3_errmsg(m_db));
-    NS_ABORT_MSG_UNLESS(sqlite3_bind_int(stmt, 7, RngSeedManager::GetRun()) == SQLITE_OK,
-                        "Db error: " << sqlite3_errmsg(m_db));
-
-    rc = sqlite3_step(stmt);
-    NS_ABORT_MSG_UNLESS(
-        rc == SQLITE_OK || rc == SQLITE_DONE,
-        "Could not correctly execute the statement. Db error: " << sqlite3_errmsg(m_db));
-    rc = sqlite3_finalize(stmt);
-    NS_ABORT_MSG_UNLESS(
-        rc == SQLITE_OK || rc == SQLITE_DONE,
-        "Could not correctly finalize the statement. Db error: " << sqlite3_errmsg(m_db));
+void
+V2xKpi::SaveAvrgPir(const OnlineKpiEngine& engine)
+{
+    KpiTableWriter writer(m_db,
+                          "avrgPir",
+                          AVRG_PIR_COLUMNS,
+                          RngSeedManager::GetSeed(),
+                          RngSeedManager::GetRun(),
+                          m_kpiBatchSize);
+
+    for (const auto& [nodeId, rx] : engine.GetRxNodes())
+    {
+        for (const auto& [txIp, link] : rx.links)
+        {
+            double distance = 0.0;
+            if (m_range > 0)
+            {
+                distance = CalculateDistance(GetPosition(rx.ip), GetPosition(txIp));
+                if (distance > m_range)
+                {
+                    continue;
+                }
+            }
+            if (link.pirCount == 0)
+            {
+                // Only one packet received from this transmitter
+                continue;
+            }
+            writer.BindText(RX)
+                .BindInt(nodeId)
+                .BindInt(rx.imsi)
+                .BindText(txIp)
+                .BindText(rx.ip)
+                .BindDouble(link.pirSum / link.pirCount)
+                .BindDouble(distance)
+                .EndRow();
+        }
+    }
 }
 
 void
-V2xKpi::SaveCryptoOverhead(uint32_t nodeId, double encryptTime, double decryptTime, std::size_t length, std::size_t declength)
+V2xKpi::SaveThput(const OnlineKpiEngine& engine)
 {
-    int rc;
-    rc = sqlite3_open(m_dbPath.c_str(), &m_db);
-    NS_ABORT_MSG_UNLESS(rc == SQLITE_OK, "Error open DB. Db error: " << sqlite3_errmsg(m_db));
-
-    std::string tableName = "cryptoOverhead";
-    std::string cmd = ("CREATE TABLE IF NOT EXISTS " + tableName +
-                       " ("
-                       "nodeId INTEGER NOT NULL,"
-                       "encryptionTime REAL NOT NULL,"
-                       "decryptionTime REAL NOT NULL,"
-                       "length INTEGER NOT NULL,"
-                       "declength INTEGER NOT NULL,"
-                       "SEED INTEGER NOT NULL,"
-                       "RUN INTEGER NOT NULL"
-                       ");");
-    rc = sqlite3_exec(m_db, cmd.c_str(), nullptr, nullptr, nullptr);
-    NS_ABORT_MSG_UNLESS(rc == SQLITE_OK,
-                        "Error creating table. Db error: " << sqlite3_errmsg(m_db));
-
-    cmd = "INSERT INTO " + tableName + " VALUES (?, ?, ?, ?, ?, ?, ?);";
-    sqlite3_stmt* stmt;
-    rc = sqlite3_prepare_v2(m_db, cmd.c_str(), static_cast<int>(cmd.size()), &stmt, nullptr);
-    NS_ABORT_MSG_UNLESS(rc == SQLITE_OK, "Error INSERT. Db error: " << sqlite3_errmsg(m_db));
-
-    NS_ABORT_UNLESS(sqlite3_bind_int(stmt, 1, nodeId) == SQLITE_OK);
-    NS_ABORT_UNLESS(sqlite3_bind_double(stmt, 2, encryptTime) == SQLITE_OK);
-    NS_ABORT_UNLESS(sqlite3_bind_double(stmt, 3, decryptTime) == SQLITE_OK);
-    NS_ABORT_UNLESS(sqlite3_bind_int(stmt, 4, length) == SQLITE_OK);
-    NS_ABORT_UNLESS(sqlite3_bind_int(stmt, 5, declength) == SQLITE_OK);
-    NS_ABORT_UNLESS(sqlite3_bind_int(stmt, 6, RngSeedManager::GetSeed()) == SQLITE_OK);
-    NS_ABORT_UNLESS(sqlite3_bind_int(stmt, 7, RngSeedManager::GetRun()) == SQLITE_OK);
-    
-
-    rc = sqlite3_step(stmt);
-    NS_ABORT_MSG_UNLESS(
-        rc == SQLITE_OK || rc == SQLITE_DONE,
-        "Could not correctly execute the statement. Db error: " << sqlite3_errmsg(m_db));
-    rc = sqlite3_finalize(stmt);
-    NS_ABORT_MSG_UNLESS(
-        rc == SQLITE_OK || rc == SQLITE_DONE,
-        "Could not correctly finalize the statement. Db error: " << sqlite3_errmsg(m_db));
+    KpiTableWriter writer(m_db,
+                          "thput",
+                          THPUT_COLUMNS,
+                          RngSeedManager::GetSeed(),
+                          RngSeedManager::GetRun(),
+                          m_kpiBatchSize);
+
+    const auto& txNodes = engine.GetTxNodes();
+    for (const auto& [nodeId, rx] : engine.GetRxNodes())
+    {
+        for (const auto& [txIp, link] : rx.links)
+        {
+            writer.BindText(RX)
+                .BindInt(nodeId)
+                .BindInt(rx.imsi)
+                .BindText(txIp)
+                .BindInt(engine.GetTotalTxPkts(txIp))
+                .BindText(rx.ip)
+                .BindInt(link.rxPkts)
+                .BindDouble(ComputeThput(link.rxBytes))
+                .EndRow();
+        }
+
+        // Zero throughput for the transmitters this node did not hear, as
+        // in SaveThput()
+        std::size_t numTx = txNodes.size() - (txNodes.count(nodeId) != 0 ? 1 : 0);
+        if (m_considerAllTx && rx.links.size() < numTx)
+        {
+            for (const auto& [txId, tx] : txNodes)
+            {
+                if (rx.links.count(tx.ip) == 0 && tx.ip != rx.ip)
+                {
+                    writer.BindText(RX)
+                        .BindInt(nodeId)
+                        .BindInt(rx.imsi)
+                        .BindText(tx.ip)
+                        .BindInt(tx.txPkts)
+                        .BindText(rx.ip)
+                        .BindInt(0)
+                        .BindDouble(0.0)
+                        .EndRow();
+                }
+            }
+        }
+    }
+}
+
+void
+V2xKpi::SaveAvrgPrr(const OnlineKpiEngine& engine)
+{
+    KpiTableWriter writer(m_db,
+                          "avrgPrr",
+                          AVRG_PRR_COLUMNS,
+                          RngSeedManager::GetSeed(),
+                          RngSeedManager::GetRun(),
+                          m_kpiBatchSize);
+
+    for (const auto& [nodeId, tx] : engine.GetTxNodes())
+    {
+        // Every node that received any packet is a potential receiver when
+        // in range, as in ComputeAvrgPrr
+        Vector txPos = GetPosition(tx.ip);
+        uint32_t numNeib = 0;
+        uint64_t pktRxCount = 0;
+        for (const auto& [rxId, rx] : engine.GetRxNodes())
+        {
+            double txRxDist = CalculateDistance(GetPosition(rx.ip), txPos);
+            if (txRxDist > m_range && m_range > 0.0)
+            {
+                continue;
+            }
+            numNeib++;
+            auto link = rx.links.find(tx.ip);
+            if (link != rx.links.end())
+            {
+                pktRxCount += link->second.txPktsRxed;
+            }
+        }
+        if (numNeib == 0)
+        {
+            continue;
+        }
+        double avrgPrr = 0.0;
+        if (pktRxCount > 0)
+        {
+            avrgPrr = static_cast<double>(pktRxCount) / (tx.txPkts * numNeib);
+        }
+        writer.BindText(TX)
+            .BindInt(nodeId)
+            .BindInt(tx.imsi)
+            .BindText(tx.ip)
+            .BindInt(m_range)
+            .BindInt(numNeib)
+            .BindDouble(avrgPrr)
+            .EndRow();
+    }
+}
+
+void
+V2xKpi::SaveCryptoOverhead(const std::vector<CryptoOverheadRecord>& records)
+{
+    OpenDb();
+
+    KpiTableWriter writer(m_db,
+                          "cryptoOverhead",
+                          {"nodeId INTEGER NOT NULL",
+                           "encryptionTime REAL NOT NULL",
+                           "decryptionTime REAL NOT NULL",
+                           "length INTEGER NOT NULL",
+                           "declength INTEGER NOT NULL",
+                           "encryptionMin REAL NOT NULL",
+                           "encryptionP99 REAL NOT NULL",
+                           "encryptionStddev REAL NOT NULL",
+                           "decryptionMin REAL NOT NULL",
+                           "decryptionP99 REAL NOT NULL",
+                           "decryptionStddev REAL NOT NULL",
+                           "iterations INTEGER NOT NULL"},
+                          RngSeedManager::GetSeed(),
+                          RngSeedManager::GetRun(),
+                          m_kpiBatchSize);
+
+    for (const auto& record : records)
+    {
+        writer.BindInt(record.nodeId)
+            .BindDouble(record.encrypt.median)
+            .BindDouble(record.decrypt.median)
+            .BindInt(record.length)
+            .BindInt(record.declength)
+            .BindDouble(record.encrypt.min)
+            .BindDouble(record.encrypt.p99)
+            .BindDouble(record.encrypt.stddev)
+            .BindDouble(record.decrypt.min)
+            .BindDouble(record.decrypt.p99)
+            .BindDouble(record.decrypt.stddev)
+            .BindInt(std::min(record.encrypt.iterations, record.decrypt.iterations))
+            .EndRow();
+    }
+}
+
+void
+V2xKpi::SaveRxCryptoOverhead(const std::vector<RxCryptoRecord>& records)
+{
+    OpenDb();
+
+    struct PerNode
+    {
+        uint64_t rxPkts{0};
+        uint64_t validPkts{0};
+        double totalDecryptTime{0.0};
+        double maxDecryptTime{0.0};
+        uint64_t parsedCams{0};
+        double totalParseTime{0.0};
+    };
+
+    std::map<uint32_t, PerNode> perNode;
+
+    // One packet per row can easily be tens of thousands of rows
+    KpiTableWriter writer(m_db,
+                          "rxCryptoOverhead",
+                          {"nodeId INTEGER NOT NULL",
+                           "rxTime DOUBLE NOT NULL",
+                           "srcIp TEXT NOT NULL",
+                           "pktSize INTEGER NOT NULL",
+                           "decryptionTime REAL NOT NULL",
+                           "declength INTEGER",
+                           "valid INTEGER",
+                           "queueTime REAL NOT NULL",
+                           "modelled INTEGER NOT NULL",
+                           "camCount INTEGER",
+                           "parseTime REAL"},
+                          RngSeedManager::GetSeed(),
+                          RngSeedManager::GetRun(),
+                          m_kpiBatchSize);
+
+    for (const auto& record : records)
+    {
+        // A modelled packet is never decrypted nor parsed
+        writer.BindInt(record.nodeId)
+            .BindDouble(record.rxTime)
+            .BindText(record.srcIp)
+            .BindInt(record.pktSize)
+            .BindDouble(record.decryptTime);
+        if (record.modelled)
+        {
+            writer.BindNull().BindNull();
+        }
+        else
+        {
+            writer.BindInt(record.declength).BindInt(record.valid);
+        }
+        writer.BindDouble(record.queueTime).BindInt(record.modelled);
+        if (record.modelled)
+        {
+            writer.BindNull().BindNull();
+        }
+        else
+        {
+            writer.BindInt(record.cams).BindDouble(record.parseTime);
+        }
+        writer.EndRow();
+
+        PerNode& node = perNode[record.nodeId];
+        node.rxPkts++;
+        node.validPkts += record.valid ? 1 : 0;
+        node.totalDecryptTime += record.decryptTime;
+        node.maxDecryptTime = std::max(node.maxDecryptTime, record.decryptTime);
+        node.parsedCams += record.cams;
+        node.totalParseTime += record.parseTime;
+    }
+    writer.Finish();
+
+    KpiTableWriter perNodeWriter(m_db,
+                                 "rxCryptoPerNode",
+                                 {"nodeId INTEGER NOT NULL",
+                                  "rxPkts INTEGER NOT NULL",
+                                  "validPkts INTEGER NOT NULL",
+                                  "totalDecryptionTime REAL NOT NULL",
+                                  "maxDecryptionTime REAL NOT NULL",
+                                  "parsedCams INTEGER NOT NULL",
+                                  "totalParseTime REAL NOT NULL"},
+                                 RngSeedManager::GetSeed(),
+                                 RngSeedManager::GetRun(),
+                                 m_kpiBatchSize);
+
+    for (const auto& [nodeId, node] : perNode)
+    {
+        perNodeWriter.BindInt(nodeId)
+            .BindInt(node.rxPkts)
+            .BindInt(node.validPkts)
+            .BindDouble(node.totalDecryptTime)
+            .BindDouble(node.maxDecryptTime)
+            .BindInt(node.parsedCams)
+            .BindDouble(node.totalParseTime)
+            .EndRow();
+    }
+}
+
+void
+V2xKpi::SaveCryptoPerfCounters(const std::vector<CryptoPerfRecord>& records)
+{
+    OpenDb();
+
+    KpiTableWriter writer(m_db,
+                          "cryptoPerfCounters",
+                          {"nodeId INTEGER NOT NULL",
+                           "engine TEXT NOT NULL",
+                           "operation TEXT NOT NULL",
+                           "bytes INTEGER NOT NULL",
+                           "cycles INTEGER",
+                           "instructions INTEGER",
+                           "cacheMisses INTEGER",
+                           "branchMisses INTEGER"},
+                          RngSeedManager::GetSeed(),
+                          RngSeedManager::GetRun(),
+                          m_kpiBatchSize);
+
+    for (const auto& record : records)
+    {
+        const CryptoOpSample& sample = record.sample;
+        const std::string engine = engine_name(sample.engine);
+        const std::string operation = sample.encrypt ? "encrypt" : "decrypt";
+        writer.BindInt(record.nodeId).BindText(engine).BindText(operation).BindInt(sample.bytes);
+        if (sample.counts.valid)
+        {
+            writer.BindInt(sample.counts.cycles)
+                .BindInt(sample.counts.instructions)
+                .BindInt(sample.counts.cache_misses)
+                .BindInt(sample.counts.branch_misses);
+        }
+        else
+        {
+            writer.BindNull().BindNull().BindNull().BindNull();
+        }
+        writer.EndRow();
+    }
+}
+
+void
+V2xKpi::SaveMemoryFootprint(const std::vector<MemoryFootprintRecord>& records)
+{
+    OpenDb();
+
+    KpiTableWriter writer(m_db,
+                          "memoryFootprint",
+                          {"phase TEXT NOT NULL",
+                           "engine TEXT NOT NULL",
+                           "allocBytes INTEGER NOT NULL",
+                           "allocCount INTEGER NOT NULL",
+                           "sealPoolBytes INTEGER NOT NULL",
+                           "peakRss INTEGER NOT NULL"},
+                          RngSeedManager::GetSeed(),
+                          RngSeedManager::GetRun(),
+                          m_kpiBatchSize);
+
+    for (const auto& record : records)
+    {
+        writer.BindText(record.phase)
+            .BindText(record.engine)
+            .BindInt(record.allocBytes)
+            .BindInt(record.allocCount)
+            .BindInt(record.sealPoolBytes)
+            .BindInt(record.peakRss)
+            .EndRow();
+    }
+}
+
+void
+V2xKpi::SaveCompressionOverhead(const std::vector<CompressionRecord>& records)
+{
+    OpenDb();
+
+    KpiTableWriter writer(m_db,
+                          "compressionOverhead",
+                          {"nodeId INTEGER NOT NULL",
+                           "inBytes INTEGER NOT NULL",
+                           "outBytes INTEGER NOT NULL",
+                           "ratio REAL NOT NULL",
+                           "compressionTime REAL NOT NULL",
+                           "decompressionTime REAL NOT NULL",
+                           "bypassed INTEGER NOT NULL"},
+                          RngSeedManager::GetSeed(),
+                          RngSeedManager::GetRun(),
+                          m_kpiBatchSize);
+
+    for (const auto& record : records)
+    {
+        writer.BindInt(record.nodeId)
+            .BindInt(record.result.in_bytes)
+            .BindInt(record.result.out_bytes)
+            .BindDouble(record.result.ratio())
+            .BindDouble(record.result.seconds)
+            .BindDouble(record.decompressTime)
+            .BindInt(record.result.bypassed)
+            .EndRow();
+    }
 }
 
 } // namespace ns3
@@ -7,10 +7,22 @@
 #ifndef V2X_KPI
 #define V2X_KPI
 
+#include "crypto_engine.h"
+#include "crypto_timing.h"
+#include "kpi-db-connections.h"
+#include "kpi-node-registry.h"
+#include "online-kpi-engine.h"
+#include "payload_compressor.h"
+#include "pkt-trace-store.h"
+#include "position-timeline.h"
+
 #include <ns3/core-module.h>
 
 #include <inttypes.h>
+#include <span>
 #include <sqlite3.h>
+#include <string>
+#include <unordered_map>
 #include <vector>
 
 namespace ns3
@@ -57,10 +69,84 @@ class V2xKpi
      * \param duration The duration of the transmitting application in seconds.
      */
     void SetTxAppDuration(double duration);
+    /**
+     * \brief Set the number of rows written per transaction to the KPI tables.
+     *
+     * By default, i.e., 0, each KPI table is written in a single transaction.
+     * A non-zero value commits every batchSize rows instead, which bounds the
+     * size of the journal for very large tables.
+     *
+     * \param batchSize The number of rows per transaction
+     */
+    void SetKpiBatchSize(uint32_t batchSize);
+    /**
+     * \brief Set the number of threads computing the KPIs in WriteKpis().
+     *
+     * With more than one thread, the trace tables are scanned concurrently,
+     * each through its own read-only connection, and PIR, PRR and
+     * throughput are computed over slices of the nodes; the KPI tables are
+     * still written by a single thread, with the same rows as with one
+     * thread. It requires read-only readers, otherwise one thread is used.
+     *
+     * \param threads The number of threads, 1 by default
+     *
+     * \see SetDbReadOnlyReaders
+     */
+    void SetKpiThreads(uint32_t threads);
+    /**
+     * \brief Switch the DB to write-ahead logging (PRAGMA journal_mode).
+     *
+     * Like the other DB settings, it must be set before the first KPI is
+     * computed or saved, since it applies when the connections are opened.
+     *
+     * \param wal True to use WAL
+     */
+    void SetDbWal(bool wal);
+    /**
+     * \brief Set the memory map size of each DB connection (PRAGMA mmap_size).
+     * \param bytes The maximum number of bytes mapped, 0 for no mmap
+     */
+    void SetDbMmapSize(uint64_t bytes);
+    /**
+     * \brief Set the page cache size of each DB connection (PRAGMA cache_size).
+     * \param kib The cache size in KiB
+     */
+    void SetDbCacheSize(uint64_t kib);
+    /**
+     * \brief Keep the temporary tables and indices in memory (PRAGMA temp_store).
+     * \param memory True to keep them in memory
+     */
+    void SetDbTempStoreMemory(bool memory);
+    /**
+     * \brief Set the synchronous level of the KPI writer (PRAGMA synchronous).
+     * \param level One of "OFF", "NORMAL", "FULL" or "EXTRA"
+     */
+    void SetDbSynchronous(std::string level);
+    /**
+     * \brief Read the trace tables through read-only DB connections.
+     *
+     * Otherwise they are read through the connection writing the KPI tables.
+     *
+     * \param readOnly True to use read-only connections
+     */
+    void SetDbReadOnlyReaders(bool readOnly);
     /**
      * \brief Write the KPIs in their respective tables in the DB.
      */
     void WriteKpis();
+    /**
+     * \brief Write the KPIs accumulated during the simulation by an
+     *        OnlineKpiEngine in their respective tables in the DB.
+     *
+     * The tables and their rows are the same as the ones of WriteKpis(),
+     * but the trace tables are not read.
+     *
+     * The range based KPIs use the initial positions of the nodes, even if
+     * position samples were added.
+     *
+     * \param engine The engine fed by the trace sinks
+     */
+    void WriteKpis(const OnlineKpiEngine& engine);
     /**
      * \brief Consider all TX links while writing the stats, e.g, throughput to the DB.
      *
@@ -73,11 +159,23 @@ class V2xKpi
      */
     void ConsiderAllTx(bool allTx);
     /**
-     * \brief Fill the map to store the IP and the initial position of each node
+     * \brief Register the IP and the initial position of each node
      * \param ip The IP of the node
      * \param pos The position of the node
      */
     void FillPosPerIpMap(std::string ip, Vector pos);
+    /**
+     * \brief Add a position of a node sampled during the simulation
+     *
+     * If positions are sampled, the range based PIR and PRR check each
+     * packet against the positions of its time instead of the initial
+     * ones. The samples must be added in time order.
+     *
+     * \param ip The IP of the node, registered with FillPosPerIpMap
+     * \param time The sample time in seconds
+     * \param pos The position of the node
+     */
+    void AddPositionSample(const std::string& ip, double time, Vector pos);
     /**
      * \brief Set the range to be considered while writing the range based
      * KPIs, e.g., PIR, PRR.
@@ -85,141 +183,198 @@ class V2xKpi
      */
     void SetRangeForV2xKpis(uint16_t range);
 
-    void SaveCryptoOverhead(uint32_t nodeId, double encryptTime, double decryptTime, std::size_t length, std::size_t declength);  
+    /**
+     * \brief Crypto overhead of a TX node measured over repeated runs
+     */
+    struct CryptoOverheadRecord
+    {
+        uint32_t nodeId;       //!< node id of the transmitter
+        TimingStats encrypt;   //!< timing statistics of the encryption
+        TimingStats decrypt;   //!< timing statistics of the decryption
+        std::size_t length;    //!< length of the ciphertext
+        std::size_t declength; //!< length of the recovered plaintext
+    };
+
+    /**
+     * \brief Save the crypto overhead of the TX nodes
+     *
+     * Every record is written to the "cryptoOverhead" table, in a single
+     * transaction on the KPI connection. The encryptionTime and
+     * decryptionTime columns hold the medians, the remaining statistics go
+     * to their own columns.
+     *
+     * \param records The per node records of all the transmitters
+     */
+    void SaveCryptoOverhead(const std::vector<CryptoOverheadRecord>& records);
+
+    /**
+     * \brief Receive side decryption result of one packet
+     */
+    struct RxCryptoRecord
+    {
+        uint32_t nodeId;       //!< node id of the receiver
+        double rxTime;         //!< reception time in seconds
+        std::string srcIp;     //!< IP address of the transmitter
+        uint32_t pktSize;      //!< size of the received payload
+        double decryptTime;    //!< wall-clock decrypt latency in seconds
+        std::size_t declength; //!< length of the recovered plaintext
+        bool valid;            //!< true if the plaintext holds well formed CAMs
+        double queueTime;      //!< time waited for the crypto processor in seconds
+        bool modelled;         //!< true if decryptTime comes from the cost model
+        uint32_t cams;         //!< number of CAMs parsed from the plaintext
+        double parseTime;      //!< wall-clock CAM parse latency in seconds
+    };
+
+    /**
+     * \brief Save the receive side decryption cost
+     *
+     * Every record is written to the "rxCryptoOverhead" table, and the
+     * records are also summed per receiving node into the "rxCryptoPerNode"
+     * table, i.e., the number of received and valid packets, the total and
+     * maximum decrypt latency, and the parsed CAMs and total parse latency
+     * (their ratio being the parse throughput) of each node.
+     *
+     * The packets of a cost model run are not decrypted, so their
+     * declength, valid, camCount and parseTime columns are NULL.
+     *
+     * \param records The per packet records of all the receivers
+     */
+    void SaveRxCryptoOverhead(const std::vector<RxCryptoRecord>& records);
+
+    /**
+     * \brief Hardware counters of one crypto call of a TX node
+     */
+    struct CryptoPerfRecord
+    {
+        uint32_t nodeId;       //!< node id of the transmitter
+        CryptoOpSample sample; //!< engine, direction, input size and counters
+    };
+
+    /**
+     * \brief Save the hardware counters of the crypto calls
+     *
+     * Every record is written to the "cryptoPerfCounters" table, one row per
+     * engine call in call order. The counters of the calls for which
+     * perf_event_open was not available are stored as NULL.
+     *
+     * \param records The per call records of all the TX nodes
+     */
+    void SaveCryptoPerfCounters(const std::vector<CryptoPerfRecord>& records);
 
-  private:
     /**
-     * \ingroup nr
-     * \brief PktTxRxData struct to store information read from a table in the
-     *        database storing the information communicated by TX/RX application
-     *        layer traces.
+     * \brief Memory used during one phase of the simulation
+     */
+    struct MemoryFootprintRecord
+    {
+        std::string phase;      //!< name of the phase, e.g., "txCrypto"
+        std::string engine;     //!< name of the crypto engine in use
+        uint64_t allocBytes;    //!< bytes requested from operator new in the phase
+        uint64_t allocCount;    //!< number of operator new calls in the phase
+        uint64_t sealPoolBytes; //!< bytes held by the SEAL memory pool at the end of the phase
+        uint64_t peakRss;       //!< peak resident set size at the end of the phase
+    };
+
+    /**
+     * \brief Save the memory footprint of the simulation phases
+     *
+     * Every record is written to the "memoryFootprint" table.
      *
+     * \param records The records of the phases, in execution order
      */
-    struct PktTxRxData
+    void SaveMemoryFootprint(const std::vector<MemoryFootprintRecord>& records);
+
+    /**
+     * \brief Compression stage result for the payload of one TX node
+     */
+    struct CompressionRecord
     {
-        /**
-         * \brief PktTxRxData constructor
-         * \param time The time value in the table
-         * \param txRx Nature of the trace, i.e., TX or RX
-         * \param nodeId The node id
-         * \param imsi The IMSI of the UE
-         * \param pktSize The packet size
-         * \param ipAddrs The IP address of the node
-         * \param pktSeq The packet sequence number
-         */
-        PktTxRxData(double time,
-                    std::string txRx,
-                    uint32_t nodeId,
-                    uint64_t imsi,
-                    uint32_t pktSize,
-                    std::string ipAddrs,
-                    uint32_t pktSeq)
-            : time(time),
-              txRx(txRx),
-              nodeId(nodeId),
-              imsi(imsi),
-              pktSize(pktSize),
-              ipAddrs(ipAddrs),
-              pktSeq(pktSeq)
-        {
-        }
-
-        double time;                                           //!< time
-        std::string txRx{""};                                  //!< tx/rx indicator
-        uint32_t nodeId{std::numeric_limits<uint32_t>::max()}; //!< node id of tx or rx node
-        uint64_t imsi{std::numeric_limits<uint64_t>::max()};   //!< IMSI of the tx and rx node
-        uint32_t pktSize;                                      //!< packet size
-        std::string ipAddrs;                                   //!< The ip address of the node.
-        uint32_t pktSeq{std::numeric_limits<uint32_t>::max()}; //!<< packet sequance number
+        uint32_t nodeId;          //!< node id of the transmitter
+        CompressionResult result; //!< sizes, compression time and bypass decision
+        double decompressTime;    //!< wall-clock decompression time in seconds
     };
 
     /**
-     * \ingroup nr
-     * \brief PsschTxData struct to store information read from a table in the
-     *        database storing the information communicated by SlPsschScheduling
-     *        trace of NrUeMac class.
+     * \brief Save the results of the compression stage
      *
+     * Every record is written to the "compressionOverhead" table, with the
+     * input and output sizes, their ratio, the compression and
+     * decompression times and whether the payload bypassed compression.
+     *
+     * \param records The per node records
+     */
+    void SaveCompressionOverhead(const std::vector<CompressionRecord>& records);
+
+  private:
+    /**
+     * \brief Row of the "avrgPir" table
      */
-    struct PsschTxData
+    struct AvrgPirRow
     {
-        /**
-         * \brief PsschTxData constructor
-         * \param frame The frame number
-         * \param subFrame The subframe number
-         * \param slot The slot number
-         * \param symStart The starting symbol index
-         * \param symLen The total number of symbol
-         * \param rbStart The starting RB index
-         * \param rbLen The total number of RBs
-         */
-        PsschTxData(uint32_t frame,
-                    uint32_t subFrame,
-                    uint16_t slot,
-                    uint16_t symStart,
-                    uint16_t symLen,
-                    uint16_t rbStart,
-                    uint16_t rbLen)
-            : frame(frame),
-              subFrame(subFrame),
-              slot(slot),
-              symStart(symStart),
-              symLen(symLen),
-              rbStart(rbStart),
-              rbLen(rbLen)
-        {
-        }
-
-        uint32_t frame{std::numeric_limits<uint32_t>::max()};    //!< The frame number;
-        uint32_t subFrame{std::numeric_limits<uint32_t>::max()}; //!< The subframe number;
-        uint16_t slot{std::numeric_limits<uint16_t>::max()};     //!< The slot number;
-        uint16_t symStart{
-            std::numeric_limits<uint16_t>::max()}; //!< Indicates the starting symbol used for
-                                                   //!< sidelink PSSCH in a slot;
-        uint16_t symLen{
-            std::numeric_limits<uint16_t>::max()}; //!< Indicates the total number of symbols
-                                                   //!< allocated for sidelink PSSCH;
-        uint16_t rbStart{
-            std::numeric_limits<uint16_t>::max()}; //!< Indicates the starting resource block
-        uint16_t rbLen{std::numeric_limits<uint16_t>::max()}; //!< Indicates the total number of
-                                                              //!< contiguous resource block
-
-        /**
-         * \brief Equal to operator for PsschTxData object
-         * \param r another instance
-         * \return true if this and r are equal, false otherwise
-         */
-        bool operator==(const PsschTxData& r) const
-        {
-            return (this->frame == r.frame && this->subFrame == r.subFrame &&
-                    this->slot == r.slot &&
-                    ((this->symStart <= r.symStart + r.symLen - 1) &&
-                     (r.symStart <= this->symStart + this->symLen - 1)) &&
-                    ((this->rbStart <= r.rbStart + r.rbLen - 1) &&
-                     (r.rbStart <= this->rbStart + this->rbLen - 1)));
-        }
+        const PktTraceStore::Link* link; //!< link of the row
+        double avrgPir;                  //!< average PIR
+        double distance;                 //!< inter TX-RX distance, 0 if range is ignored
     };
 
     /**
-     * \brief Delete the table if it already exists with same seed and run number
-     * \param seed The seed index
-     * \param run The run index
-     * \param table The name of the table
+     * \brief Row of the "thput" table
      */
-    void DeleteWhere(uint32_t seed, uint32_t run, const std::string& table);
+    struct ThputRow
+    {
+        const PktTraceStore::Link* rx; //!< a link of the RX node, for its columns
+        uint32_t txIp;                 //!< IP id of the transmitter
+        uint64_t txPkts;               //!< packets transmitted by the transmitter
+        uint64_t rxPkts;               //!< packets received from the transmitter
+        double thput;                  //!< throughput in kbps
+    };
+
+    /**
+     * \brief Row of the "avrgPrr" table
+     */
+    struct AvrgPrrRow
+    {
+        const PktTraceStore::TxNode* tx; //!< transmitter of the row
+        uint32_t numNeib;                //!< number of neighbors in range
+        double avrgPrr;                  //!< average PRR
+    };
+
+    /**
+     * \brief Packets received by one RX node, indexed for the PRR
+     */
+    struct PrrRxNode
+    {
+        uint32_t node; //!< index of the receiver in m_nodes
+        Vector pos;    //!< position of the receiver
+        std::unordered_map<uint32_t, std::vector<uint32_t>>
+            seqsPerTxIp; //!< sequence numbers received, by IP id of the transmitter
+    };
+
+    /**
+     * \brief Open the writer connection, if not open yet, into m_db
+     */
+    void OpenDb();
+    /**
+     * \brief Write the KPIs on m_kpiThreads threads
+     * \see SetKpiThreads
+     */
+    void WriteKpisParallel();
     /**
      * \brief Save the RX packet data from pktTxRx table.
      *
      * This method reads and save the entries of pktTxRx table by filtering
      * txRx column using rx key.
+     *
+     * \param reader The index of the reader connection
      */
-    void SavePktRxData();
+    void SavePktRxData(uint32_t reader = 0);
     /**
      * \brief Save the TX packet data from pktTxRx table.
      *
      * This method reads and save the entries of pktTxRx table by filtering
      * txRx column using tx key.
+     *
+     * \param reader The index of the reader connection
      */
-    void SavePktTxData();
+    void SavePktTxData(uint32_t reader = 0);
     /**
      * \brief Save average PIR
      *
@@ -228,21 +383,50 @@ class V2xKpi
      * average PIR is then written in to a new table "avrgPir" of
      * the DB. There are two things to keep in mind:
      *
-     * 1) Range based PIR computation is only valid for the scenarios with
+     * 1) Without position samples, range based PIR computation uses the
+     *    initial positions, which is only valid for the scenarios with
      *    constant velocity, i.e., inter-vehicle distance remains the same.
+     *    With them, only the intervals between two packets received while
+     *    the transmitter was in range count, and the distance is the
+     *    average over the packets received in range.
      * 2) To enable the range based PIR m_range variable value must be greater
      *    than zero; otherwise, range is ignored, i.e., all the transmitting nodes
      *    from whom the a receiving node has received more than 1 packet
      *    becomes the potential transmitter, hence, its PIR must be computed.
+     *
+     * The TxRxDistance column is the distance between the initial positions
+     * of the two nodes or, with position samples, the average distance at
+     * the packets received in range. It is 0 if the range is ignored.
      */
     void SaveAvrgPir();
+    /**
+     * \brief Compute the average PIR rows of a slice of the RX nodes
+     * \param first The index of the first RX node in m_pkts
+     * \param last One past the index of the last RX node
+     * \param rows The rows, appended in the order of the table
+     */
+    void ComputeAvrgPirRows(std::size_t first,
+                            std::size_t last,
+                            std::vector<AvrgPirRow>& rows) const;
+    /**
+     * \brief Write the average PIR rows to the "avrgPir" table
+     * \param rows The rows
+     */
+    void WriteAvrgPirRows(const std::vector<AvrgPirRow>& rows);
     /**
      * \brief Compute the average PIR
-     * \param ipTx of the transmitting node for which we are computing the PIR
-     * \param data The data to be used to compute the average PIR
-     * \return The average PIR
+     * \param rxTimes The reception times of the packets of a link
+     * \return The average PIR, -1 if less than two packets were received
      */
-    double ComputeAvrgPir(std::string ipTx, std::vector<PktTxRxData> data);
+    double ComputeAvrgPir(std::span<const double> rxTimes) const;
+    /**
+     * \brief Compute the average PIR of a link from the sampled positions
+     * \param link The link
+     * \param distance The average distance of the packets received in range
+     * \return The average PIR, -1 if less than two consecutive packets were
+     *         received in range
+     */
+    double ComputeAvrgPirInRange(const PktTraceStore::Link& link, double& distance) const;
     /**
      * \brief Save throughput
      *
@@ -252,23 +436,46 @@ class V2xKpi
      * the DB.
      */
     void SaveThput();
+    /**
+     * \brief Compute the throughput rows of a slice of the RX nodes
+     * \param first The index of the first RX node in m_pkts
+     * \param last One past the index of the last RX node
+     * \param rows The rows, appended in the order of the table
+     */
+    void ComputeThputRows(std::size_t first, std::size_t last, std::vector<ThputRow>& rows) const;
+    /**
+     * \brief Write the throughput rows to the "thput" table
+     * \param rows The rows
+     */
+    void WriteThputRows(const std::vector<ThputRow>& rows);
     /**
      * \brief Compute the throughput
      *
      * This method would fail if TX application duration is not set.
      *
-     * \param data The data to be used to compute the throughput
+     * \param pktSizes The sizes of the packets received over a link
      * \return The throughput
      *
      * \see SetTxAppDuration
      */
-    double ComputeThput(std::vector<PktTxRxData> data) const;
+    double ComputeThput(std::span<const uint32_t> pktSizes) const;
+    /**
+     * \brief Compute the throughput of the received bytes
+     * \param rxBytes The bytes received over the TX application duration
+     * \return The throughput in kbps
+     */
+    double ComputeThput(uint64_t rxBytes) const;
+    /**
+     * \brief Map the IPs of m_pkts to the nodes of m_nodes, count the
+     *        transmitted packets of each node and index the sampled positions
+     */
+    void IndexNodes();
     /**
      * \brief Get the total transmitted packets by a transmitter
-     * \param srcIpAddrs The IP of the transmitter
+     * \param srcIp The IP id of the transmitter
      * \return The total transmitted packets
      */
-    uint64_t GetTotalTxPkts(std::string srcIpAddrs);
+    uint64_t GetTotalTxPkts(uint32_t srcIp) const;
     /**
      * \brief Compute PSSCH TX stats
      *
@@ -277,8 +484,16 @@ class V2xKpi
      * overlapping PSSCH transmissions. An overlap means if the two transmissions
      * occurred on the same frame, subframe, slot, and there is a full or partial
      * overlap in frequency, i.e. RBs and in time, i.e., symbols.
+     *
+     * \see PsschOverlapIndex
      */
     void ComputePsschTxStats();
+    /**
+     * \brief Classify the PSSCH transmissions of the psschTxUeMac table
+     * \param reader The index of the reader connection
+     * \param psschTx The index the transmissions are added to
+     */
+    void ScanPsschTx(uint32_t reader, PsschOverlapIndex& psschTx);
     /**
      * \brief Save Simultaneous Pssch Tx Stats to sqlite table in the DB
      * \param totalPsschTx The total PSSCH transmissions in a simulation
@@ -292,6 +507,17 @@ class V2xKpi
      * \brief Compute PSSCH TB corruption stats
      */
     void ComputePsschTbCorruptionStats();
+    /**
+     * \brief Count the PSSCH TBs of the psschRxUePhy table
+     * \param reader The index of the reader connection
+     * \param rowCount The total received TBs
+     * \param psschSuccessCount The count of successfully decoded PSSCH
+     * \param sci2SuccessCount The count of successfully decoded SCI 2
+     */
+    void ScanPsschTbRx(uint32_t reader,
+                       uint32_t& rowCount,
+                       uint32_t& psschSuccessCount,
+                       uint32_t& sci2SuccessCount);
     /**
      * \brief Save PSSCH TB corruption stats
      * \param totalTbRx The total received TBs
@@ -309,46 +535,123 @@ class V2xKpi
      * packets to. This average PIR is then written in to a new table "avrgPrr"
      * of the DB. There are two things to keep in mind:
      *
-     * 1) Range based PRR computation is only valid for the scenarios with
+     * 1) Without position samples, range based PRR computation uses the
+     *    initial positions, which is only valid for the scenarios with
      *    constant velocity, i.e., inter-vehicle distance remains the same.
+     *    With them, each transmitted packet counts for the receivers in
+     *    range when it was transmitted, and the number of neighbors is the
+     *    average per packet, rounded.
      * 2) To enable the range based PRR m_range variable value must be greater
      *    than zero; otherwise, range is ignored, i.e., all the receiving nodes
      *    becomes the potential receivers for a transmitter.
+     *
+     * The numNieb column is the number of receiving nodes in range of the
+     * initial position of the transmitter or, with position samples, the
+     * number in range at each transmitted packet averaged over the packets
+     * and rounded to the nearest integer. It counts all the receiving nodes
+     * if the range is ignored.
      */
     void SaveAvrgPrr();
+    /**
+     * \brief Index the packets received by a slice of the RX nodes for PRR
+     * \param first The index of the first RX node in m_pkts
+     * \param last One past the index of the last RX node
+     * \param rxNodes The index of all the RX nodes, sized by the caller
+     */
+    void IndexPrrRxNodes(std::size_t first,
+                         std::size_t last,
+                         std::vector<PrrRxNode>& rxNodes) const;
+    /**
+     * \brief Compute the average PRR rows of a slice of the TX nodes
+     * \param rxNodes The index of all the RX nodes
+     * \param first The index of the first TX node in m_pkts
+     * \param last One past the index of the last TX node
+     * \param rows The rows, appended in the order of the table
+     */
+    void ComputeAvrgPrrRows(const std::vector<PrrRxNode>& rxNodes,
+                            std::size_t first,
+                            std::size_t last,
+                            std::vector<AvrgPrrRow>& rows) const;
+    /**
+     * \brief Write the average PRR rows to the "avrgPrr" table
+     * \param rows The rows
+     */
+    void WriteAvrgPrrRows(const std::vector<AvrgPrrRow>& rows);
     /**
      * \brief Compute average PRR (Packet Reception Ratio)
-     * \param txIt An iterator of the m_txDataMap pointing to the transmitter
-     *        data for which PRR is to be computed
-     * \param numNeib A variable where the total number of neighbors for a
-     *        transmitter will be stored (note, it is passed as reference)
-     * \return The average PRR value
+     * \param txSeqs The sequence numbers of the packets transmitted by the
+     *        transmitter, sorted
+     * \param rxSeqs For each neighbor in range, the sequence numbers it
+     *        received from the transmitter, sorted and without duplicates
+     * \return The average PRR value, -1 if no neighbor is in range
+     */
+    double ComputeAvrgPrr(const std::vector<uint32_t>& txSeqs,
+                          const std::vector<const std::vector<uint32_t>*>& rxSeqs) const;
+    /**
+     * \brief Compute the average PRR of a transmitter from the sampled
+     *        positions
+     * \param rxNodes The index of all the RX nodes
+     * \param rxNodeOf The index in rxNodes of each node of m_nodes, NONE if
+     *        the node received nothing
+     * \param txNode The transmitter
+     * \param numNeib The average number of receivers in range per packet
+     * \return The average PRR value, -1 if no receiver was ever in range
+     */
+    double ComputeAvrgPrrInRange(const std::vector<PrrRxNode>& rxNodes,
+                                 const std::vector<uint32_t>& rxNodeOf,
+                                 const PktTraceStore::TxNode& txNode,
+                                 uint32_t& numNeib) const;
+    /**
+     * \brief Check if the range based KPIs use the sampled positions
+     * \return true if a range is set and positions were sampled
+     */
+    bool IsMobilityAware() const;
+    /**
+     * \brief Get the sampled position of a node
+     * \param node The index of the node in m_nodes
+     * \param snapshot The snapshot of m_timeline
+     * \return The position
+     */
+    const Vector& GetSampledPosition(uint32_t node, uint32_t snapshot) const;
+    /**
+     * \brief Get the position of a node
+     * \param ip The IP of the node
+     * \return The position stored with FillPosPerIpMap
+     */
+    Vector GetPosition(const std::string& ip) const;
+    /**
+     * \brief Save average PIR from the accumulated links
+     * \param engine The online KPI engine
+     * \see SaveAvrgPir()
+     */
+    void SaveAvrgPir(const OnlineKpiEngine& engine);
+    /**
+     * \brief Save throughput from the accumulated links
+     * \param engine The online KPI engine
+     * \see SaveThput()
      */
-    double ComputeAvrgPrr(std::map<uint32_t, std::vector<PktTxRxData>>::const_iterator& txIt,
-                          uint32_t& numNeib);
+    void SaveThput(const OnlineKpiEngine& engine);
+    /**
+     * \brief Save average PRR from the accumulated links
+     * \param engine The online KPI engine
+     * \see SaveAvrgPrr()
+     */
+    void SaveAvrgPrr(const OnlineKpiEngine& engine);
 
        
 
-    /*
-     * Key 1 = Rx node id
-     * Key 2 = IP address of the transmitter this RX node received pkts from
-     * value of second map = data to compute KPIs or other stats, e.g., PIR, thput.
-     */
-    std::map<uint32_t, std::map<std::string, std::vector<PktTxRxData>>>
-        m_rxDataMap; //!< map to store the rx data of each node w.r.t its transmitters
-    /*
-     * Key = Tx node id
-     * value = data to compute KPI or other stats, e.g., total txed packets by a tx node
-     */
-    std::map<uint32_t, std::vector<PktTxRxData>>
-        m_txDataMap;             //!< map to store the tx data per transmitting node
-    sqlite3* m_db{nullptr};      //!< DB pointer
+    PktTraceStore m_pkts;        //!< rows of the pktTxRx table of this seed and run
+    sqlite3* m_db{nullptr};      //!< writer connection, owned by m_connections
     std::string m_dbPath{""};    //!< path to the DB to read
     double m_txAppDuration{0.0}; //!< The TX application duration to compute the throughput
     bool m_considerAllTx{true};  //!< Consider all TX flag for throughput computation
-    std::map<std::string, Vector> m_posPerIp; //!< Map to store position and IPs of the nodes
+    KpiNodeRegistry m_nodes;                  //!< IP, position and TX packets of the nodes
+    std::vector<uint32_t> m_nodeOfIp;         //!< Index in m_nodes of each IP id of m_pkts
+    PositionTimeline m_timeline;              //!< Positions sampled during the simulation
     std::uint16_t m_range{0};                 //!< Range in meter to be used to compute PIR and PRR
-    double m_interTxRxDistance{0.0};          //!< The inter-TX-RX distance logged for PIR
+    uint32_t m_kpiBatchSize{0};               //!< Rows per transaction of the KPI tables
+    uint32_t m_kpiThreads{1};                 //!< Threads computing the KPIs
+    KpiDbConnections m_connections;           //!< Writer and reader connections to the DB
 
     
 };